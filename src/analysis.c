@@ -0,0 +1,310 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "analysis.h"
+
+// addresses wrap around chip8's 4kb, as they do in the interpreter
+#define MEMORY_MASK 0xFFF
+
+static DoubleByte fetchOpcode(const Byte* memory, DoubleByte address)
+{
+    return (memory[address & MEMORY_MASK] << 8) | memory[(address + 1) & MEMORY_MASK];
+}
+
+// whether the interpreter executes the opcode rather than trapping on it
+static bool isKnownOpcode(DoubleByte opcode)
+{
+    switch (opcode & 0xF000)
+    {
+        case 0x0000:
+            return opcode == 0x00E0 || opcode == 0x00EE;
+
+        case 0x8000:
+            return (opcode & 0x000F) <= 0x7 || (opcode & 0x000F) == 0xE;
+
+        case 0xE000:
+            return (opcode & 0x00FF) == 0x9E || (opcode & 0x00FF) == 0xA1;
+
+        case 0xF000:
+            switch (opcode & 0x00FF)
+            {
+                case 0x07: case 0x0A: case 0x15: case 0x18: case 0x1E:
+                case 0x29: case 0x33: case 0x55: case 0x65:
+                    return true;
+
+                default:
+                    return false;
+            }
+
+        default:
+            return true;
+    }
+}
+
+// the addresses that may be executed after the instruction at address, returning how many there are
+static int findSuccessors(DoubleByte opcode, DoubleByte address, DoubleByte successors[2])
+{
+    DoubleByte next = (address + 2) & MEMORY_MASK;
+    DoubleByte skip = (address + 4) & MEMORY_MASK;
+
+    if (!isKnownOpcode(opcode))
+        return 0;
+
+    switch (opcode & 0xF000)
+    {
+        case 0x0000:
+            if (opcode == 0x00EE)
+                return 0;
+
+            successors[0] = next;
+            return 1;
+
+        case 0x1000:
+            successors[0] = opcode & 0x0FFF;
+            return 1;
+
+        // the subroutine returns to the instruction after the call
+        case 0x2000:
+            successors[0] = opcode & 0x0FFF;
+            successors[1] = next;
+            return 2;
+
+        case 0x3000: case 0x4000: case 0x5000: case 0x9000: case 0xE000:
+            successors[0] = next;
+            successors[1] = skip;
+            return 2;
+
+        // BNNN's target depends on V0
+        case 0xB000:
+            return 0;
+
+        default:
+            successors[0] = next;
+            return 1;
+    }
+}
+
+// whether the instruction at address ends its basic block, which is any instruction but those that only fall through
+static bool endsBlock(const Byte* memory, DoubleByte address)
+{
+    DoubleByte successors[2];
+    return findSuccessors(fetchOpcode(memory, address), address, successors) != 1 ||
+           successors[0] != ((address + 2) & MEMORY_MASK);
+}
+
+// whether the instruction after the one at address is part of the same basic block
+static bool continuesBlock(const chip8Analysis* analysis, const Byte* memory, DoubleByte address)
+{
+    DoubleByte next = (address + 2) & MEMORY_MASK;
+
+    return !endsBlock(memory, address) && (analysis->flags[next] & ANALYSIS_INSTRUCTION) != 0 &&
+           (analysis->flags[next] & ANALYSIS_BLOCK_START) == 0;
+}
+
+static void addFinding(chip8Analysis* analysis, chip8FindingKind kind, DoubleByte address, DoubleByte opcode, DoubleByte target)
+{
+    if (analysis->numOfFindings == MAX_ANALYSIS_FINDINGS)
+    {
+        analysis->findingsTruncated = true;
+        return;
+    }
+
+    chip8Finding* finding = &analysis->findings[analysis->numOfFindings++];
+    finding->kind    = kind;
+    finding->address = address;
+    finding->opcode  = opcode;
+    finding->target  = target;
+}
+
+// marks memory written by the instruction at address, reporting it if it writes over code
+static void markWritten(chip8Analysis* analysis, DoubleByte address, DoubleByte opcode, DoubleByte start, int length)
+{
+    bool reported = false;
+
+    for (int offset = 0; offset < length; offset++)
+    {
+        DoubleByte written = (start + offset) & MEMORY_MASK;
+        analysis->flags[written] |= ANALYSIS_WRITTEN;
+
+        if (!reported && (analysis->flags[written] & ANALYSIS_CODE) != 0)
+        {
+            addFinding(analysis, FINDING_SELF_MODIFYING, address, opcode, written);
+            reported = true;
+        }
+    }
+}
+
+// follows the index register through a basic block, marking the sprites drawn and the memory written
+static void analyseBlock(chip8Analysis* analysis, const Byte* memory, DoubleByte blockStart)
+{
+    // the value of the index register, or -1 while it isn't known
+    int indexRegister = -1;
+
+    DoubleByte address = blockStart;
+    for (int instruction = 0; instruction < 4096; instruction++)
+    {
+        DoubleByte opcode = fetchOpcode(memory, address);
+
+        if ((opcode & 0xF000) == 0xA000)
+        {
+            indexRegister = opcode & 0x0FFF;
+        }
+        else if ((opcode & 0xF000) == 0xD000 && indexRegister >= 0)
+        {
+            for (int row = 0; row < (opcode & 0x000F); row++)
+                analysis->flags[(indexRegister + row) & MEMORY_MASK] |= ANALYSIS_SPRITE;
+        }
+        else if ((opcode & 0xF0FF) == 0xF033 && indexRegister >= 0)
+        {
+            markWritten(analysis, address, opcode, (DoubleByte)indexRegister, 3);
+        }
+        else if ((opcode & 0xF0FF) == 0xF055 && indexRegister >= 0)
+        {
+            markWritten(analysis, address, opcode, (DoubleByte)indexRegister, ((opcode & 0x0F00) >> 8) + 1);
+
+            // instances with QUIRK_LOAD_STORE_ADVANCE_I move the index register past what was stored
+            indexRegister = -1;
+        }
+        else if ((opcode & 0xF0FF) == 0xF01E || (opcode & 0xF0FF) == 0xF029 || (opcode & 0xF0FF) == 0xF065)
+        {
+            indexRegister = -1;
+        }
+
+        if (!continuesBlock(analysis, memory, address))
+            break;
+
+        address = (address + 2) & MEMORY_MASK;
+    }
+}
+
+void analyseChip8(chip8Analysis* analysis, const Byte* memory, DoubleByte entryPoint)
+{
+    memset(analysis, 0, sizeof(chip8Analysis));
+
+    // every reachable instruction is queued once
+    DoubleByte worklist[4096];
+    bool queued[4096] = { false };
+    int numOfQueued = 0;
+
+    entryPoint &= MEMORY_MASK;
+    worklist[numOfQueued++] = entryPoint;
+    queued[entryPoint] = true;
+    analysis->flags[entryPoint] |= ANALYSIS_BLOCK_START;
+
+    while (numOfQueued > 0)
+    {
+        DoubleByte address = worklist[--numOfQueued];
+        DoubleByte opcode  = fetchOpcode(memory, address);
+
+        analysis->flags[address] |= ANALYSIS_INSTRUCTION | ANALYSIS_CODE;
+        analysis->flags[(address + 1) & MEMORY_MASK] |= ANALYSIS_CODE;
+        analysis->numOfInstructions++;
+
+        if (!isKnownOpcode(opcode))
+            addFinding(analysis, FINDING_UNKNOWN_OPCODE, address, opcode, 0);
+        else if ((opcode & 0xF000) == 0xB000)
+            addFinding(analysis, FINDING_UNRESOLVED_JUMP, address, opcode, opcode & 0x0FFF);
+
+        DoubleByte successors[2];
+        int numOfSuccessors = findSuccessors(opcode, address, successors);
+        bool leadsBlocks = endsBlock(memory, address);
+
+        for (int successor = 0; successor < numOfSuccessors; successor++)
+        {
+            if (leadsBlocks)
+                analysis->flags[successors[successor]] |= ANALYSIS_BLOCK_START;
+
+            if (!queued[successors[successor]])
+            {
+                queued[successors[successor]] = true;
+                worklist[numOfQueued++] = successors[successor];
+            }
+        }
+    }
+
+    // the blocks are only known once every instruction has been found
+    for (int address = 0; address < 4096; address++)
+    {
+        if ((analysis->flags[address] & (ANALYSIS_INSTRUCTION | ANALYSIS_BLOCK_START)) == (ANALYSIS_INSTRUCTION | ANALYSIS_BLOCK_START))
+        {
+            analysis->numOfBlocks++;
+            analyseBlock(analysis, memory, (DoubleByte)address);
+        }
+    }
+}
+
+DoubleByte findChip8BlockEnd(const chip8Analysis* analysis, const Byte* memory, DoubleByte blockStart)
+{
+    DoubleByte address = blockStart & MEMORY_MASK;
+
+    for (int instruction = 0; instruction < 4096 && continuesBlock(analysis, memory, address); instruction++)
+        address = (address + 2) & MEMORY_MASK;
+
+    return (address + 2) & MEMORY_MASK;
+}
+
+int formatChip8Instruction(DoubleByte opcode, char* buffer, int bufferSize)
+{
+    int x   = (opcode & 0x0F00) >> 8;
+    int y   = (opcode & 0x00F0) >> 4;
+    int n   = opcode & 0x000F;
+    int nn  = opcode & 0x00FF;
+    int nnn = opcode & 0x0FFF;
+
+    if (!isKnownOpcode(opcode))
+        return snprintf(buffer, bufferSize, "???");
+
+    switch (opcode & 0xF000)
+    {
+        case 0x0000: return snprintf(buffer, bufferSize, opcode == 0x00E0 ? "CLS" : "RET");
+        case 0x1000: return snprintf(buffer, bufferSize, "JP   %.3X", nnn);
+        case 0x2000: return snprintf(buffer, bufferSize, "CALL %.3X", nnn);
+        case 0x3000: return snprintf(buffer, bufferSize, "SE   V%X, %.2X", x, nn);
+        case 0x4000: return snprintf(buffer, bufferSize, "SNE  V%X, %.2X", x, nn);
+        case 0x5000: return snprintf(buffer, bufferSize, "SE   V%X, V%X", x, y);
+        case 0x6000: return snprintf(buffer, bufferSize, "LD   V%X, %.2X", x, nn);
+        case 0x7000: return snprintf(buffer, bufferSize, "ADD  V%X, %.2X", x, nn);
+        case 0x9000: return snprintf(buffer, bufferSize, "SNE  V%X, V%X", x, y);
+        case 0xA000: return snprintf(buffer, bufferSize, "LD   I, %.3X", nnn);
+        case 0xB000: return snprintf(buffer, bufferSize, "JP   V0, %.3X", nnn);
+        case 0xC000: return snprintf(buffer, bufferSize, "RND  V%X, %.2X", x, nn);
+        case 0xD000: return snprintf(buffer, bufferSize, "DRW  V%X, V%X, %X", x, y, n);
+        case 0xE000: return snprintf(buffer, bufferSize, "%s V%X", nn == 0x9E ? "SKP " : "SKNP", x);
+
+        case 0x8000:
+        {
+            static const char* operations[16] = { "LD  ", "OR  ", "AND ", "XOR ", "ADD ", "SUB ", "SHR ", "SUBN",
+                                                  NULL, NULL, NULL, NULL, NULL, NULL, "SHL ", NULL };
+            return snprintf(buffer, bufferSize, "%s V%X, V%X", operations[n], x, y);
+        }
+
+        default:
+        {
+            switch (nn)
+            {
+                case 0x07: return snprintf(buffer, bufferSize, "LD   V%X, DT", x);
+                case 0x0A: return snprintf(buffer, bufferSize, "LD   V%X, K", x);
+                case 0x15: return snprintf(buffer, bufferSize, "LD   DT, V%X", x);
+                case 0x18: return snprintf(buffer, bufferSize, "LD   ST, V%X", x);
+                case 0x1E: return snprintf(buffer, bufferSize, "ADD  I, V%X", x);
+                case 0x29: return snprintf(buffer, bufferSize, "LD   F, V%X", x);
+                case 0x33: return snprintf(buffer, bufferSize, "LD   B, V%X", x);
+                case 0x55: return snprintf(buffer, bufferSize, "LD   [I], V%X", x);
+                default:   return snprintf(buffer, bufferSize, "LD   V%X, [I]", x);
+            }
+        }
+    }
+}
+
+const char* describeChip8Finding(chip8FindingKind kind)
+{
+    switch (kind)
+    {
+        case FINDING_UNRESOLVED_JUMP: return "unresolved jump";
+        case FINDING_UNKNOWN_OPCODE:  return "unknown opcode";
+        case FINDING_SELF_MODIFYING:  return "self modifying code";
+    }
+
+    return "unknown finding";
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "chip8.h"
+
+/*
+    static analysis of a chip8 program. code is found by walking every path from the entry point through jumps,
+    calls, returns and both outcomes of skips. the targets of BNNN depend on V0, so those jumps are recorded as
+    unresolved and not followed. within each basic block the value of the index register is tracked from ANNN, so
+    that DXYN marks the sprite it draws and FX33 and FX55 mark the memory they write. a write that lands on code is
+    reported as self modifying code. writes through an index register that isn't known (e.g. after FX1E) aren't
+    tracked, so a program without findings can still modify itself
+*/
+
+// what is known about each byte of memory
+#define ANALYSIS_CODE        0x01 // part of a reachable instruction
+#define ANALYSIS_INSTRUCTION 0x02 // the first byte of a reachable instruction
+#define ANALYSIS_BLOCK_START 0x04 // the first instruction of a basic block
+#define ANALYSIS_SPRITE      0x08 // drawn as a sprite
+#define ANALYSIS_WRITTEN     0x10 // written by FX33 or FX55
+
+#define MAX_ANALYSIS_FINDINGS 256
+
+typedef enum
+{
+    FINDING_UNRESOLVED_JUMP, // a BNNN, whose targets aren't known
+    FINDING_UNKNOWN_OPCODE,  // an opcode that would trap with CHIP8_TRAP_UNKNOWN_OPCODE if it were executed
+    FINDING_SELF_MODIFYING   // an instruction that writes over code (target is the first code byte it writes)
+} chip8FindingKind;
+
+struct chip8Finding
+{
+    chip8FindingKind kind;
+    DoubleByte address;
+    DoubleByte opcode;
+    DoubleByte target;
+}; typedef struct chip8Finding chip8Finding;
+
+struct chip8Analysis
+{
+    Byte flags[4096];
+
+    chip8Finding findings[MAX_ANALYSIS_FINDINGS];
+    int numOfFindings;
+    bool findingsTruncated; // more findings were found than fit
+
+    int numOfInstructions;
+    int numOfBlocks;
+}; typedef struct chip8Analysis chip8Analysis;
+
+void analyseChip8(chip8Analysis* analysis, const Byte* memory, DoubleByte entryPoint);
+
+// the address just past the end of the basic block starting at the given address
+DoubleByte findChip8BlockEnd(const chip8Analysis* analysis, const Byte* memory, DoubleByte blockStart);
+
+// writes the instruction in assembler syntax, returning the number of characters written
+int formatChip8Instruction(DoubleByte opcode, char* buffer, int bufferSize);
+
+const char* describeChip8Finding(chip8FindingKind kind);
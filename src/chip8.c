@@ -4,6 +4,7 @@
 #include <time.h>
 
 #include "chip8.h"
+#include "platform.h"
 
 // constants
 const DoubleByte PROGRAM_MEMORY_ADDRESS = 0x200;   // chip8's programs start at an offset of 0x200 
@@ -18,6 +19,12 @@ const Byte SCREEN_HEIGHT       = 32; // chip8 has graphics that support 32 pixel
 
 #define FONTSET_SIZE 0x50
 
+// every memory access is masked with this so that a misbehaving ROM can never reach outside of chip8's 4kb
+#define MEMORY_MASK 0xFFF
+
+// how many instructions runChip8Cycles executes between checks of the clock against the deadline
+#define DEADLINE_CHECK_INTERVAL 1024
+
 /*
     the following array represents chip8's "fontset"
     this is a construct that allows for the software to draw characters to the screen via
@@ -94,8 +101,16 @@ void initChip8(chip8* chip8)
     chip8->soundTimer = 0; // reset sound timer
     chip8->delayTimer = 0; // reset delay timer
 
-    // seed the random function from stdlib.h
-    srand(time(NULL));
+    // clear any trap, and give the instance an unlimited budget
+    chip8->trap              = CHIP8_OK;
+    chip8->trapAddress       = 0;
+    chip8->trapOpcode        = 0;
+    chip8->instructionBudget = CHIP8_UNLIMITED_BUDGET;
+    chip8->deadline          = 0.0;
+    chip8->quirks            = 0;
+
+    // seed this instance's random number generator (it must never be 0)
+    chip8->randomState = (unsigned int)time(NULL) | 1;
 }
 
 // loads a ROM file into the memory of the chip8
@@ -118,53 +133,57 @@ bool loadChip8(const char* romdir, chip8* chip8)
     fseek(romFile, 0L, SEEK_END);
 
     // ask for the position when at the end of the file
-    int romSize = ftell(romFile);
+    long romSize = ftell(romFile);
 
     // seek back to the beginning of the file
     rewind(romFile);
 
     // see if the size of the ROM is too big to fit into chip8's memory (of 4k)
-    if (4096 - 0x200 < romSize) 
-    {
-        printf("ROM is too big to load into chip8's 4k memory");
-        return false;
-    }
-
-    // read in the data in the rom into a buffer (which will later by stored into our memory buffer)
-    Byte* romBuffer = (Byte*)malloc(sizeof(Byte) * romSize);
-    if (romBuffer == NULL)
+    if (romSize < 0 || 4096 - 0x200 < romSize)
     {
-        printf("Error allocating the memory for the ROM buffer");
+        printf("ROM is too big to load into chip8's 4k memory\n");
+        fclose(romFile);
         return false;
     }
 
-    // read the ROM's data into the rom buffer
-    fread(romBuffer, sizeof(Byte), romSize, romFile);
+    // read the ROM's data straight into the memory for the program, which starts at 0x200
+    size_t bytesRead = fread(&chip8->memory[0x200], sizeof(Byte), (size_t)romSize, romFile);
+    fclose(romFile);
 
-    // set the data in the chip8's memory
-    for (int addr = 0x200; addr < 0x200 + romSize; addr++)
+    if (bytesRead != (size_t)romSize)
     {
-        // the memory for the program starts at 0x200
-        chip8->memory[addr] = romBuffer[addr - 0x200];
+        printf("Error reading the ROM file!\n");
+        return false;
     }
-    
-    // cleanup 
-    fclose(romFile);
-    free(romBuffer);
 
     printf("Successfully loaded ROM!\n");
     return true;
 }
 
-// emulates a single cpu cycle
-void emulateChip8Cycle(chip8* chip8)
+// records a trap for the instruction at the program counter (which is left pointing at the faulting instruction)
+static chip8Status trapChip8(chip8* chip8, chip8Status trap)
+{
+    chip8->trap        = trap;
+    chip8->trapAddress = chip8->programCounter & MEMORY_MASK;
+    chip8->trapOpcode  = (chip8->memory[chip8->trapAddress] << 8) | chip8->memory[(chip8->trapAddress + 1) & MEMORY_MASK];
+
+    return trap;
+}
+
+// emulates a single cpu cycle, returning the trap that stopped the instance (or CHIP8_OK)
+chip8Status emulateChip8Cycle(chip8* chip8)
 {
+    // a trapped instance stays stopped until it is initialized again
+    if (chip8->trap != CHIP8_OK)
+        return chip8->trap;
+
     /*
         fetch the opcode using the current address that the program counter is pointing at. because the
         opcodes are formatted according to the little endian standard, we need to shift the first byte 
         that the program counter is looking at one byte to the left, and then read in the next byte as well
     */
-    chip8->opcode = (chip8->memory[chip8->programCounter] << 8) | chip8->memory[chip8->programCounter + 1];
+    chip8->programCounter &= MEMORY_MASK;
+    chip8->opcode = (chip8->memory[chip8->programCounter] << 8) | chip8->memory[(chip8->programCounter + 1) & MEMORY_MASK];
 
     /* 
         decoding the opcode:
@@ -194,6 +213,9 @@ void emulateChip8Cycle(chip8* chip8)
 
                 case 0x00EE: // opcode 00EE: return from subroutine, meaning that we need to return the program counter to the address stored on the stack
                 {
+                    if (chip8->stackPointer == 0)
+                        return trapChip8(chip8, CHIP8_TRAP_STACK_UNDERFLOW);
+
                     // decrement the stack pointer
                     chip8->stackPointer--;
 
@@ -206,8 +228,7 @@ void emulateChip8Cycle(chip8* chip8)
 
                 default:
                 {
-                    printf("Unknown opcode %.4X\n", chip8->opcode);
-                    exit(5);
+                    return trapChip8(chip8, CHIP8_TRAP_UNKNOWN_OPCODE);
                 }
             }
 
@@ -223,6 +244,9 @@ void emulateChip8Cycle(chip8* chip8)
 
         case 0x2000: // opcode 2NNN: call subroutine at address NNN
         {
+            if (chip8->stackPointer >= NUM_OF_STACK_LEVELS)
+                return trapChip8(chip8, CHIP8_TRAP_STACK_OVERFLOW);
+
             // store the current memory address into the stack at its current level, then increment the stack pointer
             chip8->stack[chip8->stackPointer] = chip8->programCounter;
 
@@ -308,6 +332,10 @@ void emulateChip8Cycle(chip8* chip8)
                 case 0x1: // opcode 8XY1: sets registers[x] to registers[x] | registers[y]
                 {
                     chip8->registers[(chip8->opcode & 0x0F00) >> 8] |= chip8->registers[(chip8->opcode & 0x00F0) >> 4];
+
+                    if (chip8->quirks & QUIRK_LOGIC_RESETS_VF)
+                        chip8->carryRegister = 0;
+
                     chip8->programCounter += 2;
                     break;
                 }
@@ -315,6 +343,10 @@ void emulateChip8Cycle(chip8* chip8)
                 case 0x2: // opcode 8XY2: sets registers[x] to registers[x] & registers[y]
                 {
                     chip8->registers[(chip8->opcode & 0x0F00) >> 8] &= chip8->registers[(chip8->opcode & 0x00F0) >> 4];
+
+                    if (chip8->quirks & QUIRK_LOGIC_RESETS_VF)
+                        chip8->carryRegister = 0;
+
                     chip8->programCounter += 2;
                     break;
                 }
@@ -322,20 +354,22 @@ void emulateChip8Cycle(chip8* chip8)
                 case 0x3: // opcode 8XY3: sets registers[x] to registers[x] ^ registers[y]
                 {
                     chip8->registers[(chip8->opcode & 0x0F00) >> 8] ^= chip8->registers[(chip8->opcode & 0x00F0) >> 4];
+
+                    if (chip8->quirks & QUIRK_LOGIC_RESETS_VF)
+                        chip8->carryRegister = 0;
+
                     chip8->programCounter += 2;
                     break;
                 }
 
                 case 0x4: // opcode 8XY4: sets registers[x] to registers[x] + registers[y], and sets the carry register to 1 when there's a carry (indicating an overflow), or 0 otherwise
                 {
-                    chip8->carryRegister = 0;
-                    chip8->registers[(chip8->opcode & 0x0F00) >> 8] += chip8->registers[(chip8->opcode & 0x00F0) >> 4];
+                    // add the registers in a wider type, so that the overflow can be seen before the result is stored
+                    DoubleByte sum = chip8->registers[(chip8->opcode & 0x0F00) >> 8] + chip8->registers[(chip8->opcode & 0x00F0) >> 4];
+                    chip8->registers[(chip8->opcode & 0x0F00) >> 8] = sum & 0xFF;
 
-                    // if registers[y] is greater than [255 (max value a register can store) minus registers[x]], then set the carry register to 1 (to indicate an overflow)
-                    if (chip8->registers[(chip8->opcode & 0x00F0) >> 4] > 0xFF - chip8->registers[(chip8->opcode & 0x0F00) >> 8])
-                    {
-                        chip8->carryRegister = 1;
-                    }
+                    // if the sum is greater than 255 (max value a register can store), then set the carry register to 1 (to indicate an overflow)
+                    chip8->carryRegister = sum > 0xFF ? 1 : 0;
 
                     chip8->programCounter += 2;
                     break;
@@ -359,9 +393,12 @@ void emulateChip8Cycle(chip8* chip8)
 
                 case 0x6: // opcode 8XY6: sets registers[x] to registers[x] >> 1, and sets the carry bit to the least significant bit of registers[x]
                 {
-                    // get the least significant digit of registers[x]
-                    chip8->carryRegister = chip8->registers[(chip8->opcode & 0x0F00) >> 8] & 1;
-                    chip8->registers[(chip8->opcode & 0x0F00) >> 8] >>= 1;
+                    // with QUIRK_SHIFT_USES_VY, registers[y] is shifted instead
+                    Byte shifted = (chip8->quirks & QUIRK_SHIFT_USES_VY) ? chip8->registers[(chip8->opcode & 0x00F0) >> 4] : chip8->registers[(chip8->opcode & 0x0F00) >> 8];
+
+                    // get the least significant digit of the shifted register
+                    chip8->carryRegister = shifted & 1;
+                    chip8->registers[(chip8->opcode & 0x0F00) >> 8] = shifted >> 1;
                     
                     chip8->programCounter += 2;
                     break;
@@ -385,9 +422,12 @@ void emulateChip8Cycle(chip8* chip8)
 
                 case 0xE: // opcode 8XYE: sets registers[x] to registers[x] << 1, and sets the carry bit to the most significant bit of registers[x]
                 {
-                    // get the most significant digit of registers[x]
-                    chip8->carryRegister = chip8->registers[(chip8->opcode & 0x0F00) >> 8] >> 7;
-                    chip8->registers[(chip8->opcode & 0x0F00) >> 8] <<= 1;
+                    // with QUIRK_SHIFT_USES_VY, registers[y] is shifted instead
+                    Byte shifted = (chip8->quirks & QUIRK_SHIFT_USES_VY) ? chip8->registers[(chip8->opcode & 0x00F0) >> 4] : chip8->registers[(chip8->opcode & 0x0F00) >> 8];
+
+                    // get the most significant digit of the shifted register
+                    chip8->carryRegister = shifted >> 7;
+                    chip8->registers[(chip8->opcode & 0x0F00) >> 8] = shifted << 1;
                     
                     chip8->programCounter += 2;
                     break;
@@ -395,8 +435,7 @@ void emulateChip8Cycle(chip8* chip8)
 
                 default:
                 {
-                    printf("Unknown opcode %.4X\n", chip8->opcode);
-                    exit(5);
+                    return trapChip8(chip8, CHIP8_TRAP_UNKNOWN_OPCODE);
                 }
             }
 
@@ -423,15 +462,21 @@ void emulateChip8Cycle(chip8* chip8)
             break;
         }
 
-        case 0xB000: // opcode BNNN: jump to the address NNN plus register[0]
+        case 0xB000: // opcode BNNN: jump to the address NNN plus register[0] (or, with QUIRK_JUMP_USES_VX, to XNN plus registers[x])
         {
-            chip8->programCounter = chip8->opcode & 0x0FFF + chip8->registers[0];
+            int offsetRegister = (chip8->quirks & QUIRK_JUMP_USES_VX) ? (chip8->opcode & 0x0F00) >> 8 : 0;
+            chip8->programCounter = ((chip8->opcode & 0x0FFF) + chip8->registers[offsetRegister]) & MEMORY_MASK;
             break;
         }
 
-        case 0xC000: // opcode CXNN: set registers[x] to rand() & NN
+        case 0xC000: // opcode CXNN: set registers[x] to a random number & NN
         {
-            chip8->registers[(chip8->opcode & 0x0F00) >> 8] = rand() & (chip8->opcode & 0xFF);
+            // each instance has its own xorshift generator, so that copies of an instance behave identically
+            chip8->randomState ^= chip8->randomState << 13;
+            chip8->randomState ^= chip8->randomState >> 17;
+            chip8->randomState ^= chip8->randomState << 5;
+
+            chip8->registers[(chip8->opcode & 0x0F00) >> 8] = chip8->randomState & (chip8->opcode & 0xFF);
             chip8->programCounter += 2;
             break;
         }
@@ -450,9 +495,10 @@ void emulateChip8Cycle(chip8* chip8)
             // set the carry register by default to 0
             chip8->carryRegister = 0;
 
-            // note that for xpos and ypos, we modulo them by the width and height respectively as to prevent the sprites from being drawn wrapped around the screen
-            DoubleByte xpos = chip8->registers[(chip8->opcode & 0x0F00) >> 8];
-            DoubleByte ypos = chip8->registers[(chip8->opcode & 0x00F0) >> 4];
+            // note that for xpos and ypos, we modulo them by the width and height respectively so that the sprite starts on the screen.
+            // the sprite itself is then clipped at the edges, unless QUIRK_SPRITES_WRAP has it drawn wrapped around the screen
+            DoubleByte xpos = chip8->registers[(chip8->opcode & 0x0F00) >> 8] % SCREEN_WIDTH;
+            DoubleByte ypos = chip8->registers[(chip8->opcode & 0x00F0) >> 4] % SCREEN_HEIGHT;
             DoubleByte height = chip8->opcode & 0x000F;
             DoubleByte spriteRowData;
 
@@ -460,13 +506,13 @@ void emulateChip8Cycle(chip8* chip8)
             for (int row = 0; row < height; row++)
             {
                 // fetch the pixel for the given row
-                spriteRowData = chip8->memory[chip8->indexRegister + row];
+                spriteRowData = chip8->memory[(chip8->indexRegister + row) & MEMORY_MASK];
 
                 // iterate through each bit of the pixel
                 for (int column = 0; column < 8; column++)
                 {
                     // if we are trying to draw the pixel off the screen, disallow it
-                    if (xpos + column > SCREEN_WIDTH || ypos + row > SCREEN_HEIGHT)
+                    if (!(chip8->quirks & QUIRK_SPRITES_WRAP) && (xpos + column >= SCREEN_WIDTH || ypos + row >= SCREEN_HEIGHT))
                     {
                         break;
                     }
@@ -474,15 +520,17 @@ void emulateChip8Cycle(chip8* chip8)
                     // check if the current evaluated pixel is set (note that 0x80 = 128, and looks like 0b1000 0000)
                     if ((spriteRowData & (0x80 >> column)) != 0)
                     {
+                        // the index of the pixel in the array (of 2048 total pixels), which only wraps with QUIRK_SPRITES_WRAP
+                        int pixel = (xpos + column) % SCREEN_WIDTH + ((ypos + row) % SCREEN_HEIGHT) * 64;
+
                         // check if the pixel on the display is set
-                        // xpos + column + (ypos + row) * 64 gets the index of the pixel in the array (of 2048 total pixels)
-                        if (chip8->pixels[xpos + column + ((ypos + row) * 64)] == 1)
+                        if (chip8->pixels[pixel] == 1)
                         {
                             chip8->carryRegister = 1;
                         }
 
                         // set the pixel value using xor
-                        chip8->pixels[xpos + column + ((ypos + row) * 64)] ^= 1;
+                        chip8->pixels[pixel] ^= 1;
                     }
                 }
             }
@@ -498,7 +546,7 @@ void emulateChip8Cycle(chip8* chip8)
             {
                 case 0x9E: // opcode EX9E: skips the next instruction if they key stored in registers[x] is pressed
                 {
-                    if (chip8->keys[chip8->registers[(chip8->opcode & 0x0F00) >> 8]])
+                    if (chip8->keys[chip8->registers[(chip8->opcode & 0x0F00) >> 8] & 0xF])
                     {
                         chip8->programCounter += 4;
                         break;
@@ -510,7 +558,7 @@ void emulateChip8Cycle(chip8* chip8)
 
                 case 0xA1: // opcode EXA1: skips the next instruction if the key stored in register x is not pressed
                 {
-                    if (!chip8->keys[chip8->registers[(chip8->opcode & 0x0F00) >> 8]])
+                    if (!chip8->keys[chip8->registers[(chip8->opcode & 0x0F00) >> 8] & 0xF])
                     {
                         chip8->programCounter += 4;
                         break;
@@ -519,6 +567,11 @@ void emulateChip8Cycle(chip8* chip8)
                     chip8->programCounter += 2;
                     break;
                 }
+
+                default:
+                {
+                    return trapChip8(chip8, CHIP8_TRAP_UNKNOWN_OPCODE);
+                }
             }
             
             break;
@@ -554,13 +607,16 @@ void emulateChip8Cycle(chip8* chip8)
 
                             // store the key that is pressed in registers[x]
                             chip8->registers[(chip8->opcode & 0x0F00) >> 8] = key;
+
+                            // only the first key that is pressed counts
+                            break;
                         }
                     }
 
                     // if there was no key pressed, return immediately until the next cycle is emulated. returning immediately 
                     // means that the timers will not be updated
                     if (!keyPressed)
-                        return;
+                        return CHIP8_OK;
 
                     break;
                 }
@@ -601,9 +657,9 @@ void emulateChip8Cycle(chip8* chip8)
                 */
                 case 0x33:
                 {
-                    chip8->memory[chip8->indexRegister]     = chip8->registers[(chip8->opcode & 0x0F00) >> 8] / 100;
-                    chip8->memory[chip8->indexRegister + 1] = (chip8->registers[(chip8->opcode & 0x0F00) >> 8] / 10) % 10;
-                    chip8->memory[chip8->indexRegister + 2] = chip8->registers[(chip8->opcode & 0x0F00) >> 8] % 10;
+                    chip8->memory[chip8->indexRegister & MEMORY_MASK]       = chip8->registers[(chip8->opcode & 0x0F00) >> 8] / 100;
+                    chip8->memory[(chip8->indexRegister + 1) & MEMORY_MASK] = (chip8->registers[(chip8->opcode & 0x0F00) >> 8] / 10) % 10;
+                    chip8->memory[(chip8->indexRegister + 2) & MEMORY_MASK] = chip8->registers[(chip8->opcode & 0x0F00) >> 8] % 10;
 
                     chip8->programCounter += 2;
                     break;
@@ -613,9 +669,12 @@ void emulateChip8Cycle(chip8* chip8)
                 {
                     for (int r = 0; r <= (chip8->opcode & 0x0F00) >> 8; r++)
                     {
-                        chip8->memory[chip8->indexRegister + r] = chip8->registers[r];
+                        chip8->memory[(chip8->indexRegister + r) & MEMORY_MASK] = chip8->registers[r];
                     }
 
+                    if (chip8->quirks & QUIRK_LOAD_STORE_ADVANCE_I)
+                        chip8->indexRegister += ((chip8->opcode & 0x0F00) >> 8) + 1;
+
                     chip8->programCounter += 2;
                     break;
                 }
@@ -624,23 +683,53 @@ void emulateChip8Cycle(chip8* chip8)
                 {
                     for (int r = 0; r <= (chip8->opcode & 0x0F00) >> 8; r++)
                     {
-                        chip8->registers[r] = chip8->memory[chip8->indexRegister + r];
+                        chip8->registers[r] = chip8->memory[(chip8->indexRegister + r) & MEMORY_MASK];
                     }
 
+                    if (chip8->quirks & QUIRK_LOAD_STORE_ADVANCE_I)
+                        chip8->indexRegister += ((chip8->opcode & 0x0F00) >> 8) + 1;
+
                     chip8->programCounter += 2;
                     break;
                 }
 
                 default: 
                 {
-                    printf("Unknown opcode [0xF000]: 0x%X\n", chip8->opcode);
-                    exit(5);
+                    return trapChip8(chip8, CHIP8_TRAP_UNKNOWN_OPCODE);
                 }
             }
             
             break;
         }
     }
+
+    return CHIP8_OK;
+}
+
+/*
+    runs up to the given number of cycles under the watchdog, stopping early if the instance traps. each
+    instruction is charged against the instance's instruction budget, and the clock is compared against its
+    deadline every DEADLINE_CHECK_INTERVAL instructions (so that an instance can't hold its thread forever)
+*/
+chip8Status runChip8Cycles(chip8* chip8, unsigned long long cycles)
+{
+    for (unsigned long long cycle = 0; cycle < cycles; cycle++)
+    {
+        if (chip8->instructionBudget == 0)
+            return trapChip8(chip8, CHIP8_TRAP_BUDGET_EXCEEDED);
+
+        if (chip8->deadline != 0.0 && cycle % DEADLINE_CHECK_INTERVAL == 0 && getTimeMilliseconds() >= chip8->deadline)
+            return trapChip8(chip8, CHIP8_TRAP_DEADLINE_PASSED);
+
+        if (chip8->instructionBudget != CHIP8_UNLIMITED_BUDGET)
+            chip8->instructionBudget--;
+
+        chip8Status status = emulateChip8Cycle(chip8);
+        if (status != CHIP8_OK)
+            return status;
+    }
+
+    return chip8->trap;
 }
 
 // this function will only be called once every 1/60th of a second and will update the 
@@ -657,4 +746,20 @@ void updateChip8Timers(chip8* chip8)
 
         chip8->soundTimer--;
     }
-}
\ No newline at end of file
+}
+
+// returns a human readable description of a trap
+const char* describeChip8Status(chip8Status status)
+{
+    switch (status)
+    {
+        case CHIP8_OK:                   return "ok";
+        case CHIP8_TRAP_UNKNOWN_OPCODE:  return "unknown opcode";
+        case CHIP8_TRAP_STACK_OVERFLOW:  return "stack overflow";
+        case CHIP8_TRAP_STACK_UNDERFLOW: return "stack underflow";
+        case CHIP8_TRAP_BUDGET_EXCEEDED: return "instruction budget exceeded";
+        case CHIP8_TRAP_DEADLINE_PASSED: return "deadline passed";
+    }
+
+    return "unknown trap";
+}
@@ -1,6 +1,36 @@
+#pragma once
+
+#include <stdbool.h>
+
 typedef unsigned short DoubleByte;
 typedef unsigned char Byte;
 
+// the result of emulating an instruction. anything other than CHIP8_OK is a trap, after which the instance will not
+// execute any more instructions until it is initialized again (or, for the watchdog's traps, until the caller
+// extends the budget or deadline and sets the trap back to CHIP8_OK)
+typedef enum
+{
+    CHIP8_OK,
+    CHIP8_TRAP_UNKNOWN_OPCODE,  // the opcode is not one of chip8's 35 instructions
+    CHIP8_TRAP_STACK_OVERFLOW,  // 2NNN was called with all 16 levels of the stack in use
+    CHIP8_TRAP_STACK_UNDERFLOW, // 00EE was called with nothing on the stack
+    CHIP8_TRAP_BUDGET_EXCEEDED, // the instance ran out of its instruction budget
+    CHIP8_TRAP_DEADLINE_PASSED  // the instance ran past its deadline
+} chip8Status;
+
+// an instruction budget that never runs out
+#define CHIP8_UNLIMITED_BUDGET (~0ULL)
+
+// the behaviour a ROM was written for, where chip8 interpreters differ. an instance follows the ones in its quirks
+enum chip8Quirk
+{
+    QUIRK_SHIFT_USES_VY        = 1 << 0, // 8XY6 and 8XYE shift VY into VX
+    QUIRK_LOAD_STORE_ADVANCE_I = 1 << 1, // FX55 and FX65 leave I pointing past the last register
+    QUIRK_JUMP_USES_VX         = 1 << 2, // BNNN jumps to XNN + VX
+    QUIRK_SPRITES_WRAP         = 1 << 3, // DXYN wraps sprites around the edges instead of clipping them
+    QUIRK_LOGIC_RESETS_VF      = 1 << 4, // 8XY1, 8XY2 and 8XY3 clear VF
+};
+
 struct chip8
 {
     /*
@@ -20,11 +50,21 @@ struct chip8
     // used to store the instruction fetched
     DoubleByte opcode;
 
-    // an array with each index representing each of chip8's 15 registers (excluding the index and carry register)
-    Byte registers[15];
+    /*
+        an array with each index representing each of chip8's 16 registers. the last one (VF) doubles as the carry
+        register (used for arithmetic), which can also be reached by name. opcodes that name VF as X or Y have to
+        see the carry, so the two share the same byte rather than relying on the layout of the struct
+    */
+    union
+    {
+        Byte registers[16];
 
-    // represents the carry register (used for arithmetic)
-    Byte carryRegister;
+        struct
+        {
+            Byte generalRegisters[15];
+            Byte carryRegister;
+        };
+    };
 
     // represents the index register (used for iterating through arrays and strings)
     DoubleByte indexRegister;
@@ -48,9 +88,30 @@ struct chip8
     // a flag set to true when the sound timer has went off
     bool soundFlag;
 
+    // the state of the random number generator used by CXNN (part of the instance so that snapshots are deterministic)
+    unsigned int randomState;
+
+    // the trap that stopped this instance (CHIP8_OK while it is running), and the instruction that caused it
+    chip8Status trap;
+    DoubleByte trapAddress;
+    DoubleByte trapOpcode;
+
+    /*
+        the watchdog used by runChip8Cycles. instructionBudget is the number of instructions the instance may
+        still execute (CHIP8_UNLIMITED_BUDGET by default), and deadline is the time (as returned by
+        getTimeMilliseconds) after which it is stopped, or 0 for no deadline
+    */
+    unsigned long long instructionBudget;
+    double deadline;
+
+    // the chip8Quirk flags this instance follows (none by default, which is the behaviour of the original interpreter)
+    unsigned int quirks;
+
 }; typedef struct chip8 chip8;
 
 void initChip8(chip8* chip8ptr);
 bool loadChip8(const char* romdir, chip8* chip8ptr);
-void emulateChip8Cycle(chip8* chip8ptr);
-void updateChip8Timers(chip8* chip8ptr);
\ No newline at end of file
+chip8Status emulateChip8Cycle(chip8* chip8ptr);
+chip8Status runChip8Cycles(chip8* chip8ptr, unsigned long long cycles);
+void updateChip8Timers(chip8* chip8ptr);
+const char* describeChip8Status(chip8Status status);
\ No newline at end of file
@@ -0,0 +1,30 @@
+#include <string.h>
+
+#include "colours.h"
+
+// the default scheme comes first, so that it can be used when no other scheme matches
+static const colourScheme colourSchemes[] =
+{
+    { "default", { 0, 0, 0 },       { 255, 255, 255 } },
+    { "retro",   { 0, 0, 0 },       { 0, 255, 0 } },
+    { "old",     { 46, 20, 1 },     { 184, 116, 0 } },
+    { "pink",    { 255, 255, 255 }, { 206, 0, 209 } },
+};
+
+#define NUM_OF_COLOUR_SCHEMES (int)(sizeof(colourSchemes) / sizeof(colourSchemes[0]))
+
+const colourScheme* findColourScheme(const char* name)
+{
+    for (int scheme = 0; scheme < NUM_OF_COLOUR_SCHEMES; scheme++)
+    {
+        if (strcmp(name, colourSchemes[scheme].name) == 0)
+            return &colourSchemes[scheme];
+    }
+
+    return &colourSchemes[0];
+}
+
+Byte colourToGrey(const Byte colour[3])
+{
+    return (Byte)((299 * colour[0] + 587 * colour[1] + 114 * colour[2] + 500) / 1000);
+}
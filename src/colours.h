@@ -0,0 +1,17 @@
+#pragma once
+
+#include "chip8.h"
+
+// the colours a frame is drawn in, chosen by name on the command line
+struct colourScheme
+{
+    const char* name;
+    Byte background[3]; // red, green, blue
+    Byte pixel[3];
+}; typedef struct colourScheme colourScheme;
+
+// returns the named colour scheme, or the default one (white on black) if there is no scheme with that name
+const colourScheme* findColourScheme(const char* name);
+
+// the brightness of a colour as a single grey level (BT.601 luma, full range)
+Byte colourToGrey(const Byte colour[3]);
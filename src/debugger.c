@@ -0,0 +1,203 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "debugger.h"
+
+void initChip8Debugger(chip8Debugger* debugger)
+{
+    memset(debugger, 0, sizeof(chip8Debugger));
+}
+
+void setBreakpoint(chip8Debugger* debugger, DoubleByte address, bool enabled)
+{
+    address &= 0xFFF;
+
+    // nothing to do if the breakpoint is already in the requested state
+    if (debugger->breakpoints[address] == enabled)
+        return;
+
+    debugger->breakpoints[address] = enabled;
+    debugger->breakpointsPerPage[address >> DEBUGGER_PAGE_SHIFT] += enabled ? 1 : -1;
+    debugger->numOfBreakpoints += enabled ? 1 : -1;
+}
+
+// marks (or with an access of 0, unmarks) length bytes starting at address
+void setWatchpoint(chip8Debugger* debugger, DoubleByte address, DoubleByte length, Byte access)
+{
+    for (DoubleByte offset = 0; offset < length; offset++)
+    {
+        DoubleByte watched = (address + offset) & 0xFFF;
+
+        bool wasWatched = debugger->watchpoints[watched] != 0;
+        debugger->watchpoints[watched] = access;
+
+        if (wasWatched != (access != 0))
+        {
+            debugger->watchpointsPerPage[watched >> DEBUGGER_PAGE_SHIFT] += access ? 1 : -1;
+            debugger->numOfWatchpoints += access ? 1 : -1;
+        }
+    }
+}
+
+bool runToReturn(chip8Debugger* debugger, const chip8* chip8)
+{
+    if (chip8->stackPointer == 0)
+        return false;
+
+    debugger->runningToReturn  = true;
+    debugger->returnStackLevel = chip8->stackPointer;
+    return true;
+}
+
+// checks whether any of the length bytes starting at address are watched for the given kind of access
+static bool isWatched(chip8Debugger* debugger, DoubleByte address, DoubleByte length, Byte access)
+{
+    for (DoubleByte offset = 0; offset < length; offset++)
+    {
+        DoubleByte watched = (address + offset) & 0xFFF;
+
+        if (debugger->watchpointsPerPage[watched >> DEBUGGER_PAGE_SHIFT] != 0 && (debugger->watchpoints[watched] & access))
+        {
+            debugger->watchAddress = watched;
+            debugger->watchAccess  = access;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+    decodes the instruction at the program counter and checks the memory it is about to touch. only the
+    instructions that access memory through the index register are of interest:
+        DXYN reads N bytes, FX33 writes 3 bytes, FX55 writes X + 1 bytes and FX65 reads X + 1 bytes
+*/
+static bool accessesWatchedMemory(chip8Debugger* debugger, const chip8* chip8)
+{
+    // none of them touch more than 16 bytes from I, so unless the page of I or the page after it has a watchpoint,
+    // the instruction doesn't need decoding at all
+    DoubleByte first = chip8->indexRegister & 0xFFF;
+    DoubleByte last  = (first + 15) & 0xFFF;
+
+    if (debugger->watchpointsPerPage[first >> DEBUGGER_PAGE_SHIFT] == 0 && debugger->watchpointsPerPage[last >> DEBUGGER_PAGE_SHIFT] == 0)
+        return false;
+
+    DoubleByte pc     = chip8->programCounter & 0xFFF;
+    DoubleByte opcode = (chip8->memory[pc] << 8) | chip8->memory[(pc + 1) & 0xFFF];
+    DoubleByte x      = (opcode & 0x0F00) >> 8;
+
+    if ((opcode & 0xF000) == 0xD000)
+        return isWatched(debugger, chip8->indexRegister, opcode & 0x000F, WATCH_READ);
+
+    switch (opcode & 0xF0FF)
+    {
+        case 0xF033: return isWatched(debugger, chip8->indexRegister, 3, WATCH_WRITE);
+        case 0xF055: return isWatched(debugger, chip8->indexRegister, x + 1, WATCH_WRITE);
+        case 0xF065: return isWatched(debugger, chip8->indexRegister, x + 1, WATCH_READ);
+    }
+
+    return false;
+}
+
+/*
+    runs up to maxCycles instructions, stopping early on a breakpoint, watchpoint or return. the instruction that
+    was last stopped on is not stopped on again, so that calling this again after a stop makes progress
+*/
+debuggerStopReason runChip8Debugged(chip8Debugger* debugger, chip8* chip8, unsigned long long maxCycles)
+{
+    // with nothing to stop on, run the plain interpreter without looking at any instruction
+    if (debugger->numOfBreakpoints == 0 && debugger->numOfWatchpoints == 0 && !debugger->runningToReturn)
+    {
+        debugger->resuming = false;
+
+        for (debugger->executedCycles = 0; debugger->executedCycles < maxCycles; debugger->executedCycles++)
+        {
+            if (emulateChip8Cycle(chip8) != CHIP8_OK)
+                return debugger->stopReason = DEBUGGER_STOP_TRAP;
+        }
+
+        return debugger->stopReason = DEBUGGER_STOP_CYCLES;
+    }
+
+    for (debugger->executedCycles = 0; debugger->executedCycles < maxCycles; debugger->executedCycles++)
+    {
+        DoubleByte pc = chip8->programCounter & 0xFFF;
+
+        // only pages with a breakpoint in them need the exact address checked
+        if (!debugger->resuming && debugger->breakpointsPerPage[pc >> DEBUGGER_PAGE_SHIFT] != 0 && debugger->breakpoints[pc])
+        {
+            debugger->resuming = true;
+            return debugger->stopReason = DEBUGGER_STOP_BREAKPOINT;
+        }
+
+        // an instruction stopped on by a breakpoint can still trip a watchpoint when it is resumed
+        bool watchpointsChecked = !debugger->resuming || debugger->stopReason == DEBUGGER_STOP_BREAKPOINT;
+        if (watchpointsChecked && debugger->numOfWatchpoints != 0 && accessesWatchedMemory(debugger, chip8))
+        {
+            debugger->resuming   = true;
+            debugger->stopReason = DEBUGGER_STOP_WATCHPOINT;
+            return DEBUGGER_STOP_WATCHPOINT;
+        }
+
+        debugger->resuming = false;
+
+        if (emulateChip8Cycle(chip8) != CHIP8_OK)
+            return debugger->stopReason = DEBUGGER_STOP_TRAP;
+
+        if (debugger->runningToReturn && chip8->stackPointer < debugger->returnStackLevel)
+        {
+            debugger->executedCycles++;
+            debugger->runningToReturn = false;
+            return debugger->stopReason = DEBUGGER_STOP_RETURN;
+        }
+    }
+
+    return debugger->stopReason = DEBUGGER_STOP_CYCLES;
+}
+
+int formatChip8Registers(const chip8* chip8, char* buffer, int bufferSize)
+{
+    int written = snprintf(buffer, bufferSize, "PC=%.3X I=%.3X SP=%X DT=%.2X ST=%.2X\n",
+        chip8->programCounter, chip8->indexRegister, chip8->stackPointer, chip8->delayTimer, chip8->soundTimer);
+
+    // V0 through VE are the general purpose registers, and VF is the carry register
+    for (int r = 0; r < 15 && written < bufferSize; r++)
+        written += snprintf(buffer + written, bufferSize - written, "V%X=%.2X ", r, chip8->registers[r]);
+
+    if (written < bufferSize)
+        written += snprintf(buffer + written, bufferSize - written, "VF=%.2X\nstack:", chip8->carryRegister);
+
+    for (int level = 0; level < chip8->stackPointer && level < 16 && written < bufferSize; level++)
+        written += snprintf(buffer + written, bufferSize - written, " %.3X", chip8->stack[level]);
+
+    if (written < bufferSize)
+        written += snprintf(buffer + written, bufferSize - written, "\n");
+
+    // snprintf reports what it would have written, so clamp to what actually fit
+    return written < bufferSize ? written : bufferSize - 1;
+}
+
+// formats length bytes of memory starting at address as a hex dump, 16 bytes per line
+int formatChip8Memory(const chip8* chip8, DoubleByte address, DoubleByte length, char* buffer, int bufferSize)
+{
+    int written = 0;
+    buffer[0] = '\0';
+
+    for (DoubleByte offset = 0; offset < length && written < bufferSize; offset++)
+    {
+        DoubleByte byteAddr = (address + offset) & 0xFFF;
+
+        if (offset % 16 == 0)
+            written += snprintf(buffer + written, bufferSize - written, offset == 0 ? "%.3X:" : "\n%.3X:", byteAddr);
+
+        if (written < bufferSize)
+            written += snprintf(buffer + written, bufferSize - written, " %.2X", chip8->memory[byteAddr]);
+    }
+
+    if (written < bufferSize)
+        written += snprintf(buffer + written, bufferSize - written, "\n");
+
+    // snprintf reports what it would have written, so clamp to what actually fit
+    return written < bufferSize ? written : bufferSize - 1;
+}
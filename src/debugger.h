@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "chip8.h"
+
+// breakpoints and watchpoints are marked per address, with a count per 256 byte page so that the common case
+// (an instruction in a page with nothing marked) is rejected with a single lookup
+#define DEBUGGER_PAGE_SHIFT   8
+#define DEBUGGER_NUM_OF_PAGES (4096 >> DEBUGGER_PAGE_SHIFT)
+
+// the kinds of memory access a watchpoint can stop on
+#define WATCH_READ  1
+#define WATCH_WRITE 2
+
+// why runChip8Debugged handed control back to its caller
+typedef enum
+{
+    DEBUGGER_STOP_CYCLES,     // the requested number of cycles were executed
+    DEBUGGER_STOP_BREAKPOINT, // the program counter reached a breakpoint (the instruction there has not executed yet)
+    DEBUGGER_STOP_WATCHPOINT, // the next instruction accesses watched memory (and has not executed yet)
+    DEBUGGER_STOP_RETURN,     // the subroutine that was running when runToReturn was requested has returned
+    DEBUGGER_STOP_TRAP        // the instance trapped (see the trap fields of the chip8 structure)
+} debuggerStopReason;
+
+struct chip8Debugger
+{
+    // marks for each address in chip8's memory. watchpoints hold a mask of WATCH_READ and WATCH_WRITE
+    bool breakpoints[4096];
+    Byte watchpoints[4096];
+
+    // the number of marked addresses in each page
+    DoubleByte breakpointsPerPage[DEBUGGER_NUM_OF_PAGES];
+    DoubleByte watchpointsPerPage[DEBUGGER_NUM_OF_PAGES];
+
+    int numOfBreakpoints;
+    int numOfWatchpoints;
+
+    // when set, execution stops as soon as the stack pointer drops below returnStackLevel
+    bool runningToReturn;
+    DoubleByte returnStackLevel;
+
+    // set after stopping on a breakpoint or watchpoint, so that the instruction stopped on is let through next time
+    // (an instruction stopped on by a breakpoint is still checked against the watchpoints)
+    bool resuming;
+
+    // details about the most recent stop
+    debuggerStopReason stopReason;
+    unsigned long long executedCycles; // the number of instructions executed by the last call to runChip8Debugged
+    DoubleByte watchAddress; // the watched address that the stopped instruction accesses
+    Byte watchAccess;        // WATCH_READ or WATCH_WRITE
+}; typedef struct chip8Debugger chip8Debugger;
+
+void initChip8Debugger(chip8Debugger* debugger);
+
+void setBreakpoint(chip8Debugger* debugger, DoubleByte address, bool enabled);
+void setWatchpoint(chip8Debugger* debugger, DoubleByte address, DoubleByte length, Byte access);
+
+// arms a stop for when the subroutine currently executing returns to its caller. returns false if no subroutine is running
+bool runToReturn(chip8Debugger* debugger, const chip8* chip8ptr);
+
+debuggerStopReason runChip8Debugged(chip8Debugger* debugger, chip8* chip8ptr, unsigned long long maxCycles);
+
+// formatters for inspecting the state of the interpreter. each returns the number of characters written
+int formatChip8Registers(const chip8* chip8ptr, char* buffer, int bufferSize);
+int formatChip8Memory(const chip8* chip8ptr, DoubleByte address, DoubleByte length, char* buffer, int bufferSize);
@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "framedump.h"
+#include "platform.h"
+
+#define DISPLAY_WIDTH  64
+#define DISPLAY_HEIGHT 32
+
+// the largest scale accepted, which keeps an 8 bit frame under 32MB
+#define MAX_FRAME_SCALE 128
+
+static const char y4mFrameHeader[] = "FRAME\n";
+
+bool openChip8FrameWriter(chip8FrameWriter* writer, int fileDescriptor, frameFormat format, int bitsPerPixel, int scale,
+                          const colourScheme* colours)
+{
+    memset(writer, 0, sizeof(chip8FrameWriter));
+
+    if (scale < 1 || scale > MAX_FRAME_SCALE)
+    {
+        printf("The frame scale must be between 1 and %d\n", MAX_FRAME_SCALE);
+        return false;
+    }
+
+    if (bitsPerPixel != 1 && bitsPerPixel != 8)
+    {
+        printf("Frames can only be written with 1 or 8 bits per pixel\n");
+        return false;
+    }
+
+    if (format == FRAME_FORMAT_Y4M && bitsPerPixel != 8)
+    {
+        printf("Y4M frames have to be written with 8 bits per pixel\n");
+        return false;
+    }
+
+    writer->fileDescriptor = fileDescriptor;
+    writer->format         = format;
+    writer->bitsPerPixel   = bitsPerPixel;
+    writer->scale          = scale;
+    writer->backgroundGrey = colourToGrey(colours->background);
+    writer->pixelGrey      = colourToGrey(colours->pixel);
+    writer->width          = DISPLAY_WIDTH * scale;
+    writer->height         = DISPLAY_HEIGHT * scale;
+
+    // the width is a multiple of 64, so packed rows always end on a byte boundary
+    writer->frameSize = (size_t)writer->width * writer->height * bitsPerPixel / 8;
+    writer->frame     = (Byte*)malloc(writer->frameSize);
+    if (writer->frame == NULL)
+    {
+        printf("Error allocating the memory for the frame buffer\n");
+        return false;
+    }
+
+    if (format == FRAME_FORMAT_Y4M)
+    {
+        char header[128];
+        int headerLength = snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F60:1 Ip A1:1 Cmono\n", writer->width, writer->height);
+
+        PlatformBuffer buffer = { header, (size_t)headerLength };
+        if (!writeBuffers(fileDescriptor, &buffer, 1))
+        {
+            closeChip8FrameWriter(writer);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// expands one row of the display into a row of the frame (which is then repeated for the rest of the scale)
+static void drawRow(chip8FrameWriter* writer, const bool* pixels, Byte* row)
+{
+    if (writer->bitsPerPixel == 8)
+    {
+        for (int x = 0; x < DISPLAY_WIDTH; x++)
+            memset(row + x * writer->scale, pixels[x] ? writer->pixelGrey : writer->backgroundGrey, writer->scale);
+
+        return;
+    }
+
+    memset(row, 0, writer->width / 8);
+
+    for (int x = 0; x < DISPLAY_WIDTH; x++)
+    {
+        if (!pixels[x])
+            continue;
+
+        for (int bit = x * writer->scale; bit < (x + 1) * writer->scale; bit++)
+            row[bit >> 3] |= 0x80 >> (bit & 7);
+    }
+}
+
+bool writeChip8Frame(chip8FrameWriter* writer, const chip8* chip8)
+{
+    size_t rowSize = (size_t)writer->width * writer->bitsPerPixel / 8;
+
+    for (int y = 0; y < DISPLAY_HEIGHT; y++)
+    {
+        Byte* row = writer->frame + (size_t)y * writer->scale * rowSize;
+        drawRow(writer, &chip8->pixels[y * DISPLAY_WIDTH], row);
+
+        for (int copy = 1; copy < writer->scale; copy++)
+            memcpy(row + copy * rowSize, row, rowSize);
+    }
+
+    // y4m frames are preceded by their own small header, which goes out in the same write as the frame
+    PlatformBuffer buffers[2];
+    int numOfBuffers = 0;
+
+    if (writer->format == FRAME_FORMAT_Y4M)
+    {
+        buffers[numOfBuffers].data   = y4mFrameHeader;
+        buffers[numOfBuffers].length = sizeof(y4mFrameHeader) - 1;
+        numOfBuffers++;
+    }
+
+    buffers[numOfBuffers].data   = writer->frame;
+    buffers[numOfBuffers].length = writer->frameSize;
+    numOfBuffers++;
+
+    if (!writeBuffers(writer->fileDescriptor, buffers, numOfBuffers))
+        return false;
+
+    writer->framesWritten++;
+    return true;
+}
+
+void closeChip8FrameWriter(chip8FrameWriter* writer)
+{
+    free(writer->frame);
+    writer->frame = NULL;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "chip8.h"
+#include "colours.h"
+
+/*
+    writes frames of the display to a file descriptor (a file, or a pipe into an encoder), for recording gameplay
+    videos or golden images without a window. every frame is scaled up by a whole number and written as either:
+
+        raw, 1 bit:  packed rows of bits (most significant bit first), 1 for a lit pixel
+        raw, 8 bits: rows of grey levels, taken from the colour scheme
+        y4m, 8 bits: a YUV4MPEG2 stream of monochrome (Cmono) 60fps frames, readable by ffmpeg and most encoders
+
+    the frame buffer is allocated once when the writer is opened, and each frame is written straight from it
+*/
+
+enum frameFormat
+{
+    FRAME_FORMAT_RAW,
+    FRAME_FORMAT_Y4M
+}; typedef enum frameFormat frameFormat;
+
+struct chip8FrameWriter
+{
+    int fileDescriptor;
+    frameFormat format;
+    int bitsPerPixel; // 1 or 8 (y4m only supports 8)
+    int scale;
+
+    // the grey levels of unlit and lit pixels (for 8 bit frames)
+    Byte backgroundGrey;
+    Byte pixelGrey;
+
+    int width, height; // of a scaled frame, in pixels
+    Byte* frame;
+    size_t frameSize;
+
+    unsigned long long framesWritten;
+}; typedef struct chip8FrameWriter chip8FrameWriter;
+
+// sets the writer up (writing the stream header for y4m), returning false if the options are invalid or the write failed
+bool openChip8FrameWriter(chip8FrameWriter* writer, int fileDescriptor, frameFormat format, int bitsPerPixel, int scale,
+                          const colourScheme* colours);
+
+// writes the current display of the instance as the next frame, returning false if the write failed
+bool writeChip8Frame(chip8FrameWriter* writer, const chip8* chip8);
+
+// frees the frame buffer (the file descriptor is left open)
+void closeChip8FrameWriter(chip8FrameWriter* writer);
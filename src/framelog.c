@@ -0,0 +1,372 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "framelog.h"
+
+static const char frameLogMagic[4] = { 'C', '8', 'F', 'L' };
+
+// a gap of unchanged bytes this short is cheaper to store as changed bytes than to start a new run for
+#define MAX_MERGED_GAP 2
+
+// a bound on the size of an encoded delta (the worst case, every byte changing, is only a few bytes over a frame)
+#define MAX_DELTA_SIZE (PACKED_FRAME_SIZE + 2 * (PACKED_FRAME_SIZE / 2))
+
+/*
+    packs 8 pixels at a time without a branch per pixel (a busy display made those mispredict, and packing took
+    longer than the emulation in a step of the vectorized environment). the 8 pixels are gathered into the bytes of
+    a 64 bit word, lowest first, and the multiplication moves the lowest bit of each byte (all a bool holds) into the
+    top byte, with the first pixel in the most significant bit
+*/
+void packChip8Frame(const bool* pixels, Byte* packed)
+{
+    for (int byte = 0; byte < PACKED_FRAME_SIZE; byte++)
+    {
+        // read as bytes, and written out rather than looped over, so that compilers turn it into a single load
+        const Byte* eight = (const Byte*)&pixels[byte * 8];
+        uint64_t bits = (uint64_t)eight[0]       | (uint64_t)eight[1] << 8  | (uint64_t)eight[2] << 16 |
+                        (uint64_t)eight[3] << 24 | (uint64_t)eight[4] << 32 | (uint64_t)eight[5] << 40 |
+                        (uint64_t)eight[6] << 48 | (uint64_t)eight[7] << 56;
+
+        packed[byte] = (Byte)((bits * 0x8040201008040201ull) >> 56);
+    }
+}
+
+void unpackChip8Frame(const Byte* packed, bool* pixels)
+{
+    for (int pixel = 0; pixel < 64 * 32; pixel++)
+        pixels[pixel] = (packed[pixel >> 3] & (0x80 >> (pixel & 7))) != 0;
+}
+
+static void storeLittleEndian(Byte* bytes, unsigned long long value, int size)
+{
+    for (int b = 0; b < size; b++)
+        bytes[b] = (Byte)(value >> (8 * b));
+}
+
+static unsigned long long loadLittleEndian(const Byte* bytes, int size)
+{
+    unsigned long long value = 0;
+
+    for (int b = 0; b < size; b++)
+        value |= (unsigned long long)bytes[b] << (8 * b);
+
+    return value;
+}
+
+static bool writeFrameLogHeader(FILE* file, unsigned int keyframeInterval, unsigned int numOfFrames, unsigned long long indexOffset)
+{
+    Byte header[FRAME_LOG_HEADER_SIZE] = { 0 };
+
+    memcpy(header, frameLogMagic, sizeof(frameLogMagic));
+    header[4] = FRAME_LOG_VERSION;
+    storeLittleEndian(header + 8, keyframeInterval, 4);
+    storeLittleEndian(header + 12, numOfFrames, 4);
+    storeLittleEndian(header + 16, indexOffset, 8);
+
+    return fwrite(header, 1, sizeof(header), file) == sizeof(header);
+}
+
+bool openChip8FrameLogWriter(chip8FrameLogWriter* log, const char* path, unsigned int keyframeInterval)
+{
+    memset(log, 0, sizeof(chip8FrameLogWriter));
+    log->keyframeInterval = keyframeInterval > 0 ? keyframeInterval : DEFAULT_KEYFRAME_INTERVAL;
+
+    log->file = fopen(path, "wb");
+    if (log->file == NULL)
+    {
+        printf("Failed to open %s\n", path);
+        return false;
+    }
+
+    // the header is written again with the real frame count and index offset when the log is closed
+    if (!writeFrameLogHeader(log->file, log->keyframeInterval, 0, 0))
+    {
+        fclose(log->file);
+        log->file = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+// encodes the XOR of the two frames as runs of (unchanged bytes, changed bytes), returning the encoded size
+static int encodeDelta(const Byte* previous, const Byte* current, Byte* delta)
+{
+    int size = 0;
+    int position = 0;
+
+    while (position < PACKED_FRAME_SIZE)
+    {
+        int start = position;
+        while (start < PACKED_FRAME_SIZE && previous[start] == current[start])
+            start++;
+
+        if (start == PACKED_FRAME_SIZE)
+            break;
+
+        // extend the run of changed bytes over any short gaps, up to the most a run can hold
+        int end = start + 1;
+        int lastChanged = start;
+        while (end < PACKED_FRAME_SIZE && end - start < 255)
+        {
+            if (previous[end] != current[end])
+                lastChanged = end;
+            else if (end - lastChanged > MAX_MERGED_GAP)
+                break;
+
+            end++;
+        }
+
+        end = lastChanged + 1;
+
+        delta[size++] = (Byte)(start - position);
+        delta[size++] = (Byte)(end - start);
+
+        for (int b = start; b < end; b++)
+            delta[size++] = previous[b] ^ current[b];
+
+        position = end;
+    }
+
+    return size;
+}
+
+bool appendChip8FrameLog(chip8FrameLogWriter* log, const bool* pixels)
+{
+    Byte frame[PACKED_FRAME_SIZE];
+    packChip8Frame(pixels, frame);
+
+    if (log->numOfFrames % log->keyframeInterval == 0)
+    {
+        unsigned int keyframe = log->numOfFrames / log->keyframeInterval;
+
+        if (keyframe >= log->keyframeCapacity)
+        {
+            unsigned int capacity = log->keyframeCapacity > 0 ? log->keyframeCapacity * 2 : 64;
+            unsigned long long* offsets = (unsigned long long*)realloc(log->keyframeOffsets, capacity * sizeof(unsigned long long));
+            if (offsets == NULL)
+                return false;
+
+            log->keyframeOffsets  = offsets;
+            log->keyframeCapacity = capacity;
+        }
+
+        log->keyframeOffsets[keyframe] = (unsigned long long)ftell(log->file);
+
+        if (fwrite(frame, 1, PACKED_FRAME_SIZE, log->file) != PACKED_FRAME_SIZE)
+            return false;
+    }
+    else
+    {
+        // the length goes first, 7 bits at a time, so that a frame that didn't change is a single 0 byte
+        Byte delta[4 + MAX_DELTA_SIZE];
+        int size = encodeDelta(log->previousFrame, frame, delta + 4);
+
+        Byte length[4];
+        int lengthSize = 0;
+        unsigned int remaining = size;
+
+        do
+        {
+            length[lengthSize] = remaining & 0x7F;
+            remaining >>= 7;
+
+            if (remaining > 0)
+                length[lengthSize] |= 0x80;
+
+            lengthSize++;
+        } while (remaining > 0);
+
+        memcpy(delta + 4 - lengthSize, length, lengthSize);
+
+        if (fwrite(delta + 4 - lengthSize, 1, lengthSize + size, log->file) != (size_t)(lengthSize + size))
+            return false;
+    }
+
+    memcpy(log->previousFrame, frame, PACKED_FRAME_SIZE);
+    log->numOfFrames++;
+
+    return true;
+}
+
+bool closeChip8FrameLogWriter(chip8FrameLogWriter* log)
+{
+    if (log->file == NULL)
+        return false;
+
+    bool success = true;
+    unsigned long long indexOffset = (unsigned long long)ftell(log->file);
+    unsigned int numOfKeyframes = (log->numOfFrames + log->keyframeInterval - 1) / log->keyframeInterval;
+
+    for (unsigned int keyframe = 0; keyframe < numOfKeyframes && success; keyframe++)
+    {
+        Byte offset[8];
+        storeLittleEndian(offset, log->keyframeOffsets[keyframe], 8);
+        success = fwrite(offset, 1, sizeof(offset), log->file) == sizeof(offset);
+    }
+
+    success = success && fseek(log->file, 0, SEEK_SET) == 0 &&
+              writeFrameLogHeader(log->file, log->keyframeInterval, log->numOfFrames, indexOffset);
+
+    success = fclose(log->file) == 0 && success;
+
+    free(log->keyframeOffsets);
+    log->keyframeOffsets = NULL;
+    log->file = NULL;
+
+    return success;
+}
+
+bool openChip8FrameLogReader(chip8FrameLogReader* log, const char* path)
+{
+    memset(log, 0, sizeof(chip8FrameLogReader));
+
+    log->file = fopen(path, "rb");
+    if (log->file == NULL)
+    {
+        printf("Failed to open %s\n", path);
+        return false;
+    }
+
+    Byte header[FRAME_LOG_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), log->file) != sizeof(header) ||
+        memcmp(header, frameLogMagic, sizeof(frameLogMagic)) != 0 || header[4] != FRAME_LOG_VERSION)
+    {
+        printf("%s is not a frame log\n", path);
+        closeChip8FrameLogReader(log);
+        return false;
+    }
+
+    log->keyframeInterval = (unsigned int)loadLittleEndian(header + 8, 4);
+    log->numOfFrames      = (unsigned int)loadLittleEndian(header + 12, 4);
+    log->currentFrame     = log->numOfFrames;
+
+    unsigned long long indexOffset = loadLittleEndian(header + 16, 8);
+
+    // a log that was never closed (e.g. its recorder crashed) has no index
+    if (log->keyframeInterval == 0 || indexOffset == 0)
+    {
+        printf("%s was not closed properly, and has no index\n", path);
+        closeChip8FrameLogReader(log);
+        return false;
+    }
+
+    log->numOfKeyframes  = (log->numOfFrames + log->keyframeInterval - 1) / log->keyframeInterval;
+    log->keyframeOffsets = (unsigned long long*)malloc((log->numOfKeyframes + 1) * sizeof(unsigned long long));
+    if (log->keyframeOffsets == NULL || fseek(log->file, (long)indexOffset, SEEK_SET) != 0)
+    {
+        closeChip8FrameLogReader(log);
+        return false;
+    }
+
+    for (unsigned int keyframe = 0; keyframe < log->numOfKeyframes; keyframe++)
+    {
+        Byte offset[8];
+        if (fread(offset, 1, sizeof(offset), log->file) != sizeof(offset))
+        {
+            printf("The index of %s is truncated\n", path);
+            closeChip8FrameLogReader(log);
+            return false;
+        }
+
+        log->keyframeOffsets[keyframe] = loadLittleEndian(offset, 8);
+    }
+
+    return true;
+}
+
+// applies the next delta in the file to log->frame
+static bool readDelta(chip8FrameLogReader* log)
+{
+    unsigned int size = 0;
+    int c;
+
+    for (int shift = 0; ; shift += 7)
+    {
+        if (shift > 21 || (c = fgetc(log->file)) == EOF)
+            return false;
+
+        size |= (unsigned int)(c & 0x7F) << shift;
+        if ((c & 0x80) == 0)
+            break;
+    }
+
+    Byte delta[MAX_DELTA_SIZE];
+    if (size > sizeof(delta) || fread(delta, 1, size, log->file) != size)
+        return false;
+
+    unsigned int position = 0;
+    unsigned int d = 0;
+
+    while (d + 2 <= size)
+    {
+        position += delta[d];
+        unsigned int count = delta[d + 1];
+        d += 2;
+
+        if (position + count > PACKED_FRAME_SIZE || d + count > size)
+            return false;
+
+        for (unsigned int b = 0; b < count; b++)
+            log->frame[position + b] ^= delta[d + b];
+
+        position += count;
+        d += count;
+    }
+
+    return d == size;
+}
+
+bool seekChip8FrameLog(chip8FrameLogReader* log, unsigned int frame)
+{
+    if (frame >= log->numOfFrames)
+        return false;
+
+    if (frame == log->currentFrame)
+        return true;
+
+    // within the same keyframe's group, playing forward carries on from the current frame
+    unsigned int keyframe = frame / log->keyframeInterval;
+    unsigned int decoded;
+
+    if (log->currentFrame < log->numOfFrames && log->currentFrame < frame && log->currentFrame / log->keyframeInterval == keyframe)
+    {
+        decoded = log->currentFrame;
+    }
+    else
+    {
+        if (fseek(log->file, (long)log->keyframeOffsets[keyframe], SEEK_SET) != 0 ||
+            fread(log->frame, 1, PACKED_FRAME_SIZE, log->file) != PACKED_FRAME_SIZE)
+        {
+            log->currentFrame = log->numOfFrames;
+            return false;
+        }
+
+        decoded = keyframe * log->keyframeInterval;
+    }
+
+    while (decoded < frame)
+    {
+        if (!readDelta(log))
+        {
+            log->currentFrame = log->numOfFrames;
+            return false;
+        }
+
+        decoded++;
+    }
+
+    log->currentFrame = frame;
+    return true;
+}
+
+void closeChip8FrameLogReader(chip8FrameLogReader* log)
+{
+    if (log->file != NULL)
+        fclose(log->file);
+
+    free(log->keyframeOffsets);
+    log->keyframeOffsets = NULL;
+    log->file = NULL;
+}
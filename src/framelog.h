@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "chip8.h"
+
+/*
+    a compact log of the display, one entry per 60Hz frame. the 64x32 display is packed into 256 bytes (8 pixels a
+    byte, most significant bit first), and only every keyframeInterval'th frame is stored whole. the frames in
+    between are stored as the XOR against the frame before them, run length encoded, so an unchanged frame costs a
+    single byte. an index of the keyframes at the end of the file lets any frame be reached by decoding one keyframe
+    and at most keyframeInterval - 1 deltas.
+
+    file layout (all integers little endian):
+        header:  "C8FL", version (1 byte), 3 reserved bytes, keyframe interval (u32), number of frames (u32),
+                 offset of the index (u64)
+        frames:  a keyframe is 256 bytes of packed pixels. a delta is its encoded length (LEB128), followed by pairs
+                 of (number of unchanged bytes, number of changed bytes) each followed by the changed bytes XORed
+                 with the previous frame
+        index:   the offset of each keyframe (u64)
+*/
+
+#define FRAME_LOG_VERSION        1
+#define FRAME_LOG_HEADER_SIZE    24
+#define PACKED_FRAME_SIZE        (64 * 32 / 8)
+#define DEFAULT_KEYFRAME_INTERVAL 600
+
+// a frame log being written (the header and index are only complete once it has been closed)
+struct chip8FrameLogWriter
+{
+    FILE* file;
+    unsigned int keyframeInterval;
+    unsigned int numOfFrames;
+
+    Byte previousFrame[PACKED_FRAME_SIZE];
+
+    unsigned long long* keyframeOffsets;
+    unsigned int keyframeCapacity;
+}; typedef struct chip8FrameLogWriter chip8FrameLogWriter;
+
+// a frame log being read. the reader remembers the last frame it decoded, so that playing forward is cheap
+struct chip8FrameLogReader
+{
+    FILE* file;
+    unsigned int keyframeInterval;
+    unsigned int numOfFrames;
+
+    unsigned long long* keyframeOffsets;
+    unsigned int numOfKeyframes;
+
+    Byte frame[PACKED_FRAME_SIZE];
+    unsigned int currentFrame; // the frame held in frame (numOfFrames before the first one is read)
+}; typedef struct chip8FrameLogReader chip8FrameLogReader;
+
+void packChip8Frame(const bool* pixels, Byte* packed);
+void unpackChip8Frame(const Byte* packed, bool* pixels);
+
+bool openChip8FrameLogWriter(chip8FrameLogWriter* log, const char* path, unsigned int keyframeInterval);
+bool appendChip8FrameLog(chip8FrameLogWriter* log, const bool* pixels);
+
+// writes the index and completes the header, returning false if the log could not be finished
+bool closeChip8FrameLogWriter(chip8FrameLogWriter* log);
+
+bool openChip8FrameLogReader(chip8FrameLogReader* log, const char* path);
+
+// decodes the given frame into log->frame, returning false if it is out of range or the log is damaged
+bool seekChip8FrameLog(chip8FrameLogReader* log, unsigned int frame);
+
+void closeChip8FrameLogReader(chip8FrameLogReader* log);
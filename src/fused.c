@@ -0,0 +1,760 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fused.h"
+#include "platform.h"
+#include "rompack.h"
+
+// matches the masking done by the interpreter, so that both engines see the same 4kb of memory
+#define MEMORY_MASK 0xFFF
+
+// how many instructions are executed between checks of the clock against the deadline (as in runChip8Cycles)
+#define DEADLINE_CHECK_INTERVAL 1024
+
+enum operation
+{
+    // anything that can trap (unknown opcodes, stack errors) is handed to the interpreter
+    OP_INTERPRET,
+
+    OP_CLS, OP_RET, OP_JP, OP_CALL, OP_SE_IMM, OP_SNE_IMM, OP_SE_REG, OP_LD_IMM, OP_ADD_IMM,
+    OP_MOV, OP_OR, OP_AND, OP_XOR, OP_ADD, OP_SUB, OP_SHR, OP_SUBN, OP_SHL, OP_SNE_REG,
+    OP_LD_I, OP_JP_V0, OP_RND, OP_DRW, OP_SKP, OP_SKNP,
+    OP_LD_VX_DT, OP_LD_K, OP_LD_DT_VX, OP_LD_ST_VX, OP_ADD_I, OP_LD_F, OP_BCD, OP_STORE, OP_LOAD,
+
+    // the fused sequences
+    OP_LD_I_DRW,      // ANNN; DXYN
+    OP_TIMER_POLL,    // FX07; 3XNN; 1NNN
+    OP_LD_IMM_PAIR,   // 6XNN; 6YNN
+    OP_ADD_I_ADD_IMM, // FX1E; 7YNN
+    OP_BCD_LOAD       // FX33; FY65
+};
+
+void initChip8FusedEngine(chip8FusedEngine* engine)
+{
+    memset(engine, 0, sizeof(chip8FusedEngine));
+    engine->generation = 1;
+
+    for (int spriteRowData = 0; spriteRowData < 256; spriteRowData++)
+        for (int column = 0; column < 8; column++)
+            engine->spritePixels[spriteRowData][column] = (spriteRowData & (0x80 >> column)) != 0;
+}
+
+// invalidates every entry in the cache
+void resetChip8FusedEngine(chip8FusedEngine* engine)
+{
+    engine->generation++;
+
+    // entries hold 0 once invalidated, so the generation must never wrap around to it
+    if (engine->generation == 0)
+        initChip8FusedEngine(engine);
+}
+
+// invalidates every entry that covers any of the length bytes starting at address
+void invalidateChip8FusedEngine(chip8FusedEngine* engine, DoubleByte address, DoubleByte length)
+{
+    // an entry starting before the write only covers it if it is long enough to reach it
+    for (int offset = 1 - MAX_FUSED_BYTES; offset < 0; offset++)
+    {
+        decodedInstruction* entry = &engine->entries[(address + offset) & MEMORY_MASK];
+        if (entry->length * 2 > -offset)
+            entry->generation = 0;
+    }
+
+    for (int offset = 0; offset < length; offset++)
+        engine->entries[(address + offset) & MEMORY_MASK].generation = 0;
+}
+
+static DoubleByte fetchOpcode(const chip8* chip8, DoubleByte address)
+{
+    return (chip8->memory[address & MEMORY_MASK] << 8) | chip8->memory[(address + 1) & MEMORY_MASK];
+}
+
+// decodes a single instruction (mirroring the switch statement in emulateChip8Cycle)
+static void decodeInstruction(DoubleByte opcode, decodedInstruction* entry)
+{
+    entry->length   = 1;
+    entry->x        = (opcode & 0x0F00) >> 8;
+    entry->y        = (opcode & 0x00F0) >> 4;
+    entry->operand  = 0;
+    entry->operand2 = 0;
+
+    Byte operation = OP_INTERPRET;
+
+    switch (opcode & 0xF000)
+    {
+        case 0x0000:
+            if (opcode == 0x00E0)
+                operation = OP_CLS;
+            else if (opcode == 0x00EE)
+                operation = OP_RET;
+            break;
+
+        case 0x1000: operation = OP_JP;      entry->operand = opcode & 0x0FFF; break;
+        case 0x2000: operation = OP_CALL;    entry->operand = opcode & 0x0FFF; break;
+        case 0x3000: operation = OP_SE_IMM;  entry->operand = opcode & 0x00FF; break;
+        case 0x4000: operation = OP_SNE_IMM; entry->operand = opcode & 0x00FF; break;
+        case 0x6000: operation = OP_LD_IMM;  entry->operand = opcode & 0x00FF; break;
+        case 0x7000: operation = OP_ADD_IMM; entry->operand = opcode & 0x00FF; break;
+        case 0xA000: operation = OP_LD_I;    entry->operand = opcode & 0x0FFF; break;
+        case 0xB000: operation = OP_JP_V0;   entry->operand = opcode & 0x0FFF; break;
+        case 0xC000: operation = OP_RND;     entry->operand = opcode & 0x00FF; break;
+        case 0xD000: operation = OP_DRW;     entry->operand = opcode & 0x000F; break;
+
+        // 5XY0 and 9XY0 are decoded by their first nibble only, just like in the interpreter
+        case 0x5000: operation = OP_SE_REG;  break;
+        case 0x9000: operation = OP_SNE_REG; break;
+
+        case 0x8000:
+        {
+            switch (opcode & 0x000F)
+            {
+                case 0x0: operation = OP_MOV;  break;
+                case 0x1: operation = OP_OR;   break;
+                case 0x2: operation = OP_AND;  break;
+                case 0x3: operation = OP_XOR;  break;
+                case 0x4: operation = OP_ADD;  break;
+                case 0x5: operation = OP_SUB;  break;
+                case 0x6: operation = OP_SHR;  break;
+                case 0x7: operation = OP_SUBN; break;
+                case 0xE: operation = OP_SHL;  break;
+            }
+
+            break;
+        }
+
+        case 0xE000:
+        {
+            if ((opcode & 0xFF) == 0x9E)
+                operation = OP_SKP;
+            else if ((opcode & 0xFF) == 0xA1)
+                operation = OP_SKNP;
+
+            break;
+        }
+
+        case 0xF000:
+        {
+            switch (opcode & 0xFF)
+            {
+                case 0x07: operation = OP_LD_VX_DT; break;
+                case 0x0A: operation = OP_LD_K;     break;
+                case 0x15: operation = OP_LD_DT_VX; break;
+                case 0x18: operation = OP_LD_ST_VX; break;
+                case 0x1E: operation = OP_ADD_I;    break;
+                case 0x29: operation = OP_LD_F;     break;
+                case 0x33: operation = OP_BCD;      break;
+                case 0x55: operation = OP_STORE;    break;
+                case 0x65: operation = OP_LOAD;     break;
+            }
+
+            break;
+        }
+    }
+
+    entry->operation = operation;
+}
+
+// decodes the instruction at address into the cache, fusing it with the instructions that follow when possible
+static void decodeEntry(decodedInstruction* entry, unsigned int generation, const chip8* chip8, DoubleByte address)
+{
+    DoubleByte first  = fetchOpcode(chip8, address);
+    DoubleByte second = fetchOpcode(chip8, address + 2);
+    DoubleByte third  = fetchOpcode(chip8, address + 4);
+
+    decodeInstruction(first, entry);
+    entry->generation = generation;
+
+    if ((first & 0xF000) == 0xA000 && (second & 0xF000) == 0xD000)
+    {
+        entry->operation = OP_LD_I_DRW;
+        entry->length    = 2;
+        entry->x         = (second & 0x0F00) >> 8;
+        entry->y         = (second & 0x00F0) >> 4;
+        entry->operand   = first & 0x0FFF;
+        entry->operand2  = second & 0x000F;
+    }
+    else if ((first & 0xF0FF) == 0xF007 && (second & 0xFF00) == (0x3000 | (first & 0x0F00)) && (third & 0xF000) == 0x1000)
+    {
+        entry->operation = OP_TIMER_POLL;
+        entry->length    = 3;
+        entry->operand   = second & 0x00FF;
+        entry->operand2  = third & 0x0FFF;
+    }
+    else if ((first & 0xF000) == 0x6000 && (second & 0xF000) == 0x6000)
+    {
+        entry->operation = OP_LD_IMM_PAIR;
+        entry->length    = 2;
+        entry->y         = (second & 0x0F00) >> 8;
+        entry->operand   = first & 0x00FF;
+        entry->operand2  = second & 0x00FF;
+    }
+    else if ((first & 0xF0FF) == 0xF01E && (second & 0xF000) == 0x7000)
+    {
+        entry->operation = OP_ADD_I_ADD_IMM;
+        entry->length    = 2;
+        entry->y         = (second & 0x0F00) >> 8;
+        entry->operand   = second & 0x00FF;
+    }
+    else if ((first & 0xF0FF) == 0xF033 && (second & 0xF0FF) == 0xF065)
+    {
+        entry->operation = OP_BCD_LOAD;
+        entry->length    = 2;
+        entry->y         = (second & 0x0F00) >> 8;
+    }
+}
+
+/*
+    DXYN, exactly as the interpreter draws it (wrapping the start position, and clipping at the edges unless the
+    instance has QUIRK_SPRITES_WRAP). the display is an array of bools one byte each, so a row of a sprite that
+    doesn't cross the right edge is drawn as a single 64-bit XOR of the row's expanded pixels
+*/
+static void drawSprite(const chip8FusedEngine* engine, chip8* chip8, Byte x, Byte y, Byte height)
+{
+    chip8->carryRegister = 0;
+
+    bool wrap = (chip8->quirks & QUIRK_SPRITES_WRAP) != 0;
+    DoubleByte xpos = chip8->registers[x] % 64;
+    DoubleByte ypos = chip8->registers[y] % 32;
+
+    for (int row = 0; row < height; row++)
+    {
+        // sprites are at most 15 rows, so a row that goes off the bottom only ever wraps once
+        int rowY = ypos + row;
+        if (rowY >= 32)
+        {
+            if (!wrap)
+                break;
+
+            rowY -= 32;
+        }
+
+        Byte spriteRowData = chip8->memory[(chip8->indexRegister + row) & MEMORY_MASK];
+        bool* rowPixels = &chip8->pixels[rowY * 64];
+
+        if (xpos <= 64 - 8)
+        {
+            uint64_t sprite, displayed;
+            memcpy(&sprite, engine->spritePixels[spriteRowData], sizeof(sprite));
+            memcpy(&displayed, &rowPixels[xpos], sizeof(displayed));
+
+            if ((displayed & sprite) != 0)
+                chip8->carryRegister = 1;
+
+            displayed ^= sprite;
+            memcpy(&rowPixels[xpos], &displayed, sizeof(displayed));
+            continue;
+        }
+
+        for (int column = 0; column < 8; column++)
+        {
+            int columnX = xpos + column;
+            if (columnX >= 64)
+            {
+                if (!wrap)
+                    break;
+
+                columnX -= 64;
+            }
+
+            if ((spriteRowData & (0x80 >> column)) != 0)
+            {
+                if (rowPixels[columnX])
+                    chip8->carryRegister = 1;
+
+                rowPixels[columnX] ^= 1;
+            }
+        }
+    }
+
+    chip8->drawFlag = true;
+}
+
+// FX33, invalidating any cached instructions that the digits overwrite
+static void storeBCD(chip8FusedEngine* engine, chip8* chip8, Byte x)
+{
+    chip8->memory[chip8->indexRegister & MEMORY_MASK]       = chip8->registers[x] / 100;
+    chip8->memory[(chip8->indexRegister + 1) & MEMORY_MASK] = (chip8->registers[x] / 10) % 10;
+    chip8->memory[(chip8->indexRegister + 2) & MEMORY_MASK] = chip8->registers[x] % 10;
+
+    invalidateChip8FusedEngine(engine, chip8->indexRegister, 3);
+}
+
+/*
+    executes a decoded entry at the program counter pc (which the caller keeps in place of the instance's), returning
+    the number of chip8 instructions that were executed (which can be fewer than the entry's length when a fused
+    sequence exits early), or 0 if the instruction trapped
+*/
+static inline int executeEntry(chip8FusedEngine* engine, chip8* chip8, const decodedInstruction* entry, DoubleByte* pc)
+{
+    Byte* registers = chip8->registers;
+    Byte x = entry->x;
+    Byte y = entry->y;
+
+    switch (entry->operation)
+    {
+        case OP_CLS:
+            memset(chip8->pixels, 0, sizeof(chip8->pixels));
+            chip8->drawFlag = true;
+            *pc += 2;
+            return 1;
+
+        case OP_RET:
+            if (chip8->stackPointer == 0)
+                break;
+
+            chip8->stackPointer--;
+            *pc = chip8->stack[chip8->stackPointer] + 2;
+            return 1;
+
+        case OP_JP:
+            *pc = entry->operand;
+            return 1;
+
+        case OP_CALL:
+            if (chip8->stackPointer >= 16)
+                break;
+
+            chip8->stack[chip8->stackPointer++] = *pc;
+            *pc = entry->operand;
+            return 1;
+
+        case OP_SE_IMM:  *pc += registers[x] == entry->operand ? 4 : 2; return 1;
+        case OP_SNE_IMM: *pc += registers[x] != entry->operand ? 4 : 2; return 1;
+        case OP_SE_REG:  *pc += registers[x] == registers[y] ? 4 : 2;   return 1;
+        case OP_SNE_REG: *pc += registers[x] != registers[y] ? 4 : 2;   return 1;
+        case OP_LD_IMM:  registers[x] = (Byte)entry->operand;  *pc += 2; return 1;
+        case OP_ADD_IMM: registers[x] += (Byte)entry->operand; *pc += 2; return 1;
+        case OP_MOV:     registers[x] = registers[y];          *pc += 2; return 1;
+
+        // the order of the register and carry writes matches the interpreter, which matters when X is F
+        case OP_OR:
+            registers[x] |= registers[y];
+            if (chip8->quirks & QUIRK_LOGIC_RESETS_VF)
+                chip8->carryRegister = 0;
+
+            *pc += 2;
+            return 1;
+
+        case OP_AND:
+            registers[x] &= registers[y];
+            if (chip8->quirks & QUIRK_LOGIC_RESETS_VF)
+                chip8->carryRegister = 0;
+
+            *pc += 2;
+            return 1;
+
+        case OP_XOR:
+            registers[x] ^= registers[y];
+            if (chip8->quirks & QUIRK_LOGIC_RESETS_VF)
+                chip8->carryRegister = 0;
+
+            *pc += 2;
+            return 1;
+
+        case OP_ADD:
+        {
+            DoubleByte sum = registers[x] + registers[y];
+            registers[x] = sum & 0xFF;
+            chip8->carryRegister = sum > 0xFF ? 1 : 0;
+            *pc += 2;
+            return 1;
+        }
+
+        case OP_SUB:
+            chip8->carryRegister = 1;
+            if (registers[y] > registers[x])
+                chip8->carryRegister = 0;
+
+            registers[x] -= registers[y];
+            *pc += 2;
+            return 1;
+
+        case OP_SHR:
+        {
+            Byte shifted = registers[(chip8->quirks & QUIRK_SHIFT_USES_VY) ? y : x];
+            chip8->carryRegister = shifted & 1;
+            registers[x] = shifted >> 1;
+            *pc += 2;
+            return 1;
+        }
+
+        case OP_SUBN:
+            chip8->carryRegister = 1;
+            if (registers[x] > registers[y])
+                chip8->carryRegister = 0;
+
+            registers[x] = registers[y] - registers[x];
+            *pc += 2;
+            return 1;
+
+        case OP_SHL:
+        {
+            Byte shifted = registers[(chip8->quirks & QUIRK_SHIFT_USES_VY) ? y : x];
+            chip8->carryRegister = shifted >> 7;
+            registers[x] = shifted << 1;
+            *pc += 2;
+            return 1;
+        }
+
+        case OP_LD_I:
+            chip8->indexRegister = entry->operand;
+            *pc += 2;
+            return 1;
+
+        case OP_JP_V0:
+            *pc = (entry->operand + registers[(chip8->quirks & QUIRK_JUMP_USES_VX) ? x : 0]) & MEMORY_MASK;
+            return 1;
+
+        case OP_RND:
+            chip8->randomState ^= chip8->randomState << 13;
+            chip8->randomState ^= chip8->randomState >> 17;
+            chip8->randomState ^= chip8->randomState << 5;
+
+            registers[x] = chip8->randomState & entry->operand;
+            *pc += 2;
+            return 1;
+
+        case OP_DRW:
+            drawSprite(engine, chip8, x, y, (Byte)entry->operand);
+            *pc += 2;
+            return 1;
+
+        case OP_SKP:  *pc += chip8->keys[registers[x] & 0xF] ? 4 : 2;  return 1;
+        case OP_SKNP: *pc += !chip8->keys[registers[x] & 0xF] ? 4 : 2; return 1;
+
+        case OP_LD_VX_DT: registers[x] = chip8->delayTimer;   *pc += 2; return 1;
+        case OP_LD_DT_VX: chip8->delayTimer = registers[x];   *pc += 2; return 1;
+        case OP_LD_ST_VX: chip8->soundTimer = registers[x];   *pc += 2; return 1;
+        case OP_ADD_I:    chip8->indexRegister += registers[x]; *pc += 2; return 1;
+        case OP_LD_F:     chip8->indexRegister = registers[x] * 0x5; *pc += 2; return 1;
+
+        case OP_LD_K:
+        {
+            // without a key pressed, the instruction is executed again next time
+            for (int key = 0; key < 16; key++)
+            {
+                if (chip8->keys[key])
+                {
+                    registers[x] = key;
+                    *pc += 2;
+                    break;
+                }
+            }
+
+            return 1;
+        }
+
+        case OP_BCD:
+            storeBCD(engine, chip8, x);
+            *pc += 2;
+            return 1;
+
+        case OP_STORE:
+        {
+            for (int r = 0; r <= x; r++)
+                chip8->memory[(chip8->indexRegister + r) & MEMORY_MASK] = registers[r];
+
+            invalidateChip8FusedEngine(engine, chip8->indexRegister, x + 1);
+
+            if (chip8->quirks & QUIRK_LOAD_STORE_ADVANCE_I)
+                chip8->indexRegister += x + 1;
+
+            *pc += 2;
+            return 1;
+        }
+
+        case OP_LOAD:
+        {
+            for (int r = 0; r <= x; r++)
+                registers[r] = chip8->memory[(chip8->indexRegister + r) & MEMORY_MASK];
+
+            if (chip8->quirks & QUIRK_LOAD_STORE_ADVANCE_I)
+                chip8->indexRegister += x + 1;
+
+            *pc += 2;
+            return 1;
+        }
+
+        case OP_LD_I_DRW:
+            chip8->indexRegister = entry->operand;
+            drawSprite(engine, chip8, x, y, (Byte)entry->operand2);
+            *pc += 4;
+            return 2;
+
+        case OP_TIMER_POLL:
+        {
+            registers[x] = chip8->delayTimer;
+
+            // once the timer matches, 3XNN skips over the jump
+            if (registers[x] == entry->operand)
+            {
+                *pc += 6;
+                return 2;
+            }
+
+            *pc = entry->operand2;
+            return 3;
+        }
+
+        case OP_LD_IMM_PAIR:
+            registers[x] = (Byte)entry->operand;
+            registers[y] = (Byte)entry->operand2;
+            *pc += 4;
+            return 2;
+
+        case OP_ADD_I_ADD_IMM:
+            chip8->indexRegister += registers[x];
+            registers[y] += (Byte)entry->operand;
+            *pc += 4;
+            return 2;
+
+        case OP_BCD_LOAD:
+        {
+            storeBCD(engine, chip8, x);
+            *pc += 2;
+
+            // if the digits overwrote the sequence itself, FY65 has to be decoded again from the new bytes
+            if (entry->generation != engine->generation)
+                return 1;
+
+            for (int r = 0; r <= y; r++)
+                registers[r] = chip8->memory[(chip8->indexRegister + r) & MEMORY_MASK];
+
+            if (chip8->quirks & QUIRK_LOAD_STORE_ADVANCE_I)
+                chip8->indexRegister += y + 1;
+
+            *pc += 2;
+            return 2;
+        }
+    }
+
+    // everything else goes through the interpreter, which records the trap
+    chip8->programCounter = *pc;
+    chip8Status status = emulateChip8Cycle(chip8);
+    *pc = chip8->programCounter;
+
+    return status == CHIP8_OK ? 1 : 0;
+}
+
+/*
+    executes up to count instructions, stopping early only on a trap, and returns how many were executed (counting
+    the trapping instruction, as the interpreter does). none of the checks the interpreter makes before each
+    instruction are made here, which is what makes the engine faster: the caller checks the clock between calls
+*/
+static unsigned long long runEntries(chip8FusedEngine* engine, chip8* chip8, unsigned long long count)
+{
+    decodedInstruction* entries = engine->entries;
+
+    /*
+        the generation and program counter are kept in locals (and so in registers), since the compiler can't tell
+        that writes to the instance's memory don't change them. the program counter is written back at the end
+    */
+    unsigned int generation = engine->generation;
+    DoubleByte pc = chip8->programCounter;
+
+    unsigned long long executed = 0;
+    int entryCount = 1;
+
+    // until the last few instructions, any entry (however long) fits in what is left
+    while (executed + MAX_FUSED_BYTES / 2 <= count)
+    {
+        pc &= MEMORY_MASK;
+
+        decodedInstruction* entry = &entries[pc];
+        if (entry->generation != generation)
+            decodeEntry(entry, generation, chip8, pc);
+
+        entryCount = executeEntry(engine, chip8, entry, &pc);
+        if (entryCount == 0)
+            break;
+
+        executed += entryCount;
+    }
+
+    // a fused entry that would run past the end is executed one instruction at a time
+    while (executed < count && entryCount != 0)
+    {
+        pc &= MEMORY_MASK;
+
+        decodedInstruction* entry = &entries[pc];
+        if (entry->generation != generation)
+            decodeEntry(entry, generation, chip8, pc);
+
+        decodedInstruction single;
+        if (entry->length > count - executed)
+        {
+            decodeInstruction(fetchOpcode(chip8, pc), &single);
+            single.generation = generation;
+            entry = &single;
+        }
+
+        entryCount = executeEntry(engine, chip8, entry, &pc);
+        executed += entryCount;
+    }
+
+    chip8->programCounter = pc;
+
+    // the interpreter charges the trapping instruction against the budget too
+    return entryCount == 0 ? executed + 1 : executed;
+}
+
+chip8Status runChip8Fused(chip8FusedEngine* engine, chip8* chip8, unsigned long long cycles)
+{
+    if (chip8->trap != CHIP8_OK)
+        return chip8->trap;
+
+    // when the budget runs out first, only run as far as it allows, and let the interpreter raise the trap
+    bool limitedByBudget = chip8->instructionBudget < cycles;
+    unsigned long long limit = limitedByBudget ? chip8->instructionBudget : cycles;
+
+    unsigned long long executed = 0;
+
+    // with a deadline, the instructions are run in slices with the clock checked before each (as in runChip8Cycles)
+    while (executed < limit && chip8->trap == CHIP8_OK)
+    {
+        unsigned long long slice = limit - executed;
+
+        if (chip8->deadline != 0.0)
+        {
+            if (getTimeMilliseconds() >= chip8->deadline)
+                break;
+
+            if (slice > DEADLINE_CHECK_INTERVAL)
+                slice = DEADLINE_CHECK_INTERVAL;
+        }
+
+        executed += runEntries(engine, chip8, slice);
+    }
+
+    if (chip8->instructionBudget != CHIP8_UNLIMITED_BUDGET)
+        chip8->instructionBudget -= executed;
+
+    if (chip8->trap != CHIP8_OK)
+        return chip8->trap;
+
+    // running out of budget or time is reported by the interpreter, which checks both before executing anything
+    if (executed < cycles)
+        return runChip8Cycles(chip8, 1);
+
+    return CHIP8_OK;
+}
+
+// the header of a translation cache file, which is followed by the entries
+struct translationCacheHeader
+{
+    char magic[4]; // "C8TC"
+    uint32_t engineVersion;
+    uint32_t entrySize;
+    uint32_t numOfEntries;
+    uint64_t imageHash;
+}; typedef struct translationCacheHeader translationCacheHeader;
+
+static const char translationCacheMagic[4] = { 'C', '8', 'T', 'C' };
+
+void initChip8TranslationCache(chip8TranslationCache* cache)
+{
+    memset(cache, 0, sizeof(chip8TranslationCache));
+}
+
+int captureChip8TranslationCache(chip8TranslationCache* cache, const chip8FusedEngine* engine, const chip8* pristine)
+{
+    int added = 0;
+
+    for (int address = 0; address < 4096; address++)
+    {
+        if (engine->entries[address].generation != engine->generation || cache->entries[address].generation != 0)
+            continue;
+
+        // decoded against the pristine memory, whatever the running instance has done to its own since
+        decodeEntry(&cache->entries[address], 1, pristine, (DoubleByte)address);
+        added++;
+    }
+
+    return added;
+}
+
+void warmChip8FusedEngine(chip8FusedEngine* engine, const chip8TranslationCache* cache)
+{
+    for (int address = 0; address < 4096; address++)
+    {
+        if (cache->entries[address].generation == 0)
+            continue;
+
+        engine->entries[address] = cache->entries[address];
+        engine->entries[address].generation = engine->generation;
+    }
+}
+
+static void translationCachePath(char* path, size_t size, const chip8* pristine, const char* cacheDirectory)
+{
+    uint64_t imageHash = hashChip8ROM(pristine->memory, sizeof(pristine->memory));
+    snprintf(path, size, "%s/%016llx-%u.c8tc", cacheDirectory, (unsigned long long)imageHash, CHIP8_FUSED_ENGINE_VERSION);
+}
+
+bool loadChip8TranslationCache(chip8TranslationCache* cache, const chip8* pristine, const char* cacheDirectory)
+{
+    char path[1024];
+    translationCachePath(path, sizeof(path), pristine, cacheDirectory);
+
+    PlatformMappedFile file;
+    if (!mapFile(&file, path))
+        return false;
+
+    const translationCacheHeader* header = (const translationCacheHeader*)file.data;
+
+    // a cache from another version of the engine, another build, or for another image (or a truncated one) is ignored
+    bool valid = file.size == sizeof(translationCacheHeader) + sizeof(chip8TranslationCache) &&
+                 memcmp(header->magic, translationCacheMagic, sizeof(translationCacheMagic)) == 0 &&
+                 header->engineVersion == CHIP8_FUSED_ENGINE_VERSION &&
+                 header->entrySize == sizeof(decodedInstruction) &&
+                 header->numOfEntries == 4096 &&
+                 header->imageHash == hashChip8ROM(pristine->memory, sizeof(pristine->memory));
+
+    if (valid)
+        memcpy(cache, (const Byte*)file.data + sizeof(translationCacheHeader), sizeof(chip8TranslationCache));
+
+    unmapFile(&file);
+    return valid;
+}
+
+bool saveChip8TranslationCache(const chip8TranslationCache* cache, const chip8* pristine, const char* cacheDirectory)
+{
+    // each save gets a temporary file of its own (named by the process and a count of its saves), so that instances
+    // saving the same cache at once never write into each other's files. "x" refuses a name that is somehow taken
+    static unsigned int saves = 0;
+
+    char path[1024], temporaryPath[1080];
+    translationCachePath(path, sizeof(path), pristine, cacheDirectory);
+    snprintf(temporaryPath, sizeof(temporaryPath), "%s.%lu-%u.tmp", path, getProcessId(), saves++);
+
+    translationCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, translationCacheMagic, sizeof(translationCacheMagic));
+    header.engineVersion = CHIP8_FUSED_ENGINE_VERSION;
+    header.entrySize     = sizeof(decodedInstruction);
+    header.numOfEntries  = 4096;
+    header.imageHash     = hashChip8ROM(pristine->memory, sizeof(pristine->memory));
+
+    FILE* file = fopen(temporaryPath, "wbx");
+    if (file == NULL)
+        return false;
+
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(cache, sizeof(chip8TranslationCache), 1, file) == 1;
+    written = fclose(file) == 0 && written;
+
+    // the cache is written beside its final name and then renamed, so that an instance starting up never maps half a cache
+#ifdef _WIN32
+    if (written)
+        remove(path);
+#endif
+
+    if (!written || rename(temporaryPath, path) != 0)
+    {
+        remove(temporaryPath);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "chip8.h"
+
+/*
+    a faster execution engine for chip8. instructions are decoded once into a cache (one entry per address), and
+    common sequences of instructions are fused into single superinstructions when they are decoded:
+
+        ANNN; DXYN        set the index register and draw a sprite
+        FX07; 3XNN; 1NNN  poll the delay timer
+        6XNN; 6YNN        load two registers
+        FX1E; 7YNN        advance the index register and a loop counter
+        FX33; FY65        convert a register to decimal and load the digits
+
+    jumping into the middle of a fused sequence simply executes the instructions from there on their own, since
+    every address has its own entry. writes made by FX33 and FX55 invalidate the entries they overlap, so
+    self modifying code is picked up. any other change to the memory of the instance (loading a ROM, restoring a
+    snapshot, poking it from a debugger) has to be followed by a call to resetChip8FusedEngine. a fused entry is
+    only used when the whole sequence fits in the cycles being run, so fusion pays off when many cycles are run at once
+*/
+
+// bumped whenever decoding changes, so that translation caches written by older versions are ignored
+#define CHIP8_FUSED_ENGINE_VERSION 2
+
+// the longest fused sequence, in bytes. a write to memory invalidates the entries up to this far before it
+#define MAX_FUSED_BYTES 6
+
+struct decodedInstruction
+{
+    unsigned int generation; // the entry is valid only while this matches the engine's generation
+    Byte operation;          // what to execute (one of the operations in fused.c)
+    Byte length;             // the number of chip8 instructions the entry covers (more than 1 for fused entries)
+    Byte x, y;
+    DoubleByte operand;      // NNN, NN or N, depending on the operation
+    DoubleByte operand2;     // the second operand of a fused entry
+}; typedef struct decodedInstruction decodedInstruction;
+
+struct chip8FusedEngine
+{
+    decodedInstruction entries[4096];
+
+    // bumping the generation invalidates every entry at once
+    unsigned int generation;
+
+    // the 8 pixels (as they are laid out in chip8's display) of each row a sprite can have
+    Byte spritePixels[256][8];
+}; typedef struct chip8FusedEngine chip8FusedEngine;
+
+void initChip8FusedEngine(chip8FusedEngine* engine);
+void resetChip8FusedEngine(chip8FusedEngine* engine);
+void invalidateChip8FusedEngine(chip8FusedEngine* engine, DoubleByte address, DoubleByte length);
+
+// behaves exactly like runChip8Cycles (including the watchdog), but executes through the decode cache
+chip8Status runChip8Fused(chip8FusedEngine* engine, chip8* chip8, unsigned long long cycles);
+
+/*
+    what the engine has decoded for a ROM, kept between runs so that short lived instances start warm. entries are
+    always decoded from the instance's memory as it was right after the ROM was loaded (the pristine image), so the
+    cache holds exactly what the engine would decode on its own before any self modification. on disk it lives in
+    a directory of caches, named by the hash of the pristine image and the engine version, and is ignored if
+    anything in it doesn't match
+*/
+struct chip8TranslationCache
+{
+    decodedInstruction entries[4096]; // entries with a generation of 0 weren't decoded
+}; typedef struct chip8TranslationCache chip8TranslationCache;
+
+void initChip8TranslationCache(chip8TranslationCache* cache);
+
+// adds everything the engine has decoded so far to the cache, decoding it again from the pristine image. returns the
+// number of entries that weren't in the cache already
+int captureChip8TranslationCache(chip8TranslationCache* cache, const chip8FusedEngine* engine, const chip8* pristine);
+
+// fills the engine with the cache's entries (after which it can run as if it had decoded them itself)
+void warmChip8FusedEngine(chip8FusedEngine* engine, const chip8TranslationCache* cache);
+
+// load or save the cache for the pristine image in the given directory. loading fails if there is no valid cache
+bool loadChip8TranslationCache(chip8TranslationCache* cache, const chip8* pristine, const char* cacheDirectory);
+bool saveChip8TranslationCache(const chip8TranslationCache* cache, const chip8* pristine, const char* cacheDirectory);
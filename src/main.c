@@ -8,8 +8,15 @@
 #include "SDL_mixer.h"
 
 #include "chip8.h"
-
-// width and height of the SDL window in pixels
+#include "colours.h"
+#include "framelog.h"
+#include "overlay.h"
+#include "platform.h"
+#include "rompack.h"
+#include "stats.h"
+#include "upscale.h"
+
+// width and height of the SDL window in pixels when it opens (it can be resized after)
 const int SDL_SCREEN_WIDTH  = 1024;
 const int SDL_SCREEN_HEIGHT = 512;
 
@@ -17,6 +24,12 @@ const int SDL_SCREEN_HEIGHT = 512;
 SDL_Window* window     = NULL;
 SDL_Renderer* renderer = NULL;
 
+// the display is scaled up on the cpu into a streaming texture the size of the window's drawable area
+SDL_Texture* screenTexture = NULL;
+int screenTextureWidth  = 0;
+int screenTextureHeight = 0;
+chip8Upscaler upscaler;
+
 // our instance of the chip8 structure object which will contain all the game's memory, registers, etc
 chip8 chip8Emulator;
 
@@ -26,6 +39,32 @@ SDL_Color bgColour, pixelColour;
 // the sound effect that is played when the sound timer goes off
 Mix_Chunk* soundEffect = NULL;
 
+/*
+    audio is brought up on a thread of its own, so that the ROM starts running without waiting for the audio device
+    or for sound.wav to load. it is only waited for when the ROM first makes a sound
+*/
+#define AUDIO_STARTING 0
+#define AUDIO_READY    1
+#define AUDIO_FAILED   2
+
+SDL_Thread* audioThread = NULL;
+SDL_atomic_t audioState;
+double audioReadyTime = 0.0; // written by the audio thread before it publishes AUDIO_READY
+
+// when main was entered, which startup times are measured from
+double launchTime = 0.0;
+
+// performance counters for the overlay and the metrics endpoint
+chip8Stats stats;
+chip8MetricsServer metricsServer = { INVALID_PLATFORM_SOCKET, NULL };
+
+// whether the performance overlay is currently being drawn (toggled with F1)
+bool overlayVisible = false;
+
+// the log every 60Hz frame is recorded to, if one was asked for with --record
+chip8FrameLogWriter frameLog;
+bool recording = false;
+
 // the frequency at which the chip8 should emulate a cycle at. the default recommended frequency is 500hz
 float secondsPerEmulationCycle = 1000.0f / 500.0f; // 1000 milliseconds divided by 500Hz = 1 cycle per 2 milliseconds
 
@@ -57,27 +96,20 @@ void clearScreen()
     SDL_RenderClear(renderer);
 }
 
-// initializes SDL2 for our purposes
+// initializes SDL2 for our purposes (audio is started separately, see startAudio)
 void initSDL(const char* nameOfWindow)
 {
     // initialize SDL
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0)
+    if (SDL_Init(SDL_INIT_VIDEO) < 0)
     {
         printf("SDL2 failed to initialize!");
         exit(1);
     }
 
-    // initialize SDL_mixer
-    if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0)
-    {
-        printf("SDL2_mixer failed to initialize!");
-        exit(1);
-    }
-
     // create the window and check if there was any error in doing so
     char nameBuffer[256] = "CHIP-8 Emulator: ";
     strcat(nameBuffer, nameOfWindow);
-    window = SDL_CreateWindow(nameBuffer, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SDL_SCREEN_WIDTH, SDL_SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
+    window = SDL_CreateWindow(nameBuffer, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SDL_SCREEN_WIDTH, SDL_SCREEN_HEIGHT, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
     if (window == NULL)
     {
         printf("SDL2 window failed to be created!");
@@ -93,98 +125,211 @@ void initSDL(const char* nameOfWindow)
     }
 }
 
-// defines the colour scheme that will be used based on user input (or the lack thereof)
-void setColourScheme(const char* scheme)
+// (re)creates the texture the display is drawn into, to match the size of the window's drawable area
+void resizeScreenTexture()
 {
-    bgColour.a    = 255;
-    pixelColour.a = 255;
+    int width, height;
+    if (SDL_GetRendererOutputSize(renderer, &width, &height) < 0 || width <= 0 || height <= 0)
+        return;
 
-    if (strcmp(scheme, "retro") == 0)
-    {
-        bgColour.r = 0;
-        bgColour.g = 0;
-        bgColour.b = 0;
+    if (screenTexture != NULL && width == screenTextureWidth && height == screenTextureHeight)
+        return;
 
-        pixelColour.r = 0;
-        pixelColour.g = 255;
-        pixelColour.b = 0;
-    }
-    else if (strcmp(scheme, "old") == 0)
-    {
-        bgColour.r = 46;
-        bgColour.g = 20;
-        bgColour.b = 1;
+    if (screenTexture != NULL)
+        SDL_DestroyTexture(screenTexture);
 
-        pixelColour.r = 184;
-        pixelColour.g = 116;
-        pixelColour.b = 0;
+    screenTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+    if (screenTexture == NULL)
+    {
+        printf("SDL2 texture failed to be created! %s\n", SDL_GetError());
+        exit(1);
     }
-    else if (strcmp(scheme, "pink") == 0)
+
+    screenTextureWidth  = width;
+    screenTextureHeight = height;
+}
+
+// the audio thread, which opens the device and loads the sound effect. the emulator carries on without sound if it fails
+int initAudio(void* unused)
+{
+    (void)unused;
+
+    // initialize SDL_mixer (SDL's audio subsystem is already initialized, see startAudio)
+    if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0)
     {
-        bgColour.r = 255;
-        bgColour.g = 255;
-        bgColour.b = 255;
+        printf("SDL2_mixer failed to initialize, continuing without sound\n");
+        SDL_AtomicSet(&audioState, AUDIO_FAILED);
+        return 1;
+    }
 
-        pixelColour.r = 206;
-        pixelColour.g = 0;
-        pixelColour.b = 209;
+    // load the media for the sound effect
+    soundEffect = Mix_LoadWAV("sound.wav");
+    if (soundEffect == NULL)
+    {
+        printf("Failed to load sound effect! If you'd like the emulator to have sound, you'll have to save your desired sound effect as \"sound.wav\" in the directory where the ROM file is found. Sorry for the inconvienience!");
     }
-    else // if it's none of the above, then use the default colour scheme
+
+    audioReadyTime = getTimeMilliseconds() - launchTime;
+    SDL_AtomicSet(&audioState, AUDIO_READY);
+    return 0;
+}
+
+// SDL's subsystems have to be initialized on the main thread, so only SDL_mixer's slow start is left to the audio thread
+void startAudio()
+{
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0)
     {
-        bgColour.r = 0;
-        bgColour.g = 0;
-        bgColour.b = 0;
+        printf("SDL2 audio failed to initialize, continuing without sound\n");
+        SDL_AtomicSet(&audioState, AUDIO_FAILED);
+        return;
+    }
+
+    SDL_AtomicSet(&audioState, AUDIO_STARTING);
+
+    audioThread = SDL_CreateThread(initAudio, "chip8 audio", NULL);
+    if (audioThread == NULL)
+        initAudio(NULL);
+}
 
-        pixelColour.r = 255;
-        pixelColour.g = 255;
-        pixelColour.b = 255;
+// blocks until the audio thread has finished, returning whether sound can be played
+bool waitForAudio()
+{
+    if (audioThread != NULL)
+    {
+        SDL_WaitThread(audioThread, NULL);
+        audioThread = NULL;
     }
+
+    return SDL_AtomicGet(&audioState) == AUDIO_READY;
+}
+
+// defines the colour scheme that will be used based on user input (or the lack thereof)
+void setColourScheme(const char* scheme)
+{
+    // unknown schemes fall back to the default colour scheme
+    const colourScheme* colours = findColourScheme(scheme);
+
+    bgColour.r = colours->background[0];
+    bgColour.g = colours->background[1];
+    bgColour.b = colours->background[2];
+    bgColour.a = 255;
+
+    pixelColour.r = colours->pixel[0];
+    pixelColour.g = colours->pixel[1];
+    pixelColour.b = colours->pixel[2];
+    pixelColour.a = 255;
 }
 
 /*
-    this function is called when the draw flag has been set by the emulator
-    it takes the bits that are set in the chip8's array for graphics and 
-    draws them as SDL rects, and makes them an appropriate size for the window's
-    width and height
+    this function is called when the draw flag has been set by the emulator (or every 60Hz frame with the phosphor
+    blend). the upscaler draws the chip8's graphics array straight into the screen texture, filling the window with
+    the display scaled up as far as it will go, and the texture is then copied to the window
 */
 void drawToWindow()
 {
-    clearScreen();
+    void* texturePixels;
+    int texturePitch;
 
-    // set the render colour to white so that the pixels are drawn white
-    SDL_SetRenderDrawColor(renderer, pixelColour.r, pixelColour.g, pixelColour.b, pixelColour.a);
+    if (SDL_LockTexture(screenTexture, NULL, &texturePixels, &texturePitch) < 0)
+    {
+        printf("SDL2 texture failed to be locked! %s\n", SDL_GetError());
+        return;
+    }
 
-    SDL_Rect pixelRect;
+    upscaleChip8Frame(&upscaler, chip8Emulator.pixels, (unsigned int*)texturePixels, screenTextureWidth, screenTextureHeight,
+                      texturePitch / (int)sizeof(unsigned int));
 
-    // set the width and height of each individual pixel that the chip8 wants us to draw
-    pixelRect.w = SDL_SCREEN_WIDTH / 64;
-    pixelRect.h = SDL_SCREEN_HEIGHT / 32;
+    SDL_UnlockTexture(screenTexture);
+    SDL_RenderCopy(renderer, screenTexture, NULL, NULL);
 
-    // iterate through the 32 rows that chip8 stores in its graphis array
-    for (int y = 0; y < 32; y++)
+    if (overlayVisible)
+        drawStatsOverlay(renderer, &stats, pixelColour);
+}
+
+/*
+    loads the ROM with the given name (or hash, in hex) from a pack, and takes on its key map. the ROM's speed is used
+    too, unless the speed was given on the command line
+*/
+bool loadFromPack(const char* packFile, const char* rom, bool useROMSpeed)
+{
+    chip8ROMPack pack;
+    if (!openChip8ROMPack(&pack, packFile))
+        return false;
+
+    const chip8ROMEntry* entry = findChip8ROMByName(&pack, rom);
+
+    char* end;
+    unsigned long long hash = strtoull(rom, &end, 16);
+    if (entry == NULL && *end == '\0')
+        entry = findChip8ROMByHash(&pack, hash);
+
+    if (entry == NULL)
     {
-        // iterate over the 64 columns that chip8 stores in its graphics array
-        for (int x = 0; x < 64; x++)
+        printf("There is no ROM named or hashed %s in %s\n", rom, packFile);
+        closeChip8ROMPack(&pack);
+        return false;
+    }
+
+    loadChip8FromPack(&chip8Emulator, &pack, entry);
+
+    // SDL's keycodes for letters and digits are their lowercase characters
+    for (int key = 0; key < 16; key++)
+        chip8keys[key] = (Byte)entry->keyMap[key];
+
+    if (useROMSpeed && entry->instructionsPerSecond > 0)
+        secondsPerEmulationCycle = 1000.0f / entry->instructionsPerSecond;
+
+    printf("Loaded %s from %s\n", getChip8ROMName(&pack, entry), packFile);
+
+    closeChip8ROMPack(&pack);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    launchTime = getTimeMilliseconds();
+
+    // options start with "--" and can appear anywhere, everything else is a positional argument
+    char* positionalArgs[4] = { argv[0] };
+    int positionalCount = 1;
+    int metricsPort = 0;
+    const char* recordFile = NULL;
+    const char* packFile = NULL;
+    chip8UpscaleFilter filter = UPSCALE_NEAREST;
+    bool phosphor = false;
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if (strncmp(argv[arg], "--metrics-port=", 15) == 0)
+            metricsPort = atoi(argv[arg] + 15);
+        else if (strcmp(argv[arg], "--overlay") == 0)
+            overlayVisible = true;
+        else if (strncmp(argv[arg], "--record=", 9) == 0)
+            recordFile = argv[arg] + 9;
+        else if (strncmp(argv[arg], "--pack=", 7) == 0)
+            packFile = argv[arg] + 7;
+        else if (strncmp(argv[arg], "--filter=", 9) == 0)
         {
-            // check to see if the pixel is set 
-            if (chip8Emulator.pixels[x + y * 64])
+            if (!findChip8UpscaleFilter(argv[arg] + 9, &filter))
             {
-                // convert the pixels coordinates from chip8 to SDL screen coordinates
-                pixelRect.x = x * pixelRect.w;
-                pixelRect.y = y * pixelRect.h;
-
-                // draw the rectangle to the screen
-                SDL_RenderFillRect(renderer, &pixelRect);
+                printf("Unknown filter %s (the filters are nearest, scale2x and hq2x)\n", argv[arg] + 9);
+                return 1;
             }
         }
+        else if (strcmp(argv[arg], "--phosphor") == 0)
+            phosphor = true;
+        else if (positionalCount < 4)
+            positionalArgs[positionalCount++] = argv[arg];
+        else
+            positionalCount++;
     }
-}
 
-int main(int argc, char** argv)
-{
+    argc = positionalCount;
+    argv = positionalArgs;
+
     if (argc < 2 || argc > 4)
     {
-        printf("Usage is: chip8 <ROM file> <optional: colour scheme> <optional: milliseconds per emulation cycle>");
+        printf("Usage is: chip8 <ROM file> <optional: colour scheme> <optional: milliseconds per emulation cycle> [--overlay] [--metrics-port=<port>] [--record=<frame log>] [--pack=<ROM pack> (the ROM is then a name or hash in the pack)] [--filter=<nearest, scale2x or hq2x>] [--phosphor]");
         return 1;
     }
 
@@ -194,6 +339,13 @@ int main(int argc, char** argv)
     else
         setColourScheme("default");
 
+    Byte background[3] = { bgColour.r, bgColour.g, bgColour.b };
+    Byte pixel[3]      = { pixelColour.r, pixelColour.g, pixelColour.b };
+
+    initChip8Upscaler(&upscaler, filter, background, pixel);
+    if (phosphor)
+        upscaler.phosphorDecay = DEFAULT_PHOSPHOR_DECAY;
+
     // if the user has passed in a value for the delay (in milliseconds)
     if (argc == 4)
         secondsPerEmulationCycle = strtof(argv[3], NULL);
@@ -201,21 +353,26 @@ int main(int argc, char** argv)
     // initialize our instance of the chip8 object
     initChip8(&chip8Emulator);
 
-    // load the ROM file into the chip8 instance's memory
-    if (!loadChip8(argv[1], &chip8Emulator))
+    // load the ROM file (or the ROM from the pack) into the chip8 instance's memory
+    if (packFile != NULL ? !loadFromPack(packFile, argv[1], argc < 4) : !loadChip8(argv[1], &chip8Emulator))
     {
         printf("Failed to load chip, closing program\n");
         return 1;
     }
     
     initSDL(argv[1]);
+    resizeScreenTexture();
+    startAudio();
 
-    // load the media for the sound effect
-    soundEffect = Mix_LoadWAV("sound.wav");
-    if (soundEffect == NULL)
-    {
-        printf("Failed to load sound effect! If you'd like the emulator to have sound, you'll have to save your desired sound effect as \"sound.wav\" in the directory where the ROM file is found. Sorry for the inconvienience!");
-    }
+    printf("Scaling with %s on the %s kernel\n", describeChip8UpscaleFilter(filter), describeChip8UpscaleKernel(upscaler.kernel));
+
+    // start counting, and open the metrics endpoint if one was asked for (each instance on a host needs its own port)
+    initChip8Stats(&stats, 1000.0f / secondsPerEmulationCycle);
+    if (metricsPort > 0 && metricsPort < 65536)
+        initMetricsServer(&metricsServer, (unsigned short)metricsPort, argv[1]);
+
+    if (recordFile != NULL)
+        recording = openChip8FrameLogWriter(&frameLog, recordFile, DEFAULT_KEYFRAME_INTERVAL);
 
     // clear the screen and update it immediately after the window opens
     clearScreen();
@@ -233,22 +390,37 @@ int main(int argc, char** argv)
     // store the ticks per second into the frequency variable
     QueryPerformanceFrequency(&frequency);
 
-    //Mix_PlayChannel(-1, soundEffect, 1);
-
     bool running = true;
     while (running)
     {
         // set the t1 variable to the current number of ticks
         QueryPerformanceCounter(&t1);
 
+        // whether a 60Hz frame has gone by on this pass through the loop
+        bool frameTick = false;
+
         SDL_Event e;
         while (SDL_PollEvent(&e))
         {
             if (e.type == SDL_QUIT)
                 running = false;
+
+            // the texture follows the window's size, and the display is redrawn to fill it
+            else if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+            {
+                resizeScreenTexture();
+                chip8Emulator.drawFlag = true;
+            }
         
             else if (e.type == SDL_KEYDOWN)
             {
+                // F1 toggles the performance overlay
+                if (e.key.keysym.sym == SDLK_F1)
+                {
+                    overlayVisible = !overlayVisible;
+                    chip8Emulator.drawFlag = true;
+                }
+
                 for (int key = 0; key < 16; key++)
                     // if the key that was pressed down is one of the keys that chip8 uses
                     if (e.key.keysym.sym == chip8keys[key])
@@ -269,26 +441,72 @@ int main(int argc, char** argv)
         {
             // set the t2 variable to the current number of ticks
             QueryPerformanceCounter(&t2);
-            emulateChip8Cycle(&chip8Emulator);
+            // a trapped ROM stops being emulated, but the window stays open so that its last frame can be seen
+            if (chip8Emulator.trap == CHIP8_OK)
+            {
+                if (emulateChip8Cycle(&chip8Emulator) != CHIP8_OK)
+                {
+                    printf("ROM trapped (%s) at %.3X: opcode %.4X\n",
+                        describeChip8Status(chip8Emulator.trap), chip8Emulator.trapAddress, chip8Emulator.trapOpcode);
+                }
+
+                stats.instructions++;
+            }
         }
 
         // update the sound and delay timers of the chip8 emulator at a frequency of 60Hz
-        if ((t1.QuadPart - chip8Timer.QuadPart) * 1000.0f / frequency.QuadPart >= 1000.0f / 60.0f)
+        float millisecondsSinceTimerUpdate = (t1.QuadPart - chip8Timer.QuadPart) * 1000.0f / frequency.QuadPart;
+        if (millisecondsSinceTimerUpdate >= 1000.0f / 60.0f)
         {
+            // if the loop fell behind by more than a whole frame, every frame in between was skipped
+            if (millisecondsSinceTimerUpdate >= 2.0f * 1000.0f / 60.0f)
+                stats.skippedFrames += (unsigned long long)(millisecondsSinceTimerUpdate / (1000.0f / 60.0f)) - 1;
+
             QueryPerformanceCounter(&chip8Timer);
             updateChip8Timers(&chip8Emulator);
+            frameTick = true;
+
+            // the log holds one frame per 60Hz tick, so that a frame's number is also its time in the session
+            if (recording && !appendChip8FrameLog(&frameLog, chip8Emulator.pixels))
+            {
+                printf("Failed to record a frame, recording stopped\n");
+                closeChip8FrameLogWriter(&frameLog);
+                recording = false;
+            }
         }
 
-        // when the sound timer has gone off
+        // when the sound timer has gone off. the first sound is the first time audio is needed, so it is waited for here
+        // if it still isn't ready
         if (chip8Emulator.soundFlag)
         {
-            Mix_PlayChannel(-1, soundEffect, 1);
+            if (waitForAudio() && soundEffect != NULL)
+                Mix_PlayChannel(-1, soundEffect, 1);
+
             chip8Emulator.soundFlag = false;
         }
 
-        // when an opcode has come in that has indicated we need to update the screen
-        if (chip8Emulator.drawFlag)
+        if (stats.timeToAudio == 0.0 && SDL_AtomicGet(&audioState) == AUDIO_READY)
+            stats.timeToAudio = audioReadyTime;
+
+        // refresh the derived rates, and answer any pending metrics scrape
+        sampleChip8Stats(&stats, t1.QuadPart * 1000.0 / frequency.QuadPart);
+        serveMetrics(&metricsServer, &stats);
+
+        // the overlay has to be redrawn whenever its numbers change, even if the game's pixels haven't
+        if (overlayVisible && stats.updated)
+            chip8Emulator.drawFlag = true;
+
+        stats.updated = false;
+
+        /*
+            when an opcode has come in that has indicated we need to update the screen. the phosphor blend fades the
+            display once per frame instead, so with it the screen is drawn on every 60Hz frame (and only then, which also
+            keeps sprites that are erased and redrawn within a frame from flickering)
+        */
+        if (phosphor ? frameTick : chip8Emulator.drawFlag)
         {
+            double frameStart = getTimeMilliseconds();
+
             drawToWindow();
 
             // reset the draw flag
@@ -296,11 +514,26 @@ int main(int argc, char** argv)
 
             // update the sdl screen
             SDL_RenderPresent(renderer);
+
+            stats.lastFrameTime = getTimeMilliseconds() - frameStart;
+            stats.presents++;
+
+            if (stats.timeToFirstFrame == 0.0)
+            {
+                stats.timeToFirstFrame = getTimeMilliseconds() - launchTime;
+                printf("First frame presented %.1f ms after launch\n", stats.timeToFirstFrame);
+            }
         }
     }
 
+    if (recording)
+        closeChip8FrameLogWriter(&frameLog);
+
     // cleanup SDL2
+    closeMetricsServer(&metricsServer);
+    SDL_DestroyTexture(screenTexture);
     SDL_DestroyWindow(window);
+    waitForAudio();
     Mix_FreeChunk(soundEffect);
     Mix_Quit();
     SDL_Quit();
@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "overlay.h"
+
+// every pixel of the overlay's font is drawn as a square of this many screen pixels
+#define OVERLAY_PIXEL_SIZE 3
+
+// the number of lines of text the overlay shows
+#define OVERLAY_LINES 7
+
+/*
+    a tiny 3x5 font holding only the characters the overlay needs (SDL has no text rendering of its own)
+    each glyph is 5 rows, and the 3 lowest bits of each row are the pixels from left to right
+*/
+static const char glyphCharacters[] = "0123456789ACDEFGIKMNOPRSTU.%/";
+static const unsigned char glyphs[][5] =
+{
+    { 7, 5, 5, 5, 7 }, // 0
+    { 2, 6, 2, 2, 7 }, // 1
+    { 7, 1, 7, 4, 7 }, // 2
+    { 7, 1, 7, 1, 7 }, // 3
+    { 5, 5, 7, 1, 1 }, // 4
+    { 7, 4, 7, 1, 7 }, // 5
+    { 7, 4, 7, 5, 7 }, // 6
+    { 7, 1, 1, 2, 2 }, // 7
+    { 7, 5, 7, 5, 7 }, // 8
+    { 7, 5, 7, 1, 7 }, // 9
+    { 2, 5, 7, 5, 5 }, // A
+    { 7, 4, 4, 4, 7 }, // C
+    { 6, 5, 5, 5, 6 }, // D
+    { 7, 4, 6, 4, 7 }, // E
+    { 7, 4, 6, 4, 4 }, // F
+    { 7, 4, 5, 5, 7 }, // G
+    { 7, 2, 2, 2, 7 }, // I
+    { 5, 5, 6, 5, 5 }, // K
+    { 5, 7, 7, 5, 5 }, // M
+    { 6, 5, 5, 5, 5 }, // N
+    { 7, 5, 5, 5, 7 }, // O
+    { 7, 5, 7, 4, 4 }, // P
+    { 6, 5, 6, 5, 5 }, // R
+    { 7, 4, 7, 1, 7 }, // S
+    { 7, 2, 2, 2, 2 }, // T
+    { 5, 5, 5, 5, 7 }, // U
+    { 0, 0, 0, 0, 2 }, // .
+    { 5, 1, 2, 4, 5 }, // %
+    { 1, 1, 2, 4, 4 }, // /
+};
+
+// draws a single line of text with its top left corner at (x, y). characters without a glyph are drawn as spaces
+static void drawOverlayText(SDL_Renderer* renderer, const char* text, int x, int y)
+{
+    SDL_Rect pixelRect;
+    pixelRect.w = OVERLAY_PIXEL_SIZE;
+    pixelRect.h = OVERLAY_PIXEL_SIZE;
+
+    for (; *text != '\0'; text++, x += 4 * OVERLAY_PIXEL_SIZE)
+    {
+        const char* glyph = strchr(glyphCharacters, *text);
+        if (glyph == NULL || *text == ' ')
+            continue;
+
+        const unsigned char* rows = glyphs[glyph - glyphCharacters];
+        for (int row = 0; row < 5; row++)
+        {
+            for (int column = 0; column < 3; column++)
+            {
+                if (rows[row] & (4 >> column))
+                {
+                    pixelRect.x = x + column * OVERLAY_PIXEL_SIZE;
+                    pixelRect.y = y + row * OVERLAY_PIXEL_SIZE;
+                    SDL_RenderFillRect(renderer, &pixelRect);
+                }
+            }
+        }
+    }
+}
+
+void drawStatsOverlay(SDL_Renderer* renderer, const chip8Stats* stats, SDL_Color textColour)
+{
+    char lines[OVERLAY_LINES][48];
+    snprintf(lines[0], sizeof(lines[0]), "IPS %.0f", stats->instructionsPerSecond);
+    snprintf(lines[1], sizeof(lines[1]), "SPEED %.1f%% OF %.0f", stats->speedRatio * 100.0, stats->targetInstructionsPerSecond);
+    snprintf(lines[2], sizeof(lines[2]), "FRAME %.2f MS", stats->lastFrameTime);
+    snprintf(lines[3], sizeof(lines[3]), "PRESENTS/S %.1f", stats->presentsPerSecond);
+    snprintf(lines[4], sizeof(lines[4]), "SKIPPED %llu", stats->skippedFrames);
+    snprintf(lines[5], sizeof(lines[5]), "CPU %.1f%%", stats->cpuPercent);
+    snprintf(lines[6], sizeof(lines[6]), "FIRST FRAME %.1f MS", stats->timeToFirstFrame);
+
+    // darken the area behind the text so that it stays readable over the game's pixels
+    SDL_Rect background;
+    background.x = 0;
+    background.y = 0;
+    background.w = 4 * OVERLAY_PIXEL_SIZE * 24;
+    background.h = OVERLAY_LINES * 7 * OVERLAY_PIXEL_SIZE + OVERLAY_PIXEL_SIZE * 2;
+
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 192);
+    SDL_RenderFillRect(renderer, &background);
+
+    SDL_SetRenderDrawColor(renderer, textColour.r, textColour.g, textColour.b, 255);
+    for (int line = 0; line < OVERLAY_LINES; line++)
+        drawOverlayText(renderer, lines[line], OVERLAY_PIXEL_SIZE * 2, OVERLAY_PIXEL_SIZE * 2 + line * 7 * OVERLAY_PIXEL_SIZE);
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "SDL.h"
+
+#include "stats.h"
+
+// draws the performance counters in the top left corner of the window (on top of whatever has already been drawn)
+void drawStatsOverlay(SDL_Renderer* renderer, const chip8Stats* stats, SDL_Color textColour);
@@ -0,0 +1,732 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <Windows.h>
+    #include <conio.h>
+    #include <io.h>
+#else
+    #include <arpa/inet.h>
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <netinet/in.h>
+    #include <pthread.h>
+    #include <sys/mman.h>
+    #include <sys/resource.h>
+    #include <sys/select.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/uio.h>
+    #include <sched.h>
+    #include <time.h>
+    #include <unistd.h>
+#endif
+
+#include "platform.h"
+
+double getTimeMilliseconds(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency, ticks;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&ticks);
+
+    return ticks.QuadPart * 1000.0 / frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+#endif
+}
+
+double getProcessCPUMilliseconds(void)
+{
+#ifdef _WIN32
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+        return 0.0;
+
+    // FILETIMEs count in units of 100 nanoseconds
+    ULARGE_INTEGER kernel, user;
+    kernel.LowPart  = kernelTime.dwLowDateTime;
+    kernel.HighPart = kernelTime.dwHighDateTime;
+    user.LowPart    = userTime.dwLowDateTime;
+    user.HighPart   = userTime.dwHighDateTime;
+
+    return (kernel.QuadPart + user.QuadPart) / 10000.0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0.0;
+
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+#endif
+}
+
+PlatformSocket openLoopbackListener(unsigned short port, bool blocking)
+{
+#ifdef _WIN32
+    // winsock has to be started once per process before any socket can be created
+    static bool winsockStarted = false;
+    if (!winsockStarted)
+    {
+        WSADATA wsaData;
+        if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+            return INVALID_PLATFORM_SOCKET;
+
+        winsockStarted = true;
+    }
+
+    SOCKET listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == INVALID_SOCKET)
+        return INVALID_PLATFORM_SOCKET;
+#else
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0)
+        return INVALID_PLATFORM_SOCKET;
+#endif
+
+    // allow the port to be reused straight away when an instance restarts
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 4) != 0)
+    {
+        closeConnection((PlatformSocket)listener);
+        return INVALID_PLATFORM_SOCKET;
+    }
+
+    if (!blocking)
+    {
+#ifdef _WIN32
+        u_long nonBlocking = 1;
+        ioctlsocket(listener, FIONBIO, &nonBlocking);
+#else
+        fcntl(listener, F_SETFL, fcntl(listener, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    }
+
+    return (PlatformSocket)listener;
+}
+
+PlatformSocket acceptConnection(PlatformSocket listener)
+{
+#ifdef _WIN32
+    SOCKET connection = accept((SOCKET)listener, NULL, NULL);
+    if (connection == INVALID_SOCKET)
+        return INVALID_PLATFORM_SOCKET;
+
+    // sockets accepted from a non blocking listener inherit its mode, so put the connection back into blocking mode
+    u_long nonBlocking = 0;
+    ioctlsocket(connection, FIONBIO, &nonBlocking);
+#else
+    int connection = accept((int)listener, NULL, NULL);
+    if (connection < 0)
+        return INVALID_PLATFORM_SOCKET;
+
+    fcntl(connection, F_SETFL, fcntl(connection, F_GETFL, 0) & ~O_NONBLOCK);
+#endif
+
+    return (PlatformSocket)connection;
+}
+
+bool sendToConnection(PlatformSocket connection, const char* buffer, int length)
+{
+    while (length > 0)
+    {
+#ifdef _WIN32
+        int sent = send((SOCKET)connection, buffer, length, 0);
+#else
+        int sent = (int)send((int)connection, buffer, length, MSG_NOSIGNAL);
+#endif
+        if (sent <= 0)
+            return false;
+
+        buffer += sent;
+        length -= sent;
+    }
+
+    return true;
+}
+
+bool waitForConnectionData(PlatformSocket connection, int timeoutMilliseconds)
+{
+    fd_set readable;
+    FD_ZERO(&readable);
+#ifdef _WIN32
+    FD_SET((SOCKET)connection, &readable);
+#else
+    FD_SET((int)connection, &readable);
+#endif
+
+    struct timeval timeout;
+    timeout.tv_sec  = timeoutMilliseconds / 1000;
+    timeout.tv_usec = (timeoutMilliseconds % 1000) * 1000;
+
+    // the first argument is ignored by winsock
+    return select((int)connection + 1, &readable, NULL, NULL, &timeout) > 0;
+}
+
+bool consoleInputWaiting(void)
+{
+#ifdef _WIN32
+    return _isatty(_fileno(stdin)) && _kbhit();
+#else
+    if (!isatty(STDIN_FILENO))
+        return false;
+
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(STDIN_FILENO, &readable);
+
+    struct timeval timeout = { 0, 0 };
+    return select(STDIN_FILENO + 1, &readable, NULL, NULL, &timeout) > 0;
+#endif
+}
+
+int receiveFromConnection(PlatformSocket connection, char* buffer, int length)
+{
+#ifdef _WIN32
+    return recv((SOCKET)connection, buffer, length, 0);
+#else
+    return (int)recv((int)connection, buffer, length, 0);
+#endif
+}
+
+void closeConnection(PlatformSocket connection)
+{
+    if (connection == INVALID_PLATFORM_SOCKET)
+        return;
+
+#ifdef _WIN32
+    closesocket((SOCKET)connection);
+#else
+    close((int)connection);
+#endif
+}
+
+bool writeBuffers(int fileDescriptor, const PlatformBuffer* buffers, int numOfBuffers)
+{
+#ifdef _WIN32
+    // windows has no writev for plain file descriptors, so each buffer is written on its own
+    for (int b = 0; b < numOfBuffers; b++)
+    {
+        const char* data = buffers[b].data;
+        size_t remaining = buffers[b].length;
+
+        while (remaining > 0)
+        {
+            int written = _write(fileDescriptor, data, remaining > 0x40000000 ? 0x40000000 : (unsigned int)remaining);
+            if (written <= 0)
+                return false;
+
+            data += written;
+            remaining -= written;
+        }
+    }
+
+    return true;
+#else
+    if (numOfBuffers > MAX_PLATFORM_BUFFERS)
+        return false;
+
+    struct iovec vectors[MAX_PLATFORM_BUFFERS];
+    for (int b = 0; b < numOfBuffers; b++)
+    {
+        vectors[b].iov_base = (void*)buffers[b].data;
+        vectors[b].iov_len  = buffers[b].length;
+    }
+
+    // pipes can take fewer bytes than were offered, in which case the rest is written from where it stopped
+    struct iovec* next = vectors;
+    while (numOfBuffers > 0)
+    {
+        ssize_t written = writev(fileDescriptor, next, numOfBuffers);
+        if (written < 0 && errno == EINTR)
+            continue;
+
+        if (written < 0)
+            return false;
+
+        while (numOfBuffers > 0 && (size_t)written >= next->iov_len)
+        {
+            written -= next->iov_len;
+            next++;
+            numOfBuffers--;
+        }
+
+        if (numOfBuffers > 0)
+        {
+            next->iov_base = (char*)next->iov_base + written;
+            next->iov_len -= written;
+        }
+    }
+
+    return true;
+#endif
+}
+
+// turns a plain name into the form the system wants for shared memory objects
+static void sharedMemoryName(const char* name, char* systemName, size_t size)
+{
+#ifdef _WIN32
+    snprintf(systemName, size, "Local\\%s", name);
+#else
+    snprintf(systemName, size, "/%s", name);
+#endif
+}
+
+bool createSharedMemory(PlatformSharedMemory* memory, const char* name, size_t size)
+{
+    char systemName[256];
+    sharedMemoryName(name, systemName, sizeof(systemName));
+
+    memory->address = NULL;
+    memory->size    = size;
+    memory->handle  = 0;
+
+#ifdef _WIN32
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                        (DWORD)((unsigned long long)size >> 32), (DWORD)size, systemName);
+    if (mapping == NULL)
+        return false;
+
+    memory->address = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (memory->address == NULL)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    memory->handle = (long long)mapping;
+    memset(memory->address, 0, size);
+#else
+    // a region left behind by a server that crashed is replaced rather than reused
+    shm_unlink(systemName);
+
+    int descriptor = shm_open(systemName, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (descriptor < 0)
+        return false;
+
+    if (ftruncate(descriptor, (off_t)size) != 0)
+    {
+        close(descriptor);
+        shm_unlink(systemName);
+        return false;
+    }
+
+    void* address = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+
+    if (address == MAP_FAILED)
+    {
+        shm_unlink(systemName);
+        return false;
+    }
+
+    memory->address = address;
+#endif
+
+    return true;
+}
+
+bool openSharedMemory(PlatformSharedMemory* memory, const char* name)
+{
+    char systemName[256];
+    sharedMemoryName(name, systemName, sizeof(systemName));
+
+    memory->address = NULL;
+    memory->size    = 0;
+    memory->handle  = 0;
+
+#ifdef _WIN32
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, systemName);
+    if (mapping == NULL)
+        return false;
+
+    memory->address = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (memory->address == NULL)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    MEMORY_BASIC_INFORMATION information;
+    VirtualQuery(memory->address, &information, sizeof(information));
+
+    memory->size   = information.RegionSize;
+    memory->handle = (long long)mapping;
+#else
+    int descriptor = shm_open(systemName, O_RDWR, 0);
+    if (descriptor < 0)
+        return false;
+
+    struct stat status;
+    if (fstat(descriptor, &status) != 0 || status.st_size <= 0)
+    {
+        close(descriptor);
+        return false;
+    }
+
+    void* address = mmap(NULL, (size_t)status.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+
+    if (address == MAP_FAILED)
+        return false;
+
+    memory->address = address;
+    memory->size    = (size_t)status.st_size;
+#endif
+
+    return true;
+}
+
+void closeSharedMemory(PlatformSharedMemory* memory, const char* name, bool remove)
+{
+    if (memory->address == NULL)
+        return;
+
+#ifdef _WIN32
+    // windows removes the mapping's name once every handle to it has been closed
+    (void)name;
+    (void)remove;
+
+    UnmapViewOfFile(memory->address);
+    CloseHandle((HANDLE)memory->handle);
+#else
+    munmap(memory->address, memory->size);
+
+    if (remove)
+    {
+        char systemName[256];
+        sharedMemoryName(name, systemName, sizeof(systemName));
+        shm_unlink(systemName);
+    }
+#endif
+
+    memory->address = NULL;
+}
+
+bool mapFile(PlatformMappedFile* file, const char* path)
+{
+    file->data   = NULL;
+    file->size   = 0;
+    file->handle = 0;
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(handle);
+        return false;
+    }
+
+    // the mapping keeps the file open by itself
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(handle);
+
+    if (mapping == NULL)
+        return false;
+
+    file->data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (file->data == NULL)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    file->size   = (size_t)size.QuadPart;
+    file->handle = (long long)mapping;
+#else
+    int descriptor = open(path, O_RDONLY);
+    if (descriptor < 0)
+        return false;
+
+    struct stat status;
+    if (fstat(descriptor, &status) != 0 || status.st_size <= 0)
+    {
+        close(descriptor);
+        return false;
+    }
+
+    void* data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+
+    if (data == MAP_FAILED)
+        return false;
+
+    file->data = data;
+    file->size = (size_t)status.st_size;
+#endif
+
+    return true;
+}
+
+void unmapFile(PlatformMappedFile* file)
+{
+    if (file->data == NULL)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(file->data);
+    CloseHandle((HANDLE)file->handle);
+#else
+    munmap((void*)file->data, file->size);
+#endif
+
+    file->data = NULL;
+}
+
+void sleepMilliseconds(int milliseconds)
+{
+#ifdef _WIN32
+    Sleep(milliseconds);
+#else
+    struct timespec duration = { milliseconds / 1000, (milliseconds % 1000) * 1000000L };
+    nanosleep(&duration, NULL);
+#endif
+}
+
+void yieldThread(void)
+{
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+int getProcessorCount(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+unsigned long getProcessId(void)
+{
+#ifdef _WIN32
+    return (unsigned long)GetCurrentProcessId();
+#else
+    return (unsigned long)getpid();
+#endif
+}
+
+// what a new thread is started with, since neither system calls the function with our signature
+struct threadStart
+{
+    PlatformThreadFunction function;
+    void* argument;
+}; typedef struct threadStart threadStart;
+
+#ifdef _WIN32
+static DWORD WINAPI runThread(LPVOID parameter)
+#else
+static void* runThread(void* parameter)
+#endif
+{
+    threadStart start = *(threadStart*)parameter;
+    free(parameter);
+
+    start.function(start.argument);
+    return 0;
+}
+
+bool startThread(PlatformThread* thread, PlatformThreadFunction function, void* argument)
+{
+    threadStart* start = (threadStart*)malloc(sizeof(threadStart));
+    if (start == NULL)
+        return false;
+
+    start->function = function;
+    start->argument = argument;
+
+#ifdef _WIN32
+    thread->handle = CreateThread(NULL, 0, runThread, start, 0, NULL);
+    if (thread->handle == NULL)
+    {
+        free(start);
+        return false;
+    }
+#else
+    pthread_t* handle = (pthread_t*)malloc(sizeof(pthread_t));
+    if (handle == NULL || pthread_create(handle, NULL, runThread, start) != 0)
+    {
+        free(handle);
+        free(start);
+        return false;
+    }
+
+    thread->handle = handle;
+#endif
+
+    return true;
+}
+
+void joinThread(PlatformThread* thread)
+{
+    if (thread->handle == NULL)
+        return;
+
+#ifdef _WIN32
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(*(pthread_t*)thread->handle, NULL);
+    free(thread->handle);
+#endif
+
+    thread->handle = NULL;
+}
+
+// on windows the lock and condition variable are a single pointer each, and live in the handle itself
+bool createLock(PlatformLock* lock)
+{
+#ifdef _WIN32
+    InitializeSRWLock((PSRWLOCK)&lock->handle);
+    return true;
+#else
+    lock->handle = malloc(sizeof(pthread_mutex_t));
+    if (lock->handle == NULL || pthread_mutex_init((pthread_mutex_t*)lock->handle, NULL) != 0)
+    {
+        free(lock->handle);
+        lock->handle = NULL;
+        return false;
+    }
+
+    return true;
+#endif
+}
+
+void destroyLock(PlatformLock* lock)
+{
+#ifndef _WIN32
+    if (lock->handle != NULL)
+    {
+        pthread_mutex_destroy((pthread_mutex_t*)lock->handle);
+        free(lock->handle);
+    }
+#endif
+
+    lock->handle = NULL;
+}
+
+void acquireLock(PlatformLock* lock)
+{
+#ifdef _WIN32
+    AcquireSRWLockExclusive((PSRWLOCK)&lock->handle);
+#else
+    pthread_mutex_lock((pthread_mutex_t*)lock->handle);
+#endif
+}
+
+void releaseLock(PlatformLock* lock)
+{
+#ifdef _WIN32
+    ReleaseSRWLockExclusive((PSRWLOCK)&lock->handle);
+#else
+    pthread_mutex_unlock((pthread_mutex_t*)lock->handle);
+#endif
+}
+
+bool createCondition(PlatformCondition* condition)
+{
+#ifdef _WIN32
+    InitializeConditionVariable((PCONDITION_VARIABLE)&condition->handle);
+    return true;
+#else
+    // waits time out against the monotonic clock, so that changes to the wall clock don't stretch them (macOS has
+    // no clock attribute, and waits relative to the time of the call instead)
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+#ifndef __APPLE__
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+#endif
+
+    condition->handle = malloc(sizeof(pthread_cond_t));
+    bool created = condition->handle != NULL && pthread_cond_init((pthread_cond_t*)condition->handle, &attributes) == 0;
+    pthread_condattr_destroy(&attributes);
+
+    if (!created)
+    {
+        free(condition->handle);
+        condition->handle = NULL;
+    }
+
+    return created;
+#endif
+}
+
+void destroyCondition(PlatformCondition* condition)
+{
+#ifndef _WIN32
+    if (condition->handle != NULL)
+    {
+        pthread_cond_destroy((pthread_cond_t*)condition->handle);
+        free(condition->handle);
+    }
+#endif
+
+    condition->handle = NULL;
+}
+
+void waitCondition(PlatformCondition* condition, PlatformLock* lock, int timeoutMilliseconds)
+{
+#ifdef _WIN32
+    SleepConditionVariableSRW((PCONDITION_VARIABLE)&condition->handle, (PSRWLOCK)&lock->handle,
+        timeoutMilliseconds < 0 ? INFINITE : (DWORD)timeoutMilliseconds, 0);
+#else
+    if (timeoutMilliseconds < 0)
+    {
+        pthread_cond_wait((pthread_cond_t*)condition->handle, (pthread_mutex_t*)lock->handle);
+        return;
+    }
+
+#ifdef __APPLE__
+    struct timespec duration = { timeoutMilliseconds / 1000, (timeoutMilliseconds % 1000) * 1000000L };
+    pthread_cond_timedwait_relative_np((pthread_cond_t*)condition->handle, (pthread_mutex_t*)lock->handle, &duration);
+#else
+    struct timespec until;
+    clock_gettime(CLOCK_MONOTONIC, &until);
+    until.tv_sec  += timeoutMilliseconds / 1000;
+    until.tv_nsec += (timeoutMilliseconds % 1000) * 1000000L;
+
+    if (until.tv_nsec >= 1000000000L)
+    {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000L;
+    }
+
+    pthread_cond_timedwait((pthread_cond_t*)condition->handle, (pthread_mutex_t*)lock->handle, &until);
+#endif
+#endif
+}
+
+void signalCondition(PlatformCondition* condition)
+{
+#ifdef _WIN32
+    WakeConditionVariable((PCONDITION_VARIABLE)&condition->handle);
+#else
+    pthread_cond_signal((pthread_cond_t*)condition->handle);
+#endif
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+    small wrappers around the few operating system facilities that are not portable between
+    windows and posix systems (clocks, loopback sockets, vectored file output, shared memory, mapped files and threads)
+*/
+
+// a socket handle that is wide enough to hold both a windows SOCKET and a posix file descriptor
+typedef long long PlatformSocket;
+
+#define INVALID_PLATFORM_SOCKET (-1)
+
+// returns a monotonic timestamp in milliseconds (only useful for measuring differences)
+double getTimeMilliseconds(void);
+
+// returns the total cpu time (user + system) that this process has consumed, in milliseconds
+double getProcessCPUMilliseconds(void);
+
+// opens a tcp socket listening on 127.0.0.1:port. a non blocking listener makes acceptConnection return immediately
+PlatformSocket openLoopbackListener(unsigned short port, bool blocking);
+
+// accepts a pending connection, or returns INVALID_PLATFORM_SOCKET if there is none (or on error)
+PlatformSocket acceptConnection(PlatformSocket listener);
+
+// sends the whole buffer, returning false if the connection was lost
+bool sendToConnection(PlatformSocket connection, const char* buffer, int length);
+
+// waits up to timeoutMilliseconds for the connection to have data to read, returning true if it does
+bool waitForConnectionData(PlatformSocket connection, int timeoutMilliseconds);
+
+// returns true if a line typed into the console is waiting to be read. always false when stdin isn't a terminal (e.g.
+// commands piped in from a file), whose input is never waiting to interrupt anything
+bool consoleInputWaiting(void);
+
+// receives up to length bytes, returning the number of bytes read (0 or less once the peer has gone)
+int receiveFromConnection(PlatformSocket connection, char* buffer, int length);
+
+void closeConnection(PlatformSocket connection);
+
+// one of the pieces of a vectored write
+struct PlatformBuffer
+{
+    const void* data;
+    size_t length;
+}; typedef struct PlatformBuffer PlatformBuffer;
+
+#define MAX_PLATFORM_BUFFERS 8
+
+/*
+    writes the buffers to the file descriptor one after another in a single call where the system allows it (writev),
+    without gathering them into one buffer first. returns false if the write failed (e.g. the reading end of a pipe closed)
+*/
+bool writeBuffers(int fileDescriptor, const PlatformBuffer* buffers, int numOfBuffers);
+
+// a named region of memory shared between processes
+struct PlatformSharedMemory
+{
+    void* address;
+    size_t size;
+    long long handle; // the file mapping on windows (the mapping on posix needs no handle once it is mapped)
+}; typedef struct PlatformSharedMemory PlatformSharedMemory;
+
+// creates (or replaces) the named region, zero filled, and maps it. names are plain words like "chip8-env"
+bool createSharedMemory(PlatformSharedMemory* memory, const char* name, size_t size);
+
+// maps an existing region created by another process
+bool openSharedMemory(PlatformSharedMemory* memory, const char* name);
+
+// unmaps the region, and removes its name as well if remove is true (so no other process can open it)
+void closeSharedMemory(PlatformSharedMemory* memory, const char* name, bool remove);
+
+// a file mapped read only into memory
+struct PlatformMappedFile
+{
+    const void* data;
+    size_t size;
+    long long handle; // the file mapping on windows
+}; typedef struct PlatformMappedFile PlatformMappedFile;
+
+// maps the whole file, returning false if it can't be opened or is empty
+bool mapFile(PlatformMappedFile* file, const char* path);
+void unmapFile(PlatformMappedFile* file);
+
+void sleepMilliseconds(int milliseconds);
+
+// gives up the rest of the thread's time slice (used while spinning on shared memory)
+void yieldThread(void);
+
+// the number of processors available to the process (at least 1)
+int getProcessorCount(void);
+
+// the id of this process, which no other running process shares
+unsigned long getProcessId(void);
+
+// a thread, and the function it runs
+typedef int (*PlatformThreadFunction)(void* argument);
+
+struct PlatformThread
+{
+    void* handle;
+}; typedef struct PlatformThread PlatformThread;
+
+bool startThread(PlatformThread* thread, PlatformThreadFunction function, void* argument);
+
+// waits for the thread to return
+void joinThread(PlatformThread* thread);
+
+// a mutual exclusion lock, and a condition variable that threads holding the lock can wait on
+struct PlatformLock
+{
+    void* handle;
+}; typedef struct PlatformLock PlatformLock;
+
+struct PlatformCondition
+{
+    void* handle;
+}; typedef struct PlatformCondition PlatformCondition;
+
+bool createLock(PlatformLock* lock);
+void destroyLock(PlatformLock* lock);
+void acquireLock(PlatformLock* lock);
+void releaseLock(PlatformLock* lock);
+
+bool createCondition(PlatformCondition* condition);
+void destroyCondition(PlatformCondition* condition);
+
+// releases the lock while waiting for the condition to be signalled (or for the timeout, if it isn't negative)
+void waitCondition(PlatformCondition* condition, PlatformLock* lock, int timeoutMilliseconds);
+void signalCondition(PlatformCondition* condition);
@@ -0,0 +1,258 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rompack.h"
+
+static const char romPackMagic[4] = { 'C', '8', 'P', 'K' };
+
+uint64_t hashChip8ROM(const Byte* data, size_t length)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+
+    for (size_t b = 0; b < length; b++)
+    {
+        hash ^= data[b];
+        hash *= 0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
+static uint64_t hashName(const char* name)
+{
+    return hashChip8ROM((const Byte*)name, strlen(name));
+}
+
+// the smallest power of two that leaves the tables at most half full
+static uint32_t slotsFor(unsigned int numOfROMs)
+{
+    uint32_t slots = 2;
+    while (slots < numOfROMs * 2)
+        slots *= 2;
+
+    return slots;
+}
+
+// finds an empty slot for the hash by linear probing
+static void insertSlot(uint32_t* slots, uint32_t numOfSlots, uint64_t hash, unsigned int entry)
+{
+    uint32_t slot = (uint32_t)hash & (numOfSlots - 1);
+
+    while (slots[slot] != 0)
+        slot = (slot + 1) & (numOfSlots - 1);
+
+    slots[slot] = entry + 1;
+}
+
+bool writeChip8ROMPack(const char* path, const chip8ROMPackInput* roms, unsigned int numOfROMs)
+{
+    if (numOfROMs == 0)
+    {
+        printf("A ROM pack needs at least one ROM\n");
+        return false;
+    }
+
+    uint32_t numOfSlots = slotsFor(numOfROMs);
+
+    chip8ROMEntry* entries = (chip8ROMEntry*)calloc(numOfROMs > 0 ? numOfROMs : 1, sizeof(chip8ROMEntry));
+    uint32_t* hashSlots    = (uint32_t*)calloc(numOfSlots, sizeof(uint32_t));
+    uint32_t* nameSlots    = (uint32_t*)calloc(numOfSlots, sizeof(uint32_t));
+
+    bool success = entries != NULL && hashSlots != NULL && nameSlots != NULL;
+
+    chip8ROMPackHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, romPackMagic, sizeof(romPackMagic));
+    header.version         = ROM_PACK_VERSION;
+    header.numOfROMs       = numOfROMs;
+    header.numOfSlots      = numOfSlots;
+    header.entriesOffset   = sizeof(chip8ROMPackHeader);
+    header.hashSlotsOffset = header.entriesOffset + numOfROMs * sizeof(chip8ROMEntry);
+    header.nameSlotsOffset = header.hashSlotsOffset + numOfSlots * sizeof(uint32_t);
+    header.namesOffset     = header.nameSlotsOffset + numOfSlots * sizeof(uint32_t);
+
+    for (unsigned int rom = 0; rom < numOfROMs && success; rom++)
+    {
+        if (roms[rom].length == 0 || roms[rom].length > MAX_ROM_SIZE || roms[rom].name[0] == '\0')
+        {
+            printf("%s is empty, unnamed or too big to load into chip8's 4k memory\n", roms[rom].name);
+            success = false;
+            break;
+        }
+
+        for (unsigned int other = 0; other < rom; other++)
+        {
+            if (strcmp(roms[rom].name, roms[other].name) == 0)
+            {
+                printf("There is more than one ROM named %s\n", roms[rom].name);
+                success = false;
+            }
+        }
+
+        entries[rom].hash                  = hashChip8ROM(roms[rom].data, roms[rom].length);
+        entries[rom].dataLength            = (uint32_t)roms[rom].length;
+        entries[rom].nameOffset            = (uint32_t)header.namesSize;
+        entries[rom].quirks                = roms[rom].quirks;
+        entries[rom].instructionsPerSecond = roms[rom].instructionsPerSecond;
+        memcpy(entries[rom].keyMap, roms[rom].keyMap, sizeof(entries[rom].keyMap));
+
+        header.namesSize += strlen(roms[rom].name) + 1;
+
+        // identical images share their hash, and the first one is the one found by it
+        bool duplicate = false;
+        for (unsigned int other = 0; other < rom; other++)
+            duplicate = duplicate || entries[other].hash == entries[rom].hash;
+
+        if (!duplicate)
+            insertSlot(hashSlots, numOfSlots, entries[rom].hash, rom);
+
+        insertSlot(nameSlots, numOfSlots, hashName(roms[rom].name), rom);
+    }
+
+    // the images follow the names, each starting on an 8 byte boundary
+    uint64_t dataOffset = (header.namesOffset + header.namesSize + 7) & ~7ULL;
+    for (unsigned int rom = 0; rom < numOfROMs && success; rom++)
+    {
+        entries[rom].dataOffset = dataOffset;
+        dataOffset = (dataOffset + entries[rom].dataLength + 7) & ~7ULL;
+    }
+
+    FILE* file = success ? fopen(path, "wb") : NULL;
+    if (success && file == NULL)
+    {
+        printf("Failed to open %s\n", path);
+        success = false;
+    }
+
+    if (success)
+    {
+        success = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(entries, sizeof(chip8ROMEntry), numOfROMs, file) == numOfROMs &&
+                  fwrite(hashSlots, sizeof(uint32_t), numOfSlots, file) == numOfSlots &&
+                  fwrite(nameSlots, sizeof(uint32_t), numOfSlots, file) == numOfSlots;
+
+        for (unsigned int rom = 0; rom < numOfROMs && success; rom++)
+            success = fwrite(roms[rom].name, 1, strlen(roms[rom].name) + 1, file) == strlen(roms[rom].name) + 1;
+
+        static const Byte padding[8] = { 0 };
+
+        for (unsigned int rom = 0; rom < numOfROMs && success; rom++)
+        {
+            long position = ftell(file);
+            success = position >= 0 && fwrite(padding, 1, (size_t)(entries[rom].dataOffset - position), file) == entries[rom].dataOffset - position &&
+                      fwrite(roms[rom].data, 1, roms[rom].length, file) == roms[rom].length;
+        }
+
+        success = fclose(file) == 0 && success;
+    }
+
+    free(entries);
+    free(hashSlots);
+    free(nameSlots);
+
+    return success;
+}
+
+bool openChip8ROMPack(chip8ROMPack* pack, const char* path)
+{
+    memset(pack, 0, sizeof(chip8ROMPack));
+
+    if (!mapFile(&pack->file, path))
+    {
+        printf("Failed to open the ROM pack %s\n", path);
+        return false;
+    }
+
+    const Byte* base = (const Byte*)pack->file.data;
+    uint64_t size = pack->file.size;
+    const chip8ROMPackHeader* header = (const chip8ROMPackHeader*)base;
+
+    // every table has to lie inside the file, so that nothing read from the pack can point outside it
+    bool valid = size >= sizeof(chip8ROMPackHeader) && memcmp(header->magic, romPackMagic, sizeof(romPackMagic)) == 0 &&
+                 header->version == ROM_PACK_VERSION &&
+                 header->numOfSlots > 0 && (header->numOfSlots & (header->numOfSlots - 1)) == 0 &&
+                 header->numOfSlots >= header->numOfROMs &&
+                 header->entriesOffset % 8 == 0 && header->hashSlotsOffset % 4 == 0 && header->nameSlotsOffset % 4 == 0 &&
+                 header->entriesOffset <= size && header->numOfROMs <= (size - header->entriesOffset) / sizeof(chip8ROMEntry) &&
+                 header->hashSlotsOffset <= size && header->numOfSlots <= (size - header->hashSlotsOffset) / sizeof(uint32_t) &&
+                 header->nameSlotsOffset <= size && header->numOfSlots <= (size - header->nameSlotsOffset) / sizeof(uint32_t) &&
+                 header->namesOffset <= size && header->namesSize <= size - header->namesOffset &&
+                 header->namesSize > 0 && base[header->namesOffset + header->namesSize - 1] == '\0';
+
+    if (valid)
+    {
+        pack->header    = header;
+        pack->entries   = (const chip8ROMEntry*)(base + header->entriesOffset);
+        pack->hashSlots = (const uint32_t*)(base + header->hashSlotsOffset);
+        pack->nameSlots = (const uint32_t*)(base + header->nameSlotsOffset);
+        pack->names     = (const char*)(base + header->namesOffset);
+
+        for (uint32_t rom = 0; rom < header->numOfROMs && valid; rom++)
+        {
+            const chip8ROMEntry* entry = &pack->entries[rom];
+
+            valid = entry->nameOffset < header->namesSize && entry->dataLength > 0 && entry->dataLength <= MAX_ROM_SIZE &&
+                    entry->dataOffset <= size && entry->dataLength <= size - entry->dataOffset;
+        }
+
+        for (uint32_t slot = 0; slot < header->numOfSlots && valid; slot++)
+            valid = pack->hashSlots[slot] <= header->numOfROMs && pack->nameSlots[slot] <= header->numOfROMs;
+    }
+
+    if (!valid)
+    {
+        printf("%s is not a valid ROM pack\n", path);
+        closeChip8ROMPack(pack);
+        return false;
+    }
+
+    return true;
+}
+
+void closeChip8ROMPack(chip8ROMPack* pack)
+{
+    unmapFile(&pack->file);
+    pack->header = NULL;
+}
+
+const chip8ROMEntry* findChip8ROMByHash(const chip8ROMPack* pack, uint64_t hash)
+{
+    uint32_t mask = pack->header->numOfSlots - 1;
+
+    // a full table (only possible in a hand made pack) is searched once around before giving up
+    for (uint32_t probe = 0, slot = (uint32_t)hash & mask; probe <= mask && pack->hashSlots[slot] != 0; probe++, slot = (slot + 1) & mask)
+    {
+        const chip8ROMEntry* entry = &pack->entries[pack->hashSlots[slot] - 1];
+        if (entry->hash == hash)
+            return entry;
+    }
+
+    return NULL;
+}
+
+const chip8ROMEntry* findChip8ROMByName(const chip8ROMPack* pack, const char* name)
+{
+    uint32_t mask = pack->header->numOfSlots - 1;
+    uint32_t slot = (uint32_t)hashName(name) & mask;
+
+    for (uint32_t probe = 0; probe <= mask && pack->nameSlots[slot] != 0; probe++, slot = (slot + 1) & mask)
+    {
+        const chip8ROMEntry* entry = &pack->entries[pack->nameSlots[slot] - 1];
+        if (strcmp(getChip8ROMName(pack, entry), name) == 0)
+            return entry;
+    }
+
+    return NULL;
+}
+
+const char* getChip8ROMName(const chip8ROMPack* pack, const chip8ROMEntry* entry)
+{
+    return pack->names + entry->nameOffset;
+}
+
+void loadChip8FromPack(chip8* chip8, const chip8ROMPack* pack, const chip8ROMEntry* entry)
+{
+    memcpy(&chip8->memory[0x200], (const Byte*)pack->file.data + entry->dataOffset, entry->dataLength);
+    chip8->quirks = entry->quirks;
+}
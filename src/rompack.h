@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "chip8.h"
+#include "platform.h"
+
+/*
+    a pack of many ROMs in one file, together with the settings each one plays best with. the pack is mapped
+    into memory once, ROMs are found by content hash or by name through hash tables stored in the pack, and a
+    ROM's image is copied straight from the mapping into the instance's memory.
+
+    file layout (little endian, and read in place, so the structures below are the file's own):
+        chip8ROMPackHeader
+        chip8ROMEntry[numOfROMs]
+        uint32_t hashSlots[numOfSlots]  open addressed table keyed by content hash (entry index + 1, 0 if empty)
+        uint32_t nameSlots[numOfSlots]  the same, keyed by the hash of the name
+        names                           NUL terminated
+        ROM images
+*/
+
+#define ROM_PACK_VERSION 1
+#define MAX_ROM_SIZE     (4096 - 0x200)
+
+// the keys of the frontend's default key map, for chip8 keys 0 to F
+#define DEFAULT_KEY_MAP "1234qwerasdfzxcv"
+
+struct chip8ROMPackHeader
+{
+    char magic[4]; // "C8PK"
+    uint32_t version;
+    uint32_t numOfROMs;
+    uint32_t numOfSlots; // a power of two, at least twice the number of ROMs
+    uint64_t entriesOffset;
+    uint64_t hashSlotsOffset;
+    uint64_t nameSlotsOffset;
+    uint64_t namesOffset;
+    uint64_t namesSize;
+}; typedef struct chip8ROMPackHeader chip8ROMPackHeader;
+
+struct chip8ROMEntry
+{
+    uint64_t hash;                  // hashChip8ROM of the image
+    uint64_t dataOffset;
+    uint32_t dataLength;
+    uint32_t nameOffset;            // from the start of the names
+    uint32_t quirks;                // chip8Quirk flags, given to the instance by loadChip8FromPack
+    uint32_t instructionsPerSecond; // the speed the ROM is meant to run at
+    char keyMap[16];                // the keyboard key for each chip8 key, e.g. DEFAULT_KEY_MAP
+}; typedef struct chip8ROMEntry chip8ROMEntry;
+
+struct chip8ROMPack
+{
+    PlatformMappedFile file;
+
+    const chip8ROMPackHeader* header;
+    const chip8ROMEntry* entries;
+    const uint32_t* hashSlots;
+    const uint32_t* nameSlots;
+    const char* names;
+}; typedef struct chip8ROMPack chip8ROMPack;
+
+// a ROM to be written to a pack
+struct chip8ROMPackInput
+{
+    const char* name;
+    const Byte* data;
+    size_t length;
+    uint32_t quirks;
+    uint32_t instructionsPerSecond;
+    char keyMap[16];
+}; typedef struct chip8ROMPackInput chip8ROMPackInput;
+
+// a 64 bit FNV-1a hash of a ROM image, which identifies it in packs (and anywhere else ROMs are cached)
+uint64_t hashChip8ROM(const Byte* data, size_t length);
+
+bool writeChip8ROMPack(const char* path, const chip8ROMPackInput* roms, unsigned int numOfROMs);
+
+// maps the pack and checks that everything in it lies within the file
+bool openChip8ROMPack(chip8ROMPack* pack, const char* path);
+void closeChip8ROMPack(chip8ROMPack* pack);
+
+// return NULL if the pack has no such ROM
+const chip8ROMEntry* findChip8ROMByHash(const chip8ROMPack* pack, uint64_t hash);
+const chip8ROMEntry* findChip8ROMByName(const chip8ROMPack* pack, const char* name);
+
+const char* getChip8ROMName(const chip8ROMPack* pack, const chip8ROMEntry* entry);
+
+// copies the ROM's image into the memory of the (already initialized) instance, and gives it the ROM's quirks
+void loadChip8FromPack(chip8* chip8, const chip8ROMPack* pack, const chip8ROMEntry* entry);
@@ -0,0 +1,427 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scheduler.h"
+
+#define MEMORY_MASK 0xFFF
+
+// both timers are 0 after this many ticks, so catching up on more frames than this is the same as catching up on this many
+#define MAX_TIMER_TICKS 256
+
+static DoubleByte fetchOpcode(const chip8* chip8, DoubleByte address)
+{
+    return (chip8->memory[address & MEMORY_MASK] << 8) | chip8->memory[(address + 1) & MEMORY_MASK];
+}
+
+static bool instanceEarlier(const chip8Scheduler* scheduler, int first, int second)
+{
+    return scheduler->instances[first].deadline < scheduler->instances[second].deadline;
+}
+
+static void placeInQueue(chip8SchedulerWorker* worker, int position, int instance)
+{
+    worker->queue[position] = instance;
+    worker->scheduler->instances[instance].queuePosition = position;
+}
+
+static void siftUp(chip8SchedulerWorker* worker, int position)
+{
+    int instance = worker->queue[position];
+
+    while (position > 0)
+    {
+        int parent = (position - 1) / 2;
+        if (!instanceEarlier(worker->scheduler, instance, worker->queue[parent]))
+            break;
+
+        placeInQueue(worker, position, worker->queue[parent]);
+        position = parent;
+    }
+
+    placeInQueue(worker, position, instance);
+}
+
+static void siftDown(chip8SchedulerWorker* worker, int position)
+{
+    int instance = worker->queue[position];
+
+    while (true)
+    {
+        int child = position * 2 + 1;
+        if (child >= worker->queueLength)
+            break;
+
+        if (child + 1 < worker->queueLength && instanceEarlier(worker->scheduler, worker->queue[child + 1], worker->queue[child]))
+            child++;
+
+        if (!instanceEarlier(worker->scheduler, worker->queue[child], instance))
+            break;
+
+        placeInQueue(worker, position, worker->queue[child]);
+        position = child;
+    }
+
+    placeInQueue(worker, position, instance);
+}
+
+static void enqueue(chip8SchedulerWorker* worker, int instance)
+{
+    worker->queue[worker->queueLength++] = instance;
+    siftUp(worker, worker->queueLength - 1);
+}
+
+// takes the instance at the front of the queue out of it
+static void dequeueFirst(chip8SchedulerWorker* worker)
+{
+    worker->scheduler->instances[worker->queue[0]].queuePosition = -1;
+
+    worker->queueLength--;
+    if (worker->queueLength > 0)
+    {
+        worker->queue[0] = worker->queue[worker->queueLength];
+        siftDown(worker, 0);
+    }
+}
+
+// ticks the timers for frames the instance didn't run
+static void catchUpTimers(chip8* chip8, unsigned long long frames)
+{
+    if (frames > MAX_TIMER_TICKS)
+        frames = MAX_TIMER_TICKS;
+
+    for (unsigned long long frame = 0; frame < frames; frame++)
+        updateChip8Timers(chip8);
+}
+
+// whether the instance is stuck in FX0A, which runs again and again until a key is held
+static bool waitingForKey(const chip8* chip8)
+{
+    if ((fetchOpcode(chip8, chip8->programCounter) & 0xF0FF) != 0xF00A)
+        return false;
+
+    for (int key = 0; key < 16; key++)
+    {
+        if (chip8->keys[key])
+            return false;
+    }
+
+    return true;
+}
+
+/*
+    if the instance is in a FX07; 3XNN; 1NNN loop back to the FX07, returns the number of frames it will spin for before
+    the delay timer reaches NN, and moves it to the start of the loop (which only writes VX before reading it, so this
+    can't be told apart from it having got there itself). returns 0 if it isn't in such a loop, or will leave it this frame
+*/
+static unsigned int framesUntilTimerLoopExits(chip8* chip8)
+{
+    for (int offset = 0; offset <= 4; offset += 2)
+    {
+        DoubleByte start = (chip8->programCounter - offset) & MEMORY_MASK;
+
+        DoubleByte read  = fetchOpcode(chip8, start);
+        DoubleByte skip  = fetchOpcode(chip8, start + 2);
+        DoubleByte jump  = fetchOpcode(chip8, start + 4);
+
+        if ((read & 0xF0FF) != 0xF007 || (skip & 0xFF00) != (0x3000 | (read & 0x0F00)) || jump != (0x1000 | start))
+            continue;
+
+        Byte x      = (read & 0x0F00) >> 8;
+        Byte target = skip & 0x00FF;
+
+        // about to compare a value read before, which may already let it out of the loop
+        if (offset == 2 && chip8->registers[x] == target)
+            return 0;
+
+        // the delay timer only counts down, so a loop waiting for a higher value never ends and isn't worth sleeping on
+        if (chip8->delayTimer <= target)
+            return 0;
+
+        chip8->programCounter = start;
+        return chip8->delayTimer - target;
+    }
+
+    return 0;
+}
+
+// runs a slice of the instance at the front of the worker's queue
+static void runSlice(chip8SchedulerWorker* worker)
+{
+    chip8Scheduler* scheduler = worker->scheduler;
+    int number = worker->queue[0];
+    chip8ScheduledInstance* instance = &scheduler->instances[number];
+
+    unsigned int cycles = instance->cyclesLeft < scheduler->cyclesPerSlice ? instance->cyclesLeft : scheduler->cyclesPerSlice;
+    chip8Status status = runChip8Cycles(&instance->machine, cycles);
+    worker->stats.slices++;
+
+    if (status != CHIP8_OK)
+    {
+        instance->state = INSTANCE_TRAPPED;
+        worker->stats.trapped++;
+        dequeueFirst(worker);
+        return;
+    }
+
+    instance->cyclesLeft -= cycles;
+
+    if (waitingForKey(&instance->machine))
+    {
+        instance->state = INSTANCE_PARKED_ON_KEY;
+        worker->stats.parks++;
+        worker->stats.parkedOnKey++;
+        dequeueFirst(worker);
+        return;
+    }
+
+    if (instance->cyclesLeft == 0)
+    {
+        updateChip8Timers(&instance->machine);
+        instance->frames++;
+        worker->stats.frames++;
+
+        if (getTimeMilliseconds() > instance->deadline)
+            worker->stats.missedDeadlines++;
+
+        instance->deadline  += scheduler->frameMilliseconds;
+        instance->cyclesLeft = scheduler->cyclesPerFrame;
+
+        if (scheduler->onFrame != NULL)
+            scheduler->onFrame(scheduler, number, scheduler->userData);
+
+        unsigned int sleep = framesUntilTimerLoopExits(&instance->machine);
+        if (sleep > 0)
+        {
+            catchUpTimers(&instance->machine, sleep);
+            instance->frames   += sleep;
+            instance->deadline += sleep * scheduler->frameMilliseconds;
+            worker->stats.sleptFrames += sleep;
+            worker->stats.parks++;
+        }
+    }
+
+    siftDown(worker, 0);
+}
+
+static int runWorker(void* argument)
+{
+    chip8SchedulerWorker* worker = (chip8SchedulerWorker*)argument;
+    chip8Scheduler* scheduler = worker->scheduler;
+
+    acquireLock(&worker->lock);
+
+    while (worker->running)
+    {
+        if (worker->queueLength == 0)
+        {
+            waitCondition(&worker->wake, &worker->lock, -1);
+            continue;
+        }
+
+        // a frame can start one frame before its deadline
+        double now   = getTimeMilliseconds();
+        double start = scheduler->instances[worker->queue[0]].deadline - scheduler->frameMilliseconds;
+
+        if (start > now)
+        {
+            waitCondition(&worker->wake, &worker->lock, (int)(start - now) + 1);
+            continue;
+        }
+
+        runSlice(worker);
+
+        // gives the host a chance at the lock (to press keys or copy instances) between slices
+        releaseLock(&worker->lock);
+        acquireLock(&worker->lock);
+    }
+
+    releaseLock(&worker->lock);
+    return 0;
+}
+
+bool createChip8Scheduler(chip8Scheduler* scheduler, int maxInstances, int numOfWorkers, unsigned int cyclesPerFrame,
+                          unsigned int cyclesPerSlice, unsigned int framesPerSecond)
+{
+    memset(scheduler, 0, sizeof(chip8Scheduler));
+
+    if (maxInstances < 1 || numOfWorkers < 1 || cyclesPerFrame == 0 || cyclesPerSlice == 0 || framesPerSecond == 0)
+    {
+        printf("A scheduler needs at least one instance, worker, cycle per frame, cycle per slice and frame per second\n");
+        return false;
+    }
+
+    scheduler->maxInstances      = maxInstances;
+    scheduler->numOfWorkers      = numOfWorkers;
+    scheduler->cyclesPerFrame    = cyclesPerFrame;
+    scheduler->cyclesPerSlice    = cyclesPerSlice;
+    scheduler->frameMilliseconds = 1000.0 / framesPerSecond;
+
+    scheduler->instances = (chip8ScheduledInstance*)calloc(maxInstances, sizeof(chip8ScheduledInstance));
+    scheduler->workers   = (chip8SchedulerWorker*)calloc(numOfWorkers, sizeof(chip8SchedulerWorker));
+
+    if (scheduler->instances == NULL || scheduler->workers == NULL)
+    {
+        printf("Failed to allocate a scheduler for %d instances\n", maxInstances);
+        destroyChip8Scheduler(scheduler);
+        return false;
+    }
+
+    for (int number = 0; number < numOfWorkers; number++)
+    {
+        chip8SchedulerWorker* worker = &scheduler->workers[number];
+        worker->scheduler = scheduler;
+
+        // each worker gets every numOfWorkers-th instance
+        worker->queue = (int*)malloc((maxInstances / numOfWorkers + 1) * sizeof(int));
+
+        if (worker->queue == NULL || !createLock(&worker->lock) || !createCondition(&worker->wake))
+        {
+            printf("Failed to set up the scheduler's workers\n");
+            destroyChip8Scheduler(scheduler);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int addChip8Instance(chip8Scheduler* scheduler, const chip8* initial)
+{
+    if (scheduler->numOfInstances == scheduler->maxInstances)
+        return -1;
+
+    int number = scheduler->numOfInstances++;
+    chip8ScheduledInstance* instance = &scheduler->instances[number];
+
+    instance->machine       = *initial;
+    instance->state         = INSTANCE_RUNNABLE;
+    instance->cyclesLeft    = scheduler->cyclesPerFrame;
+    instance->worker        = number % scheduler->numOfWorkers;
+    instance->queuePosition = -1;
+
+    return number;
+}
+
+bool startChip8Scheduler(chip8Scheduler* scheduler)
+{
+    double now = getTimeMilliseconds();
+
+    for (int number = 0; number < scheduler->numOfInstances; number++)
+    {
+        scheduler->instances[number].deadline = now + scheduler->frameMilliseconds;
+        enqueue(&scheduler->workers[scheduler->instances[number].worker], number);
+    }
+
+    for (int number = 0; number < scheduler->numOfWorkers; number++)
+    {
+        chip8SchedulerWorker* worker = &scheduler->workers[number];
+        worker->running = true;
+
+        if (!startThread(&worker->thread, runWorker, worker))
+        {
+            printf("Failed to start the scheduler's workers\n");
+            worker->running = false;
+            stopChip8Scheduler(scheduler);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void setChip8InstanceKey(chip8Scheduler* scheduler, int instance, int key, bool pressed)
+{
+    chip8ScheduledInstance* scheduled = &scheduler->instances[instance];
+    chip8SchedulerWorker* worker = &scheduler->workers[scheduled->worker];
+
+    acquireLock(&worker->lock);
+
+    scheduled->machine.keys[key & 0xF] = pressed;
+
+    if (pressed && scheduled->state == INSTANCE_PARKED_ON_KEY)
+    {
+        // the current frame picks up where it left off, unless its time has gone by (along with any frames after it),
+        // in which case the frames that went by while it waited are skipped
+        double now = getTimeMilliseconds();
+        unsigned long long skipped = now > scheduled->deadline ? (unsigned long long)((now - scheduled->deadline) / scheduler->frameMilliseconds) + 1 : 0;
+
+        catchUpTimers(&scheduled->machine, skipped);
+        scheduled->frames   += skipped;
+        scheduled->deadline += skipped * scheduler->frameMilliseconds;
+        scheduled->state     = INSTANCE_RUNNABLE;
+
+        worker->stats.sleptFrames += skipped;
+        worker->stats.parkedOnKey--;
+        enqueue(worker, instance);
+        signalCondition(&worker->wake);
+    }
+
+    releaseLock(&worker->lock);
+}
+
+void copyChip8Instance(chip8Scheduler* scheduler, int instance, chip8ScheduledInstance* copy)
+{
+    chip8SchedulerWorker* worker = &scheduler->workers[scheduler->instances[instance].worker];
+
+    acquireLock(&worker->lock);
+    *copy = scheduler->instances[instance];
+    releaseLock(&worker->lock);
+}
+
+void getChip8SchedulerStats(chip8Scheduler* scheduler, chip8SchedulerStats* stats)
+{
+    memset(stats, 0, sizeof(chip8SchedulerStats));
+
+    for (int number = 0; number < scheduler->numOfWorkers; number++)
+    {
+        chip8SchedulerWorker* worker = &scheduler->workers[number];
+
+        acquireLock(&worker->lock);
+        stats->slices          += worker->stats.slices;
+        stats->frames          += worker->stats.frames;
+        stats->sleptFrames     += worker->stats.sleptFrames;
+        stats->missedDeadlines += worker->stats.missedDeadlines;
+        stats->parks           += worker->stats.parks;
+        stats->parkedOnKey     += worker->stats.parkedOnKey;
+        stats->trapped         += worker->stats.trapped;
+        releaseLock(&worker->lock);
+    }
+}
+
+void stopChip8Scheduler(chip8Scheduler* scheduler)
+{
+    for (int number = 0; number < scheduler->numOfWorkers; number++)
+    {
+        chip8SchedulerWorker* worker = &scheduler->workers[number];
+
+        acquireLock(&worker->lock);
+        worker->running = false;
+        signalCondition(&worker->wake);
+        releaseLock(&worker->lock);
+
+        joinThread(&worker->thread);
+    }
+}
+
+void destroyChip8Scheduler(chip8Scheduler* scheduler)
+{
+    if (scheduler->workers != NULL)
+    {
+        for (int number = 0; number < scheduler->numOfWorkers; number++)
+        {
+            chip8SchedulerWorker* worker = &scheduler->workers[number];
+
+            destroyCondition(&worker->wake);
+            destroyLock(&worker->lock);
+            free(worker->queue);
+        }
+    }
+
+    free(scheduler->instances);
+    free(scheduler->workers);
+
+    scheduler->instances = NULL;
+    scheduler->workers   = NULL;
+}
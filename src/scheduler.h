@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "chip8.h"
+#include "platform.h"
+
+/*
+    runs many chip8 instances on a few worker threads. each instance is given to one worker, which keeps its instances
+    in a queue ordered by the deadline of their current frame and always runs the instance whose deadline is soonest.
+    a frame is cyclesPerFrame instructions followed by a tick of the timers, and it is run a slice (cyclesPerSlice
+    instructions) at a time so that a busy instance can't hold up the others on its worker. a frame may start one
+    frame length before its deadline, so every instance runs at framesPerSecond no matter how fast the host is.
+
+    instances that can't make progress are parked instead of spinning:
+        - an instance blocked in FX0A with no key held leaves the queue until a key is pressed
+        - an instance polling the delay timer in a FX07; 3XNN; 1NNN loop (back to the FX07) sleeps through the frames
+          until the timer reaches NN, with its timers ticked as though it had run them
+    either way the instance's frames and timers carry on as they would have, but it is only exact to the frame (not to
+    the instruction) where it picks up again
+
+    everything about an instance belongs to its worker's lock, which is held while the worker runs a slice
+*/
+
+#define DEFAULT_SCHEDULER_FRAMES_PER_SECOND 60
+
+typedef enum
+{
+    INSTANCE_RUNNABLE,      // queued, waiting for its next slice or for its next frame to start
+    INSTANCE_PARKED_ON_KEY, // blocked in FX0A, and out of the queue until a key is pressed
+    INSTANCE_TRAPPED        // stopped by a trap (see the trap fields of its chip8 structure)
+} chip8InstanceState;
+
+struct chip8ScheduledInstance
+{
+    chip8 machine;
+    chip8InstanceState state;
+
+    double deadline;             // when the current frame's cycles should have run by
+    unsigned int cyclesLeft;     // how many of the current frame's cycles haven't been run yet
+    unsigned long long frames;   // the frames completed (including those slept through)
+
+    int worker;
+    int queuePosition;           // the instance's place in its worker's queue, or -1 while it is out of it
+}; typedef struct chip8ScheduledInstance chip8ScheduledInstance;
+
+typedef struct chip8Scheduler chip8Scheduler;
+
+// called by a worker (holding its lock) after each frame an instance runs. must be quick, and mustn't call back into
+// the scheduler
+typedef void (*chip8FrameCallback)(chip8Scheduler* scheduler, int instance, void* userData);
+
+// what the workers have done so far, added up over all of them
+struct chip8SchedulerStats
+{
+    unsigned long long slices;
+    unsigned long long frames;
+    unsigned long long sleptFrames;     // frames that parked instances went without running
+    unsigned long long missedDeadlines; // frames that finished after their deadline
+    unsigned long long parks;           // times instances were parked (on a key or on the delay timer)
+    int parkedOnKey;                    // instances currently parked on a key
+    int trapped;                        // instances that have trapped
+}; typedef struct chip8SchedulerStats chip8SchedulerStats;
+
+struct chip8SchedulerWorker
+{
+    chip8Scheduler* scheduler;
+    PlatformThread thread;
+    PlatformLock lock;
+    PlatformCondition wake; // signalled when the queue changes or the worker has to stop
+    bool running;
+
+    // a binary heap of instance numbers, with the soonest deadline first
+    int* queue;
+    int queueLength;
+
+    chip8SchedulerStats stats;
+}; typedef struct chip8SchedulerWorker chip8SchedulerWorker;
+
+struct chip8Scheduler
+{
+    chip8ScheduledInstance* instances;
+    int numOfInstances;
+    int maxInstances;
+
+    chip8SchedulerWorker* workers;
+    int numOfWorkers;
+
+    unsigned int cyclesPerFrame;
+    unsigned int cyclesPerSlice;
+    double frameMilliseconds;
+
+    chip8FrameCallback onFrame;
+    void* userData;
+};
+
+bool createChip8Scheduler(chip8Scheduler* scheduler, int maxInstances, int numOfWorkers, unsigned int cyclesPerFrame,
+                          unsigned int cyclesPerSlice, unsigned int framesPerSecond);
+
+// adds an instance starting from the given state, returning its number (or -1 if the scheduler is full).
+// instances can only be added before the scheduler is started
+int addChip8Instance(chip8Scheduler* scheduler, const chip8* initial);
+
+bool startChip8Scheduler(chip8Scheduler* scheduler);
+
+// presses or releases one of an instance's keys, waking it if it was waiting for one
+void setChip8InstanceKey(chip8Scheduler* scheduler, int instance, int key, bool pressed);
+
+// copies an instance as it is between two slices
+void copyChip8Instance(chip8Scheduler* scheduler, int instance, chip8ScheduledInstance* copy);
+
+void getChip8SchedulerStats(chip8Scheduler* scheduler, chip8SchedulerStats* stats);
+
+// stops the workers once their current slices are done
+void stopChip8Scheduler(chip8Scheduler* scheduler);
+void destroyChip8Scheduler(chip8Scheduler* scheduler);
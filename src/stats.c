@@ -0,0 +1,182 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "stats.h"
+
+// the derived rates are recomputed every half a second
+#define STATS_WINDOW_MILLISECONDS 500.0
+
+// prometheus scrapes are tiny, so the whole response is built in a fixed size buffer
+#define METRICS_BUFFER_SIZE 4096
+
+// longer instance names are cut short (never in the middle of an escape), which keeps a scrape within METRICS_BUFFER_SIZE
+#define MAX_ESCAPED_INSTANCE_NAME 128
+
+void initChip8Stats(chip8Stats* stats, double targetInstructionsPerSecond)
+{
+    memset(stats, 0, sizeof(chip8Stats));
+
+    stats->targetInstructionsPerSecond = targetInstructionsPerSecond;
+    stats->windowStart                 = getTimeMilliseconds();
+    stats->windowCPUStart              = getProcessCPUMilliseconds();
+}
+
+// called from the main loop with the current time. only does any real work once per sampling window
+void sampleChip8Stats(chip8Stats* stats, double now)
+{
+    double elapsed = now - stats->windowStart;
+    if (elapsed < STATS_WINDOW_MILLISECONDS)
+        return;
+
+    double cpu = getProcessCPUMilliseconds();
+
+    stats->instructionsPerSecond = (stats->instructions - stats->windowInstructions) * 1000.0 / elapsed;
+    stats->presentsPerSecond     = (stats->presents - stats->windowPresents) * 1000.0 / elapsed;
+    stats->cpuPercent            = (cpu - stats->windowCPUStart) * 100.0 / elapsed;
+    stats->speedRatio            = stats->targetInstructionsPerSecond > 0.0 ? stats->instructionsPerSecond / stats->targetInstructionsPerSecond : 0.0;
+    stats->updated               = true;
+
+    // start the next window
+    stats->windowStart        = now;
+    stats->windowCPUStart     = cpu;
+    stats->windowInstructions = stats->instructions;
+    stats->windowPresents     = stats->presents;
+}
+
+/*
+    label values in the exposition format are quoted, so backslashes, double quotes and line feeds in them have to be
+    escaped (as \\, \" and \n). rom paths on windows are full of backslashes
+*/
+static void escapeLabelValue(const char* value, char* escaped, int escapedSize)
+{
+    int length = 0;
+
+    for (; *value != '\0'; value++)
+    {
+        char replacement = *value == '\\' ? '\\' : (*value == '"' ? '"' : (*value == '\n' ? 'n' : '\0'));
+        int needed = replacement != '\0' ? 2 : 1;
+
+        if (length + needed >= escapedSize)
+            break;
+
+        if (replacement != '\0')
+        {
+            escaped[length++] = '\\';
+            escaped[length++] = replacement;
+        }
+        else
+            escaped[length++] = *value;
+    }
+
+    escaped[length] = '\0';
+}
+
+// writes the counters into buffer in prometheus' text exposition format, returning the number of characters written
+int formatChip8Metrics(const chip8Stats* stats, const char* instanceName, char* buffer, int bufferSize)
+{
+    char escapedName[MAX_ESCAPED_INSTANCE_NAME];
+    escapeLabelValue(instanceName, escapedName, sizeof(escapedName));
+
+    return snprintf(buffer, bufferSize,
+        "# HELP chip8_instructions_total Emulated CHIP-8 instructions executed.\n"
+        "# TYPE chip8_instructions_total counter\n"
+        "chip8_instructions_total{instance=\"%s\"} %llu\n"
+        "# HELP chip8_presents_total Frames presented to the window.\n"
+        "# TYPE chip8_presents_total counter\n"
+        "chip8_presents_total{instance=\"%s\"} %llu\n"
+        "# HELP chip8_skipped_frames_total 60Hz frames missed because the main loop fell behind.\n"
+        "# TYPE chip8_skipped_frames_total counter\n"
+        "chip8_skipped_frames_total{instance=\"%s\"} %llu\n"
+        "# HELP chip8_instructions_per_second Emulated instructions per second.\n"
+        "# TYPE chip8_instructions_per_second gauge\n"
+        "chip8_instructions_per_second{instance=\"%s\"} %.1f\n"
+        "# HELP chip8_target_instructions_per_second Configured emulation speed.\n"
+        "# TYPE chip8_target_instructions_per_second gauge\n"
+        "chip8_target_instructions_per_second{instance=\"%s\"} %.1f\n"
+        "# HELP chip8_speed_ratio Real speed divided by target speed.\n"
+        "# TYPE chip8_speed_ratio gauge\n"
+        "chip8_speed_ratio{instance=\"%s\"} %.3f\n"
+        "# HELP chip8_presents_per_second Frames presented per second.\n"
+        "# TYPE chip8_presents_per_second gauge\n"
+        "chip8_presents_per_second{instance=\"%s\"} %.1f\n"
+        "# HELP chip8_frame_time_milliseconds Time spent drawing and presenting the last frame.\n"
+        "# TYPE chip8_frame_time_milliseconds gauge\n"
+        "chip8_frame_time_milliseconds{instance=\"%s\"} %.3f\n"
+        "# HELP chip8_cpu_percent Process cpu usage as a percentage of one core.\n"
+        "# TYPE chip8_cpu_percent gauge\n"
+        "chip8_cpu_percent{instance=\"%s\"} %.1f\n"
+        "# HELP chip8_time_to_first_frame_milliseconds Time from launch to the first frame presented (0 until then).\n"
+        "# TYPE chip8_time_to_first_frame_milliseconds gauge\n"
+        "chip8_time_to_first_frame_milliseconds{instance=\"%s\"} %.1f\n"
+        "# HELP chip8_time_to_audio_milliseconds Time from launch to audio being ready (0 until then).\n"
+        "# TYPE chip8_time_to_audio_milliseconds gauge\n"
+        "chip8_time_to_audio_milliseconds{instance=\"%s\"} %.1f\n",
+        escapedName, stats->instructions,
+        escapedName, stats->presents,
+        escapedName, stats->skippedFrames,
+        escapedName, stats->instructionsPerSecond,
+        escapedName, stats->targetInstructionsPerSecond,
+        escapedName, stats->speedRatio,
+        escapedName, stats->presentsPerSecond,
+        escapedName, stats->lastFrameTime,
+        escapedName, stats->cpuPercent,
+        escapedName, stats->timeToFirstFrame,
+        escapedName, stats->timeToAudio);
+}
+
+bool initMetricsServer(chip8MetricsServer* server, unsigned short port, const char* instanceName)
+{
+    server->instanceName = instanceName;
+
+    // the listener is non blocking so that polling it from the main loop never stalls emulation
+    server->listener = openLoopbackListener(port, false);
+    if (server->listener == INVALID_PLATFORM_SOCKET)
+    {
+        printf("Failed to open the metrics endpoint on 127.0.0.1:%u\n", port);
+        return false;
+    }
+
+    printf("Serving metrics on http://127.0.0.1:%u/metrics\n", port);
+    return true;
+}
+
+/*
+    answers at most one pending scrape. this is polled from the main loop, so the counters are read
+    by the same thread that writes them. the request itself is not parsed, every request receives the metrics
+*/
+void serveMetrics(chip8MetricsServer* server, const chip8Stats* stats)
+{
+    if (server->listener == INVALID_PLATFORM_SOCKET)
+        return;
+
+    PlatformSocket connection = acceptConnection(server->listener);
+    if (connection == INVALID_PLATFORM_SOCKET)
+        return;
+
+    // drain the request line and headers (a scrape fits in a single read). a client that connects without
+    // sending anything can only hold up the main loop for a few milliseconds
+    char request[1024];
+    if (waitForConnectionData(connection, 5))
+        receiveFromConnection(connection, request, sizeof(request));
+
+    char body[METRICS_BUFFER_SIZE];
+    int bodyLength = formatChip8Metrics(stats, server->instanceName, body, sizeof(body));
+    if (bodyLength >= (int)sizeof(body))
+        bodyLength = sizeof(body) - 1;
+
+    char header[128];
+    int headerLength = snprintf(header, sizeof(header),
+        "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %d\r\n\r\n", bodyLength);
+
+    if (sendToConnection(connection, header, headerLength))
+        sendToConnection(connection, body, bodyLength);
+
+    closeConnection(connection);
+}
+
+void closeMetricsServer(chip8MetricsServer* server)
+{
+    closeConnection(server->listener);
+    server->listener = INVALID_PLATFORM_SOCKET;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "platform.h"
+
+/*
+    performance counters for a running interpreter. the raw counters are bumped by the main loop,
+    and once per sampling window they are turned into the rates shown by the overlay and exported
+    to the metrics endpoint. everything is owned by the main loop's thread, so no locking is needed
+*/
+struct chip8Stats
+{
+    // raw counters (monotonic for the lifetime of the process)
+    unsigned long long instructions;  // emulated instructions executed
+    unsigned long long presents;      // frames presented to the window
+    unsigned long long skippedFrames; // 60Hz frames that were missed because the main loop fell behind
+    double lastFrameTime;             // milliseconds spent drawing and presenting the last frame
+
+    // milliseconds from the start of main to the first frame the ROM drew being presented, and to audio being ready
+    // (0 until they happen)
+    double timeToFirstFrame;
+    double timeToAudio;
+
+    // rates derived at the end of each sampling window
+    double instructionsPerSecond;
+    double targetInstructionsPerSecond;
+    double speedRatio;         // instructionsPerSecond / targetInstructionsPerSecond
+    double presentsPerSecond;
+    double cpuPercent;         // process cpu time as a percentage of wall time (can exceed 100 on multiple cores)
+
+    // set to true whenever the derived rates change (so that the overlay knows to redraw)
+    bool updated;
+
+    // the state at the start of the current sampling window
+    double windowStart;
+    double windowCPUStart;
+    unsigned long long windowInstructions;
+    unsigned long long windowPresents;
+}; typedef struct chip8Stats chip8Stats;
+
+// a loopback endpoint serving the counters in prometheus' text format
+struct chip8MetricsServer
+{
+    PlatformSocket listener;
+    const char* instanceName; // used as the value of the "instance" label
+}; typedef struct chip8MetricsServer chip8MetricsServer;
+
+void initChip8Stats(chip8Stats* stats, double targetInstructionsPerSecond);
+void sampleChip8Stats(chip8Stats* stats, double now);
+int formatChip8Metrics(const chip8Stats* stats, const char* instanceName, char* buffer, int bufferSize);
+
+bool initMetricsServer(chip8MetricsServer* server, unsigned short port, const char* instanceName);
+void serveMetrics(chip8MetricsServer* server, const chip8Stats* stats);
+void closeMetricsServer(chip8MetricsServer* server);
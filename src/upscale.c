@@ -0,0 +1,546 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "upscale.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define UPSCALE_X86
+    #include <immintrin.h>
+
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#endif
+
+// gcc and clang only let the intrinsics of instruction sets the build isn't for be used in functions marked for them
+#if defined(UPSCALE_X86) && defined(__GNUC__)
+    #define TARGET_SSE2 __attribute__((target("sse2")))
+    #define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define TARGET_SSE2
+    #define TARGET_AVX2
+#endif
+
+#define DISPLAY_WIDTH  64
+#define DISPLAY_HEIGHT 32
+
+/*
+    the display padded by a copy of its edge pixels on every side, so that the filters can read every pixel's
+    neighbours without checking for the edges. a pixel is at (y + 1) * PADDED_STRIDE + PADDED_OFFSET + x
+*/
+#define PADDED_STRIDE 96
+#define PADDED_OFFSET 16
+
+// buffers of more bytes than this have their rows copied with stores that bypass the cache
+#define STREAMING_THRESHOLD (16 * 1024 * 1024)
+
+// intensities closer than this count as the same colour to hq2x
+#define HQ2X_THRESHOLD 48
+
+typedef void (*fillFunction)(unsigned int* pixels, int count, unsigned int colour);
+typedef void (*intensityFunction)(const bool* pixels, Byte* intensities, unsigned int decay);
+typedef void (*filterFunction)(const Byte* padded, Byte* filtered);
+typedef void (*copyFunction)(unsigned int* destination, const unsigned int* source, int count);
+
+static const char* filterNames[] = { "nearest", "scale2x", "hq2x" };
+static const char* kernelNames[] = { "scalar", "sse2", "avx2" };
+
+/*
+    the scalar kernels
+*/
+
+static void fillScalar(unsigned int* pixels, int count, unsigned int colour)
+{
+    for (int i = 0; i < count; i++)
+        pixels[i] = colour;
+}
+
+static void copyScalar(unsigned int* destination, const unsigned int* source, int count)
+{
+    memcpy(destination, source, count * sizeof(unsigned int));
+}
+
+static void intensitiesScalar(const bool* pixels, Byte* intensities, unsigned int decay)
+{
+    for (int i = 0; i < DISPLAY_WIDTH * DISPLAY_HEIGHT; i++)
+    {
+        Byte lit   = pixels[i] ? 255 : 0;
+        Byte faded = (Byte)((intensities[i] * decay) >> 8);
+
+        intensities[i] = lit > faded ? lit : faded;
+    }
+}
+
+/*
+    Scale2x. with B above E, D to its left, F to its right and H below it, E becomes
+
+        E0 E1    E0 = D if D == B, otherwise E    E2 = D if D == H, otherwise E
+        E2 E3    E1 = F if B == F, otherwise E    E3 = F if H == F, otherwise E
+
+    except where B == H or D == F, where all four are E
+*/
+static void scale2xScalar(const Byte* padded, Byte* filtered)
+{
+    for (int y = 0; y < DISPLAY_HEIGHT; y++)
+    {
+        const Byte* row   = &padded[(y + 1) * PADDED_STRIDE + PADDED_OFFSET];
+        const Byte* above = row - PADDED_STRIDE;
+        const Byte* below = row + PADDED_STRIDE;
+
+        Byte* top    = &filtered[y * 2 * DISPLAY_WIDTH * 2];
+        Byte* bottom = top + DISPLAY_WIDTH * 2;
+
+        for (int x = 0; x < DISPLAY_WIDTH; x++)
+        {
+            Byte b = above[x], d = row[x - 1], e = row[x], f = row[x + 1], h = below[x];
+
+            bool changed = b != h && d != f;
+
+            top[x * 2]        = changed && d == b ? d : e;
+            top[x * 2 + 1]    = changed && b == f ? f : e;
+            bottom[x * 2]     = changed && d == h ? d : e;
+            bottom[x * 2 + 1] = changed && h == f ? f : e;
+        }
+    }
+}
+
+static bool similar(Byte first, Byte second)
+{
+    return abs(first - second) < HQ2X_THRESHOLD;
+}
+
+// one quarter of a pixel under hq2x, from the pixel, its two neighbours on that side and the one diagonally between them
+static Byte hq2xQuarter(Byte centre, Byte side1, Byte side2, Byte corner)
+{
+    // an edge between the two sides cuts across the corner
+    if (similar(side1, side2) && !similar(centre, side1))
+        return (Byte)((centre * 2 + side1 + side2) / 4);
+
+    if (!similar(centre, corner))
+        return (Byte)((centre * 3 + corner) / 4);
+
+    return centre;
+}
+
+static void hq2xScalar(const Byte* padded, Byte* filtered)
+{
+    for (int y = 0; y < DISPLAY_HEIGHT; y++)
+    {
+        const Byte* row   = &padded[(y + 1) * PADDED_STRIDE + PADDED_OFFSET];
+        const Byte* above = row - PADDED_STRIDE;
+        const Byte* below = row + PADDED_STRIDE;
+
+        Byte* top    = &filtered[y * 2 * DISPLAY_WIDTH * 2];
+        Byte* bottom = top + DISPLAY_WIDTH * 2;
+
+        for (int x = 0; x < DISPLAY_WIDTH; x++)
+        {
+            Byte e = row[x];
+
+            top[x * 2]        = hq2xQuarter(e, row[x - 1], above[x], above[x - 1]);
+            top[x * 2 + 1]    = hq2xQuarter(e, row[x + 1], above[x], above[x + 1]);
+            bottom[x * 2]     = hq2xQuarter(e, row[x - 1], below[x], below[x - 1]);
+            bottom[x * 2 + 1] = hq2xQuarter(e, row[x + 1], below[x], below[x + 1]);
+        }
+    }
+}
+
+#ifdef UPSCALE_X86
+
+/*
+    the SSE2 kernels
+*/
+
+TARGET_SSE2 static void fillSSE2(unsigned int* pixels, int count, unsigned int colour)
+{
+    if (count < 4)
+    {
+        fillScalar(pixels, count, colour);
+        return;
+    }
+
+    __m128i colours = _mm_set1_epi32((int)colour);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_si128((__m128i*)&pixels[i], colours);
+
+    // the last few pixels are written by a store overlapping the one before it
+    if (i < count)
+        _mm_storeu_si128((__m128i*)&pixels[count - 4], colours);
+}
+
+/*
+    copies rows that won't be read again with stores that bypass the cache. for a buffer much larger than the cache
+    this saves reading each line of it in before it is overwritten, but smaller ones are better off staying in the
+    cache, so it is only used above STREAMING_THRESHOLD
+*/
+TARGET_SSE2 static void copySSE2(unsigned int* destination, const unsigned int* source, int count)
+{
+    int i = 0;
+
+    // the stores have to be aligned, so the pixels before the first aligned one are copied normally
+    while (i < count && ((size_t)&destination[i] & 15) != 0)
+    {
+        destination[i] = source[i];
+        i++;
+    }
+
+    for (; i + 4 <= count; i += 4)
+        _mm_stream_si128((__m128i*)&destination[i], _mm_loadu_si128((const __m128i*)&source[i]));
+
+    for (; i < count; i++)
+        destination[i] = source[i];
+}
+
+TARGET_SSE2 static void intensitiesSSE2(const bool* pixels, Byte* intensities, unsigned int decay)
+{
+    __m128i zero   = _mm_setzero_si128();
+    __m128i decays = _mm_set1_epi16((short)decay);
+
+    for (int i = 0; i < DISPLAY_WIDTH * DISPLAY_HEIGHT; i += 16)
+    {
+        // pixels are 0 or 1, so 0 - pixel is 0 or 255
+        __m128i lit = _mm_sub_epi8(zero, _mm_loadu_si128((const __m128i*)&pixels[i]));
+        __m128i old = _mm_loadu_si128((const __m128i*)&intensities[i]);
+
+        __m128i low  = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(old, zero), decays), 8);
+        __m128i high = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(old, zero), decays), 8);
+
+        _mm_storeu_si128((__m128i*)&intensities[i], _mm_max_epu8(lit, _mm_packus_epi16(low, high)));
+    }
+}
+
+TARGET_SSE2 static __m128i selectSSE2(__m128i mask, __m128i chosen, __m128i otherwise)
+{
+    return _mm_or_si128(_mm_and_si128(mask, chosen), _mm_andnot_si128(mask, otherwise));
+}
+
+TARGET_SSE2 static void scale2xSSE2(const Byte* padded, Byte* filtered)
+{
+    for (int y = 0; y < DISPLAY_HEIGHT; y++)
+    {
+        const Byte* row   = &padded[(y + 1) * PADDED_STRIDE + PADDED_OFFSET];
+        const Byte* above = row - PADDED_STRIDE;
+        const Byte* below = row + PADDED_STRIDE;
+
+        Byte* top    = &filtered[y * 2 * DISPLAY_WIDTH * 2];
+        Byte* bottom = top + DISPLAY_WIDTH * 2;
+
+        for (int x = 0; x < DISPLAY_WIDTH; x += 16)
+        {
+            __m128i b = _mm_loadu_si128((const __m128i*)&above[x]);
+            __m128i d = _mm_loadu_si128((const __m128i*)&row[x - 1]);
+            __m128i e = _mm_loadu_si128((const __m128i*)&row[x]);
+            __m128i f = _mm_loadu_si128((const __m128i*)&row[x + 1]);
+            __m128i h = _mm_loadu_si128((const __m128i*)&below[x]);
+
+            __m128i unchanged = _mm_or_si128(_mm_cmpeq_epi8(b, h), _mm_cmpeq_epi8(d, f));
+
+            __m128i e0 = selectSSE2(_mm_andnot_si128(unchanged, _mm_cmpeq_epi8(d, b)), d, e);
+            __m128i e1 = selectSSE2(_mm_andnot_si128(unchanged, _mm_cmpeq_epi8(b, f)), f, e);
+            __m128i e2 = selectSSE2(_mm_andnot_si128(unchanged, _mm_cmpeq_epi8(d, h)), d, e);
+            __m128i e3 = selectSSE2(_mm_andnot_si128(unchanged, _mm_cmpeq_epi8(h, f)), f, e);
+
+            _mm_storeu_si128((__m128i*)&top[x * 2],           _mm_unpacklo_epi8(e0, e1));
+            _mm_storeu_si128((__m128i*)&top[x * 2 + 16],      _mm_unpackhi_epi8(e0, e1));
+            _mm_storeu_si128((__m128i*)&bottom[x * 2],        _mm_unpacklo_epi8(e2, e3));
+            _mm_storeu_si128((__m128i*)&bottom[x * 2 + 16],   _mm_unpackhi_epi8(e2, e3));
+        }
+    }
+}
+
+/*
+    the AVX2 kernels. they work like the SSE2 ones, except that AVX2's unpacks and packs work on each 128-bit half of a
+    register separately
+*/
+
+TARGET_AVX2 static void fillAVX2(unsigned int* pixels, int count, unsigned int colour)
+{
+    if (count < 8)
+    {
+        fillSSE2(pixels, count, colour);
+        return;
+    }
+
+    __m256i colours = _mm256_set1_epi32((int)colour);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_si256((__m256i*)&pixels[i], colours);
+
+    if (i < count)
+        _mm256_storeu_si256((__m256i*)&pixels[count - 8], colours);
+}
+
+TARGET_AVX2 static void copyAVX2(unsigned int* destination, const unsigned int* source, int count)
+{
+    int i = 0;
+
+    while (i < count && ((size_t)&destination[i] & 31) != 0)
+    {
+        destination[i] = source[i];
+        i++;
+    }
+
+    for (; i + 8 <= count; i += 8)
+        _mm256_stream_si256((__m256i*)&destination[i], _mm256_loadu_si256((const __m256i*)&source[i]));
+
+    for (; i < count; i++)
+        destination[i] = source[i];
+}
+
+TARGET_AVX2 static void intensitiesAVX2(const bool* pixels, Byte* intensities, unsigned int decay)
+{
+    __m256i zero   = _mm256_setzero_si256();
+    __m256i decays = _mm256_set1_epi16((short)decay);
+
+    for (int i = 0; i < DISPLAY_WIDTH * DISPLAY_HEIGHT; i += 32)
+    {
+        __m256i lit = _mm256_sub_epi8(zero, _mm256_loadu_si256((const __m256i*)&pixels[i]));
+        __m256i old = _mm256_loadu_si256((const __m256i*)&intensities[i]);
+
+        // packing the halves back together undoes the unpacking's shuffle across them
+        __m256i low  = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(old, zero), decays), 8);
+        __m256i high = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(old, zero), decays), 8);
+
+        _mm256_storeu_si256((__m256i*)&intensities[i], _mm256_max_epu8(lit, _mm256_packus_epi16(low, high)));
+    }
+}
+
+TARGET_AVX2 static void scale2xAVX2(const Byte* padded, Byte* filtered)
+{
+    for (int y = 0; y < DISPLAY_HEIGHT; y++)
+    {
+        const Byte* row   = &padded[(y + 1) * PADDED_STRIDE + PADDED_OFFSET];
+        const Byte* above = row - PADDED_STRIDE;
+        const Byte* below = row + PADDED_STRIDE;
+
+        Byte* top    = &filtered[y * 2 * DISPLAY_WIDTH * 2];
+        Byte* bottom = top + DISPLAY_WIDTH * 2;
+
+        for (int x = 0; x < DISPLAY_WIDTH; x += 32)
+        {
+            __m256i b = _mm256_loadu_si256((const __m256i*)&above[x]);
+            __m256i d = _mm256_loadu_si256((const __m256i*)&row[x - 1]);
+            __m256i e = _mm256_loadu_si256((const __m256i*)&row[x]);
+            __m256i f = _mm256_loadu_si256((const __m256i*)&row[x + 1]);
+            __m256i h = _mm256_loadu_si256((const __m256i*)&below[x]);
+
+            __m256i unchanged = _mm256_or_si256(_mm256_cmpeq_epi8(b, h), _mm256_cmpeq_epi8(d, f));
+
+            __m256i e0 = _mm256_blendv_epi8(e, d, _mm256_andnot_si256(unchanged, _mm256_cmpeq_epi8(d, b)));
+            __m256i e1 = _mm256_blendv_epi8(e, f, _mm256_andnot_si256(unchanged, _mm256_cmpeq_epi8(b, f)));
+            __m256i e2 = _mm256_blendv_epi8(e, d, _mm256_andnot_si256(unchanged, _mm256_cmpeq_epi8(d, h)));
+            __m256i e3 = _mm256_blendv_epi8(e, f, _mm256_andnot_si256(unchanged, _mm256_cmpeq_epi8(h, f)));
+
+            // each unpack interleaves a quarter of the pixels into each half
+            __m256i topLow     = _mm256_unpacklo_epi8(e0, e1);
+            __m256i topHigh    = _mm256_unpackhi_epi8(e0, e1);
+            __m256i bottomLow  = _mm256_unpacklo_epi8(e2, e3);
+            __m256i bottomHigh = _mm256_unpackhi_epi8(e2, e3);
+
+            _mm256_storeu_si256((__m256i*)&top[x * 2],         _mm256_permute2x128_si256(topLow, topHigh, 0x20));
+            _mm256_storeu_si256((__m256i*)&top[x * 2 + 32],    _mm256_permute2x128_si256(topLow, topHigh, 0x31));
+            _mm256_storeu_si256((__m256i*)&bottom[x * 2],      _mm256_permute2x128_si256(bottomLow, bottomHigh, 0x20));
+            _mm256_storeu_si256((__m256i*)&bottom[x * 2 + 32], _mm256_permute2x128_si256(bottomLow, bottomHigh, 0x31));
+        }
+    }
+}
+
+#endif
+
+void initChip8Upscaler(chip8Upscaler* upscaler, chip8UpscaleFilter filter, const Byte background[3], const Byte pixel[3])
+{
+    memset(upscaler, 0, sizeof(chip8Upscaler));
+
+    upscaler->filter = filter;
+    upscaler->kernel = detectChip8UpscaleKernel();
+
+    for (int intensity = 0; intensity < 256; intensity++)
+    {
+        unsigned int colour = 0xFF000000;
+
+        for (int channel = 0; channel < 3; channel++)
+        {
+            int value = background[channel] + (pixel[channel] - background[channel]) * intensity / 255;
+            colour |= (unsigned int)value << (16 - channel * 8);
+        }
+
+        upscaler->palette[intensity] = colour;
+    }
+}
+
+bool findChip8UpscaleFilter(const char* name, chip8UpscaleFilter* filter)
+{
+    for (int i = 0; i < (int)(sizeof(filterNames) / sizeof(filterNames[0])); i++)
+    {
+        if (strcmp(name, filterNames[i]) == 0)
+        {
+            *filter = (chip8UpscaleFilter)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char* describeChip8UpscaleFilter(chip8UpscaleFilter filter)
+{
+    return filterNames[filter];
+}
+
+chip8UpscaleKernel detectChip8UpscaleKernel(void)
+{
+#if defined(UPSCALE_X86) && defined(__GNUC__)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+        return UPSCALE_KERNEL_AVX2;
+
+    if (__builtin_cpu_supports("sse2"))
+        return UPSCALE_KERNEL_SSE2;
+#elif defined(UPSCALE_X86) && defined(_MSC_VER)
+    int info[4];
+
+    __cpuid(info, 0);
+    int highestLeaf = info[0];
+
+    __cpuid(info, 1);
+    bool sse2 = (info[3] >> 26) & 1;
+
+    // AVX2 also needs the operating system to save the upper halves of the registers
+    bool avxEnabled = ((info[2] >> 27) & 1) && ((info[2] >> 28) & 1) && (_xgetbv(0) & 6) == 6;
+
+    if (highestLeaf >= 7 && avxEnabled)
+    {
+        __cpuidex(info, 7, 0);
+        if ((info[1] >> 5) & 1)
+            return UPSCALE_KERNEL_AVX2;
+    }
+
+    if (sse2)
+        return UPSCALE_KERNEL_SSE2;
+#endif
+
+    return UPSCALE_KERNEL_SCALAR;
+}
+
+bool chip8UpscaleKernelSupported(chip8UpscaleKernel kernel)
+{
+    return kernel <= detectChip8UpscaleKernel();
+}
+
+const char* describeChip8UpscaleKernel(chip8UpscaleKernel kernel)
+{
+    return kernelNames[kernel];
+}
+
+static void padIntensities(const Byte* intensities, Byte* padded)
+{
+    for (int y = -1; y <= DISPLAY_HEIGHT; y++)
+    {
+        int sourceY = y < 0 ? 0 : (y == DISPLAY_HEIGHT ? DISPLAY_HEIGHT - 1 : y);
+
+        const Byte* source = &intensities[sourceY * DISPLAY_WIDTH];
+        Byte* row = &padded[(y + 1) * PADDED_STRIDE + PADDED_OFFSET];
+
+        memcpy(row, source, DISPLAY_WIDTH);
+        row[-1]            = source[0];
+        row[DISPLAY_WIDTH] = source[DISPLAY_WIDTH - 1];
+    }
+}
+
+// a row of the filtered image, with each pixel repeated factor times, and the background on either side of it
+static void drawRow(const chip8Upscaler* upscaler, fillFunction fill, const Byte* row, unsigned int* pixels, int width,
+                    int left, int factor)
+{
+    fill(pixels, left, upscaler->palette[0]);
+
+    for (int x = 0; x < upscaler->filteredWidth; x++)
+        fill(&pixels[left + x * factor], factor, upscaler->palette[row[x]]);
+
+    int right = left + upscaler->filteredWidth * factor;
+    fill(&pixels[right], width - right, upscaler->palette[0]);
+}
+
+void upscaleChip8Frame(chip8Upscaler* upscaler, const bool pixels[64 * 32], unsigned int* buffer, int width, int height, int pitch)
+{
+    fillFunction fill           = fillScalar;
+    copyFunction copy           = copyScalar;
+    intensityFunction intensify = intensitiesScalar;
+    filterFunction scale2x      = scale2xScalar;
+
+#ifdef UPSCALE_X86
+    if (upscaler->kernel == UPSCALE_KERNEL_AVX2)
+    {
+        fill      = fillAVX2;
+        copy      = copyAVX2;
+        intensify = intensitiesAVX2;
+        scale2x   = scale2xAVX2;
+    }
+    else if (upscaler->kernel == UPSCALE_KERNEL_SSE2)
+    {
+        fill      = fillSSE2;
+        copy      = copySSE2;
+        intensify = intensitiesSSE2;
+        scale2x   = scale2xSSE2;
+    }
+#endif
+
+    if ((size_t)pitch * height * sizeof(unsigned int) <= STREAMING_THRESHOLD)
+        copy = copyScalar;
+
+    intensify(pixels, upscaler->intensities, upscaler->phosphorDecay);
+
+    if (upscaler->filter == UPSCALE_NEAREST)
+    {
+        memcpy(upscaler->filtered, upscaler->intensities, DISPLAY_WIDTH * DISPLAY_HEIGHT);
+        upscaler->filteredWidth  = DISPLAY_WIDTH;
+        upscaler->filteredHeight = DISPLAY_HEIGHT;
+    }
+    else
+    {
+        Byte padded[(DISPLAY_HEIGHT + 2) * PADDED_STRIDE];
+        padIntensities(upscaler->intensities, padded);
+
+        if (upscaler->filter == UPSCALE_SCALE2X)
+            scale2x(padded, upscaler->filtered);
+        else
+            hq2xScalar(padded, upscaler->filtered);
+
+        upscaler->filteredWidth  = DISPLAY_WIDTH * 2;
+        upscaler->filteredHeight = DISPLAY_HEIGHT * 2;
+    }
+
+    // the largest whole number the filtered image can be enlarged by and still fit
+    int factor = width / upscaler->filteredWidth;
+    if (height / upscaler->filteredHeight < factor)
+        factor = height / upscaler->filteredHeight;
+
+    int top  = factor > 0 ? (height - upscaler->filteredHeight * factor) / 2 : height;
+    int left = (width - upscaler->filteredWidth * factor) / 2;
+
+    for (int y = 0; y < top; y++)
+        fill(&buffer[y * pitch], width, upscaler->palette[0]);
+
+    // each row of the filtered image is drawn once, and copied to the rest of the rows it covers
+    for (int y = 0; factor > 0 && y < upscaler->filteredHeight; y++)
+    {
+        unsigned int* first = &buffer[(top + y * factor) * pitch];
+        drawRow(upscaler, fill, &upscaler->filtered[y * upscaler->filteredWidth], first, width, left, factor);
+
+        for (int repeat = 1; repeat < factor; repeat++)
+            copy(&first[repeat * pitch], first, width);
+    }
+
+#ifdef UPSCALE_X86
+    // the streaming stores aren't ordered with the ones after them, so they have to be finished before the buffer is used
+    if (copy != copyScalar)
+        _mm_sfence();
+#endif
+
+    for (int y = top + upscaler->filteredHeight * factor; y < height; y++)
+        fill(&buffer[y * pitch], width, upscaler->palette[0]);
+}
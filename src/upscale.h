@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "chip8.h"
+
+/*
+    scales the display up on the cpu into a 32-bit (ARGB8888) buffer of any size, such as a streaming texture. a frame
+    goes through three steps:
+
+        1. each pixel becomes an intensity, 255 for lit and 0 for unlit. with the phosphor blend, a pixel that goes out
+           fades over a few frames instead, which hides the flicker of sprites being erased and redrawn with XOR
+        2. the filter:
+               nearest: none
+               scale2x: Scale2x (EPX), which doubles the display and rounds off the corners of diagonal edges
+               hq2x:    doubles the display, blending the pixels along edges. it uses hq2x's interpolations (3:1 with the
+                        corner, 2:1:1 with both sides) chosen by a reduced set of its rules, since the display only has
+                        two colours (or the phosphor's fades of them) rather than arbitrary images to tell apart
+        3. the filtered image is enlarged by the largest whole number that fits the buffer and centred, with the rest
+           of the buffer filled with the background. intensities are turned into colours through a palette running
+           from the background colour to the pixel colour
+
+    at the sizes of real windows nearly all the time goes on the last step (a 4K buffer is 8 million pixels), which
+    along with the intensities and Scale2x has SSE2 and AVX2 kernels. the widest one the processor supports is used
+    unless another is chosen, and they all give the same results
+*/
+
+enum chip8UpscaleFilter
+{
+    UPSCALE_NEAREST,
+    UPSCALE_SCALE2X,
+    UPSCALE_HQ2X
+}; typedef enum chip8UpscaleFilter chip8UpscaleFilter;
+
+enum chip8UpscaleKernel
+{
+    UPSCALE_KERNEL_SCALAR,
+    UPSCALE_KERNEL_SSE2,
+    UPSCALE_KERNEL_AVX2
+}; typedef enum chip8UpscaleKernel chip8UpscaleKernel;
+
+// how much of a faded pixel's intensity is kept each frame with the phosphor blend, out of 256
+#define DEFAULT_PHOSPHOR_DECAY 160
+
+struct chip8Upscaler
+{
+    chip8UpscaleFilter filter;
+    chip8UpscaleKernel kernel;
+
+    // 0 turns the phosphor blend off
+    unsigned int phosphorDecay;
+
+    // the colour of each intensity
+    unsigned int palette[256];
+
+    // the intensities of the last frame, and the filtered image (64 by 32, or 128 by 64 for the 2x filters)
+    Byte intensities[64 * 32];
+    Byte filtered[128 * 64];
+    int filteredWidth, filteredHeight;
+}; typedef struct chip8Upscaler chip8Upscaler;
+
+// sets the upscaler up with the widest kernel the processor supports, and the phosphor blend off
+void initChip8Upscaler(chip8Upscaler* upscaler, chip8UpscaleFilter filter, const Byte background[3], const Byte pixel[3]);
+
+// turns the name of a filter into the filter, returning false if there is no filter with that name
+bool findChip8UpscaleFilter(const char* name, chip8UpscaleFilter* filter);
+const char* describeChip8UpscaleFilter(chip8UpscaleFilter filter);
+
+// the widest kernel the processor supports, and whether it supports a given one
+chip8UpscaleKernel detectChip8UpscaleKernel(void);
+bool chip8UpscaleKernelSupported(chip8UpscaleKernel kernel);
+const char* describeChip8UpscaleKernel(chip8UpscaleKernel kernel);
+
+/*
+    draws a frame into a buffer of width by height pixels, pitch pixels apart from one row to the next. with the
+    phosphor blend, each call is one frame of fading, so it should be called at a steady rate (once every 60Hz frame)
+*/
+void upscaleChip8Frame(chip8Upscaler* upscaler, const bool pixels[64 * 32], unsigned int* buffer, int width, int height, int pitch);
@@ -0,0 +1,317 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "framelog.h"
+#include "vecenv.h"
+
+// how many times a side polls the other before yielding its time slice, and before going to sleep while idle
+#define SPINS_BEFORE_YIELD 1000
+#define SPINS_BEFORE_SLEEP 100000
+
+static size_t alignTo64(size_t size)
+{
+    return (size + 63) & ~(size_t)63;
+}
+
+// points the arrays at their places in the region
+static void locateArrays(chip8VecEnvHeader* header, uint16_t** actions, chip8Observation** observations)
+{
+    *actions      = (uint16_t*)((Byte*)header + header->actionsOffset);
+    *observations = (chip8Observation*)((Byte*)header + header->observationsOffset);
+}
+
+bool createChip8VecEnv(chip8VecEnvServer* server, const char* name, const chip8* snapshot, unsigned int numOfEnvs,
+                       unsigned int frameSkip, unsigned int cyclesPerFrame, bool observeRegisters)
+{
+    memset(server, 0, sizeof(chip8VecEnvServer));
+
+    if (numOfEnvs == 0 || frameSkip == 0 || cyclesPerFrame == 0)
+    {
+        printf("An environment needs at least one instance, frame and cycle per frame\n");
+        return false;
+    }
+
+    size_t actionsOffset      = alignTo64(sizeof(chip8VecEnvHeader));
+    size_t observationsOffset = alignTo64(actionsOffset + numOfEnvs * sizeof(uint16_t));
+    size_t size               = observationsOffset + numOfEnvs * sizeof(chip8Observation);
+
+    server->instances = (chip8*)malloc(numOfEnvs * sizeof(chip8));
+    server->engines   = (chip8FusedEngine*)malloc(numOfEnvs * sizeof(chip8FusedEngine));
+
+    if (server->instances == NULL || server->engines == NULL || !createSharedMemory(&server->memory, name, size))
+    {
+        printf("Failed to create the shared memory for %u instances\n", numOfEnvs);
+        destroyChip8VecEnv(server);
+        return false;
+    }
+
+    server->name = name;
+    server->snapshot = *snapshot;
+    server->header = (chip8VecEnvHeader*)server->memory.address;
+
+    chip8VecEnvHeader* header = server->header;
+    header->version            = CHIP8_VECENV_VERSION;
+    header->numOfEnvs          = numOfEnvs;
+    header->frameSkip          = frameSkip;
+    header->cyclesPerFrame     = cyclesPerFrame;
+    header->observeRegisters   = observeRegisters;
+    header->actionsOffset      = (uint32_t)actionsOffset;
+    header->observationsOffset = (uint32_t)observationsOffset;
+    atomic_init(&header->submitted, 0);
+    atomic_init(&header->completed, 0);
+    atomic_init(&header->serverRunning, 1);
+
+    locateArrays(header, &server->actions, &server->observations);
+
+    for (unsigned int env = 0; env < numOfEnvs; env++)
+        initChip8FusedEngine(&server->engines[env]);
+
+    // every instance starts out reset, so that a learner can step straight away
+    chip8VecEnvCommand reset = { CHIP8_VECENV_RESET, 0, numOfEnvs, 0 };
+    header->ring[0] = reset;
+    atomic_store_explicit(&header->submitted, 1, memory_order_relaxed);
+    serveChip8VecEnvCommands(server);
+
+    // the magic goes in last, so that a learner can't connect to a region that is still being set up
+    atomic_thread_fence(memory_order_release);
+    header->magic = CHIP8_VECENV_MAGIC;
+
+    return true;
+}
+
+static void observe(chip8VecEnvServer* server, unsigned int env)
+{
+    const chip8* instance = &server->instances[env];
+    chip8Observation* observation = &server->observations[env];
+
+    packChip8Frame(instance->pixels, observation->frame);
+
+    if (server->header->observeRegisters)
+    {
+        memcpy(observation->registers, instance->registers, sizeof(observation->registers));
+        observation->indexRegister  = instance->indexRegister;
+        observation->programCounter = instance->programCounter;
+        observation->delayTimer     = instance->delayTimer;
+        observation->soundTimer     = instance->soundTimer;
+    }
+
+    observation->trap = (Byte)instance->trap;
+}
+
+static void resetEnv(chip8VecEnvServer* server, unsigned int env, uint32_t seed)
+{
+    chip8* instance = &server->instances[env];
+
+    memcpy(instance, &server->snapshot, sizeof(chip8));
+    resetChip8FusedEngine(&server->engines[env]);
+
+    if (server->translationCache != NULL)
+        warmChip8FusedEngine(&server->engines[env], server->translationCache);
+
+    // each instance gets its own stream of random numbers from the same seed (the state must never be 0)
+    if (seed != 0)
+        instance->randomState = ((seed * 2654435761u) ^ ((env + 1) * 2246822519u)) | 1;
+
+    server->observations[env].frames = 0;
+    observe(server, env);
+}
+
+void useChip8VecEnvTranslationCache(chip8VecEnvServer* server, const chip8TranslationCache* cache)
+{
+    server->translationCache = cache;
+
+    for (unsigned int env = 0; env < server->header->numOfEnvs; env++)
+        warmChip8FusedEngine(&server->engines[env], cache);
+}
+
+static void stepEnv(chip8VecEnvServer* server, unsigned int env)
+{
+    chip8* instance = &server->instances[env];
+    chip8VecEnvHeader* header = server->header;
+
+    if (instance->trap != CHIP8_OK)
+        return;
+
+    uint16_t action = server->actions[env];
+    for (int key = 0; key < 16; key++)
+        instance->keys[key] = (action >> key) & 1;
+
+    /*
+        stepped through the fused engine even though a frame is only a handful of cycles. on the benchmark ROMs (see
+        tests/benchmark.c) it steps 1.1 to 1.7 times as fast as the interpreter with a frame skip of 4 or 64 cycles a
+        frame (and as fast on self modifying code). with a single frame of 8 the two are level, as packing the
+        observation and the ring take most of a step
+    */
+    for (unsigned int frame = 0; frame < header->frameSkip; frame++)
+    {
+        if (runChip8Fused(&server->engines[env], instance, header->cyclesPerFrame) != CHIP8_OK)
+            break;
+
+        updateChip8Timers(instance);
+        server->observations[env].frames++;
+    }
+
+    // nothing plays sounds here, so the flags would only pile up
+    instance->soundFlag = false;
+    instance->drawFlag  = false;
+
+    observe(server, env);
+}
+
+int serveChip8VecEnvCommands(chip8VecEnvServer* server)
+{
+    chip8VecEnvHeader* header = server->header;
+
+    unsigned long long completed = atomic_load_explicit(&header->completed, memory_order_relaxed);
+    unsigned long long submitted = atomic_load_explicit(&header->submitted, memory_order_acquire);
+    int served = 0;
+
+    for (; completed < submitted; completed++, served++)
+    {
+        chip8VecEnvCommand command = header->ring[completed % CHIP8_VECENV_RING_SIZE];
+
+        // a batch that runs past the last instance is cut short
+        unsigned int first = command.firstEnv < header->numOfEnvs ? command.firstEnv : header->numOfEnvs;
+        unsigned int last  = command.numOfEnvs < header->numOfEnvs - first ? first + command.numOfEnvs : header->numOfEnvs;
+
+        for (unsigned int env = first; env < last; env++)
+        {
+            if (command.type == CHIP8_VECENV_STEP)
+                stepEnv(server, env);
+            else if (command.type == CHIP8_VECENV_RESET)
+                resetEnv(server, env, command.seed);
+        }
+
+        if (command.type == CHIP8_VECENV_SHUTDOWN)
+            atomic_store_explicit(&header->serverRunning, 0, memory_order_relaxed);
+
+        // publishing the count also publishes the observations written for the command
+        atomic_store_explicit(&header->completed, completed + 1, memory_order_release);
+    }
+
+    return served;
+}
+
+void runChip8VecEnvServer(chip8VecEnvServer* server)
+{
+    unsigned long long idleSpins = 0;
+
+    while (atomic_load_explicit(&server->header->serverRunning, memory_order_relaxed))
+    {
+        if (serveChip8VecEnvCommands(server) > 0)
+        {
+            idleSpins = 0;
+            continue;
+        }
+
+        // spin while the learner is busy between steps, and back off once it has gone quiet
+        idleSpins++;
+        if (idleSpins > SPINS_BEFORE_SLEEP)
+            sleepMilliseconds(1);
+        else if (idleSpins > SPINS_BEFORE_YIELD)
+            yieldThread();
+    }
+}
+
+void destroyChip8VecEnv(chip8VecEnvServer* server)
+{
+    if (server->header != NULL)
+        atomic_store(&server->header->serverRunning, 0);
+
+    closeSharedMemory(&server->memory, server->name, true);
+    free(server->instances);
+    free(server->engines);
+
+    server->header    = NULL;
+    server->instances = NULL;
+    server->engines   = NULL;
+}
+
+bool connectChip8VecEnv(chip8VecEnvClient* client, const char* name)
+{
+    memset(client, 0, sizeof(chip8VecEnvClient));
+
+    if (!openSharedMemory(&client->memory, name))
+    {
+        printf("No environment server named %s is running\n", name);
+        return false;
+    }
+
+    chip8VecEnvHeader* header = (chip8VecEnvHeader*)client->memory.address;
+
+    if (client->memory.size < sizeof(chip8VecEnvHeader) || header->magic != CHIP8_VECENV_MAGIC ||
+        header->version != CHIP8_VECENV_VERSION ||
+        client->memory.size < header->observationsOffset + header->numOfEnvs * sizeof(chip8Observation))
+    {
+        printf("%s is not a compatible environment server\n", name);
+        closeSharedMemory(&client->memory, name, false);
+        return false;
+    }
+
+    atomic_thread_fence(memory_order_acquire);
+
+    client->header = header;
+    locateArrays(header, &client->actions, &client->observations);
+
+    return true;
+}
+
+bool submitChip8VecEnv(chip8VecEnvClient* client, chip8VecEnvCommand command, unsigned long long* ticket)
+{
+    chip8VecEnvHeader* header = client->header;
+    *ticket = atomic_load_explicit(&header->submitted, memory_order_relaxed);
+
+    // wait for a free slot if the ring is full, which a server that has gone will never free
+    for (int spins = 0; *ticket - atomic_load_explicit(&header->completed, memory_order_acquire) >= CHIP8_VECENV_RING_SIZE; spins++)
+    {
+        if (!atomic_load_explicit(&header->serverRunning, memory_order_relaxed))
+            return false;
+
+        if (spins > SPINS_BEFORE_YIELD)
+            yieldThread();
+    }
+
+    header->ring[*ticket % CHIP8_VECENV_RING_SIZE] = command;
+
+    // publishing the count also publishes the command and the actions written before it
+    atomic_store_explicit(&header->submitted, *ticket + 1, memory_order_release);
+
+    return true;
+}
+
+bool waitForChip8VecEnv(chip8VecEnvClient* client, unsigned long long ticket)
+{
+    chip8VecEnvHeader* header = client->header;
+
+    for (int spins = 0; atomic_load_explicit(&header->completed, memory_order_acquire) <= ticket; spins++)
+    {
+        if (!atomic_load_explicit(&header->serverRunning, memory_order_relaxed))
+            return atomic_load_explicit(&header->completed, memory_order_acquire) > ticket;
+
+        if (spins > SPINS_BEFORE_YIELD)
+            yieldThread();
+    }
+
+    return true;
+}
+
+bool stepChip8VecEnv(chip8VecEnvClient* client, unsigned int firstEnv, unsigned int numOfEnvs)
+{
+    chip8VecEnvCommand command = { CHIP8_VECENV_STEP, firstEnv, numOfEnvs, 0 };
+    unsigned long long ticket;
+    return submitChip8VecEnv(client, command, &ticket) && waitForChip8VecEnv(client, ticket);
+}
+
+bool resetChip8VecEnv(chip8VecEnvClient* client, unsigned int firstEnv, unsigned int numOfEnvs, unsigned int seed)
+{
+    chip8VecEnvCommand command = { CHIP8_VECENV_RESET, firstEnv, numOfEnvs, seed };
+    unsigned long long ticket;
+    return submitChip8VecEnv(client, command, &ticket) && waitForChip8VecEnv(client, ticket);
+}
+
+void disconnectChip8VecEnv(chip8VecEnvClient* client)
+{
+    closeSharedMemory(&client->memory, NULL, false);
+    client->header = NULL;
+}
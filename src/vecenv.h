@@ -0,0 +1,139 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "chip8.h"
+#include "fused.h"
+#include "platform.h"
+
+/*
+    a vectorized environment for reinforcement learning: a server process hosts many chip8 instances, and a
+    learner steps and resets batches of them through a region of shared memory. the learner writes each
+    instance's keys (as a 16 bit mask) straight into the region, queues a command on a ring, and the server
+    writes the observations straight back, so a step costs no system calls and no copies through a socket.
+
+    a step presses the keys and runs frameSkip frames (cyclesPerFrame instructions and a timer update each) on
+    every instance in the batch. a reset restores the instances from the snapshot the server was started with.
+    an instance that traps stops where it is, and reports it in its observation until it is reset
+*/
+
+#define CHIP8_VECENV_MAGIC    0x43385645 // "C8VE"
+#define CHIP8_VECENV_VERSION  1
+#define CHIP8_VECENV_RING_SIZE 64
+
+enum chip8VecEnvCommandType
+{
+    CHIP8_VECENV_STEP,
+    CHIP8_VECENV_RESET,
+    CHIP8_VECENV_SHUTDOWN
+};
+
+struct chip8VecEnvCommand
+{
+    uint32_t type;
+    uint32_t firstEnv;
+    uint32_t numOfEnvs;
+    uint32_t seed; // for resets: 0 keeps the snapshot's random state, anything else seeds each instance differently
+}; typedef struct chip8VecEnvCommand chip8VecEnvCommand;
+
+// what the learner sees of an instance after each step or reset
+struct chip8Observation
+{
+    Byte frame[64 * 32 / 8]; // the display, 8 pixels a byte (most significant bit first), row by row
+
+    // only filled in if the server was started with observeRegisters
+    Byte registers[16];
+    uint16_t indexRegister;
+    uint16_t programCounter;
+    Byte delayTimer;
+    Byte soundTimer;
+
+    Byte trap;        // the chip8Status that stopped the instance (CHIP8_OK while it is running)
+    Byte padding;
+    uint32_t frames;  // frames run since the last reset
+}; typedef struct chip8Observation chip8Observation;
+
+/*
+    the start of the shared region. the counters the two sides spin on sit on cache lines of their own, and are
+    followed by the command ring, the actions (uint16_t[numOfEnvs]) and the observations (chip8Observation[numOfEnvs])
+*/
+struct chip8VecEnvHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t numOfEnvs;
+    uint32_t frameSkip;
+    uint32_t cyclesPerFrame;
+    uint32_t observeRegisters;
+    uint32_t actionsOffset;
+    uint32_t observationsOffset;
+    atomic_uint serverRunning;
+    Byte padding1[64 - 9 * sizeof(uint32_t)];
+
+    atomic_ullong submitted; // commands queued by the learner
+    Byte padding2[64 - sizeof(atomic_ullong)];
+
+    atomic_ullong completed; // commands finished by the server
+    Byte padding3[64 - sizeof(atomic_ullong)];
+
+    chip8VecEnvCommand ring[CHIP8_VECENV_RING_SIZE];
+}; typedef struct chip8VecEnvHeader chip8VecEnvHeader;
+
+// the learner's side
+struct chip8VecEnvClient
+{
+    PlatformSharedMemory memory;
+    chip8VecEnvHeader* header;
+
+    uint16_t* actions;                 // the keys held down by each instance during the next step (bit n is key n)
+    chip8Observation* observations;
+}; typedef struct chip8VecEnvClient chip8VecEnvClient;
+
+// the server's side
+struct chip8VecEnvServer
+{
+    const char* name;
+    PlatformSharedMemory memory;
+    chip8VecEnvHeader* header;
+
+    uint16_t* actions;
+    chip8Observation* observations;
+
+    chip8 snapshot;
+    chip8* instances;
+    chip8FusedEngine* engines;
+
+    // when set, every engine starts out (and is reset to) warm with what the cache has already decoded
+    const chip8TranslationCache* translationCache;
+}; typedef struct chip8VecEnvServer chip8VecEnvServer;
+
+bool createChip8VecEnv(chip8VecEnvServer* server, const char* name, const chip8* snapshot, unsigned int numOfEnvs,
+                       unsigned int frameSkip, unsigned int cyclesPerFrame, bool observeRegisters);
+
+// warms every instance's engine with a translation cache of the snapshot, which must outlive the server
+void useChip8VecEnvTranslationCache(chip8VecEnvServer* server, const chip8TranslationCache* cache);
+
+// executes every queued command, returning how many there were
+int serveChip8VecEnvCommands(chip8VecEnvServer* server);
+
+// serves commands until a shutdown command arrives
+void runChip8VecEnvServer(chip8VecEnvServer* server);
+
+void destroyChip8VecEnv(chip8VecEnvServer* server);
+
+bool connectChip8VecEnv(chip8VecEnvClient* client, const char* name);
+
+// queues a command without waiting for it, giving a ticket to wait on. returns false if the server stopped while the
+// ring was full, in which case the command was never queued
+bool submitChip8VecEnv(chip8VecEnvClient* client, chip8VecEnvCommand command, unsigned long long* ticket);
+
+// waits for the command with the given ticket (and every one before it), returning false if the server has stopped
+bool waitForChip8VecEnv(chip8VecEnvClient* client, unsigned long long ticket);
+
+// steps or resets a batch of instances, and waits for their observations
+bool stepChip8VecEnv(chip8VecEnvClient* client, unsigned int firstEnv, unsigned int numOfEnvs);
+bool resetChip8VecEnv(chip8VecEnvClient* client, unsigned int firstEnv, unsigned int numOfEnvs, unsigned int seed);
+
+void disconnectChip8VecEnv(chip8VecEnvClient* client);
@@ -0,0 +1,139 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "analysis.h"
+#include "check.h"
+#include "chip8.h"
+
+/*
+    checks the static analysis on small programs: which bytes are code and which are sprites, where the basic
+    blocks start and end, and which instructions are reported
+*/
+
+chip8 chip8Emulator;
+chip8Analysis analysis;
+
+void analyseProgram(const Byte* program, size_t length)
+{
+    initChip8(&chip8Emulator);
+    memcpy(&chip8Emulator.memory[0x200], program, length);
+    analyseChip8(&analysis, chip8Emulator.memory, 0x200);
+}
+
+bool hasFlags(DoubleByte address, Byte flags)
+{
+    return (analysis.flags[address] & flags) == flags;
+}
+
+int countFindings(chip8FindingKind kind, DoubleByte address)
+{
+    int count = 0;
+    for (int finding = 0; finding < analysis.numOfFindings; finding++)
+        count += analysis.findings[finding].kind == kind && analysis.findings[finding].address == address;
+
+    return count;
+}
+
+void testControlFlow()
+{
+    const Byte program[] =
+    {
+        0x00, 0xE0, // 200: CLS
+        0xA2, 0x16, // 202: LD I, 216
+        0x60, 0x00, // 204: LD V0, 00
+        0x61, 0x00, // 206: LD V1, 00
+        0xD0, 0x15, // 208: DRW V0, V1, 5
+        0x22, 0x10, // 20A: CALL 210
+        0x30, 0x01, // 20C: SE V0, 01
+        0x12, 0x0C, // 20E: JP 20C
+        0xB2, 0x00, // 210: JP V0, 200
+        0x00, 0xEE, // 212: RET (never reached, since BNNN isn't followed)
+        0xFF, 0xFF, // 214: data
+        0xF0, 0x90, 0x90, 0x90, 0xF0, // 216: sprite
+    };
+
+    analyseProgram(program, sizeof(program));
+
+    CHECK(analysis.numOfInstructions == 9);
+    CHECK(analysis.numOfBlocks == 4);
+
+    for (DoubleByte address = 0x200; address < 0x212; address += 2)
+        CHECK(hasFlags(address, ANALYSIS_INSTRUCTION | ANALYSIS_CODE) && hasFlags(address + 1, ANALYSIS_CODE));
+
+    CHECK(analysis.flags[0x212] == 0 && analysis.flags[0x214] == 0);
+
+    // a call ends its block, and both the subroutine and the return address start one, as do both outcomes of a skip
+    CHECK(hasFlags(0x200, ANALYSIS_BLOCK_START) && findChip8BlockEnd(&analysis, chip8Emulator.memory, 0x200) == 0x20C);
+    CHECK(hasFlags(0x20C, ANALYSIS_BLOCK_START) && findChip8BlockEnd(&analysis, chip8Emulator.memory, 0x20C) == 0x20E);
+    CHECK(hasFlags(0x20E, ANALYSIS_BLOCK_START) && findChip8BlockEnd(&analysis, chip8Emulator.memory, 0x20E) == 0x210);
+    CHECK(hasFlags(0x210, ANALYSIS_BLOCK_START) && findChip8BlockEnd(&analysis, chip8Emulator.memory, 0x210) == 0x212);
+    CHECK(!hasFlags(0x202, ANALYSIS_BLOCK_START));
+
+    for (DoubleByte address = 0x216; address < 0x21B; address++)
+        CHECK(hasFlags(address, ANALYSIS_SPRITE) && !hasFlags(address, ANALYSIS_CODE));
+
+    CHECK(!hasFlags(0x21B, ANALYSIS_SPRITE));
+
+    CHECK(analysis.numOfFindings == 1);
+    CHECK(countFindings(FINDING_UNRESOLVED_JUMP, 0x210) == 1);
+}
+
+void testFindings()
+{
+    const Byte program[] =
+    {
+        0xA2, 0x0A, // 200: LD I, 20A
+        0xF1, 0x55, // 202: LD [I], V1 (writes over 20A)
+        0xA3, 0x00, // 204: LD I, 300
+        0xF0, 0x33, // 206: LD B, V0 (writes data)
+        0xF0, 0x1E, // 208: ADD I, V0
+        0xF0, 0x55, // 20A: LD [I], V0 (I isn't known any more)
+        0x80, 0x0F, // 20C: unknown
+    };
+
+    analyseProgram(program, sizeof(program));
+
+    CHECK(analysis.numOfFindings == 2);
+    CHECK(countFindings(FINDING_SELF_MODIFYING, 0x202) == 1);
+    CHECK(countFindings(FINDING_UNKNOWN_OPCODE, 0x20C) == 1);
+
+    for (int finding = 0; finding < analysis.numOfFindings; finding++)
+    {
+        if (analysis.findings[finding].kind == FINDING_SELF_MODIFYING)
+            CHECK(analysis.findings[finding].target == 0x20A);
+    }
+
+    CHECK(hasFlags(0x20A, ANALYSIS_WRITTEN | ANALYSIS_CODE) && hasFlags(0x20B, ANALYSIS_WRITTEN));
+    CHECK(hasFlags(0x300, ANALYSIS_WRITTEN) && hasFlags(0x302, ANALYSIS_WRITTEN) && !hasFlags(0x303, ANALYSIS_WRITTEN));
+
+    // nothing follows an unknown opcode, since it would trap
+    CHECK(!hasFlags(0x20E, ANALYSIS_CODE));
+}
+
+void testFormatting()
+{
+    char buffer[32];
+
+    formatChip8Instruction(0xD125, buffer, sizeof(buffer));
+    CHECK(strcmp(buffer, "DRW  V1, V2, 5") == 0);
+
+    formatChip8Instruction(0x8AB6, buffer, sizeof(buffer));
+    CHECK(strcmp(buffer, "SHR  VA, VB") == 0);
+
+    formatChip8Instruction(0xF365, buffer, sizeof(buffer));
+    CHECK(strcmp(buffer, "LD   V3, [I]") == 0);
+
+    formatChip8Instruction(0x0123, buffer, sizeof(buffer));
+    CHECK(strcmp(buffer, "???") == 0);
+}
+
+int main()
+{
+    testControlFlow();
+    testFindings();
+    testFormatting();
+
+    printf("analysis: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,535 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chip8.h"
+#include "colours.h"
+#include "fused.h"
+#include "platform.h"
+#include "upscale.h"
+
+/*
+    throughput benchmarks on synthetic ROMs. throughput on its own says as much about the machine (and whatever else is
+    running on it) as about the code, so each benchmark is measured alongside a reference loop (see runReference),
+    taking turns with it in short runs, and what is compared against benchmark_baselines.txt is the ratio of the two.
+    a benchmark that falls short is measured again, up to BENCHMARK_ATTEMPTS times, before it fails: a regression
+    falls short every time, while a busy spell on a shared machine seldom lasts through all of them
+
+    usage: chip8-bench [--fused] <ROM name> <baselines file> <tolerance>
+        fails if the ROM's throughput relative to the reference loop is more than tolerance (e.g. 0.15 for 15%) below
+        its baseline. with --fused the ROM is run through the fused engine and compared against the baseline named
+        <ROM name>-fused, and the interpreter takes turns too, so that the fused engine's speedup over it can be
+        compared against the baseline named <ROM name>-speedup
+    usage: chip8-bench --record <baselines file>
+        runs over every benchmark RECORD_MEASUREMENTS times and writes the median ratios as the new baselines, so that
+        a busy spell while recording doesn't leave a baseline too low (or a quiet one too high) to catch anything
+
+    the upscale-<filter>-<resolution> benchmarks instead draw frames through the upscaler (with the phosphor blend, and
+    the widest kernel the processor supports) into a buffer of that resolution, and measure frames per second. most of
+    their time goes on writing out the buffer, so their reference is how many times a second the same buffer can be
+    filled with memset (see runFillReference)
+*/
+
+// how long each run lasts, and how many runs each measurement takes turns over (the best of each counts)
+#define BENCHMARK_MILLISECONDS 20.0
+#define BENCHMARK_RUNS         40
+
+// how many times a benchmark is measured before it fails
+#define BENCHMARK_ATTEMPTS 3
+
+// how many times --record measures each benchmark, writing the median of the ratios as the baseline
+#define RECORD_MEASUREMENTS 5
+
+// instructions are run in batches of this size between checks of the clock (and timer updates)
+#define BENCHMARK_BATCH 4096
+
+// iterations of the reference loop between checks of the clock
+#define REFERENCE_BATCH 65536
+
+// arithmetic and logic in a tight loop
+const DoubleByte aluROM[] =
+{
+    0x6001, // 200: V0 = 1
+    0x6103, // 202: V1 = 3
+    0x8014, // 204: V0 += V1
+    0x8105, // 206: V1 -= V0
+    0x8012, // 208: V0 &= V1
+    0x8103, // 20A: V1 ^= V0
+    0x8016, // 20C: V0 >>= 1
+    0x811E, // 20E: V1 <<= 1
+    0x7007, // 210: V0 += 7
+    0x8017, // 212: V0 = V1 - V0
+    0x1204, // 214: jump 204
+};
+
+// font glyphs drawn all over the screen
+const DoubleByte drawROM[] =
+{
+    0x6000, // 200: V0 = 0
+    0x6100, // 202: V1 = 0
+    0xA000, // 204: I = 0
+    0xD015, // 206: draw 5 rows at (V0, V1)
+    0x7003, // 208: V0 += 3
+    0x7101, // 20A: V1 += 1
+    0xF029, // 20C: I = glyph for V0
+    0xD015, // 20E: draw 5 rows at (V0, V1)
+    0x1204, // 210: jump 204
+};
+
+// nested subroutine calls and returns
+const DoubleByte callROM[] =
+{
+    0x2206, // 200: call 206
+    0x2206, // 202: call 206
+    0x1200, // 204: jump 200
+    0x7001, // 206: V0 += 1
+    0x220C, // 208: call 20C
+    0x00EE, // 20A: return
+    0x00EE, // 20C: return
+};
+
+// a loop that rewrites one of its own instructions on every iteration
+const DoubleByte selfModifyingROM[] =
+{
+    0xA20A, // 200: I = 20A
+    0x6062, // 202: V0 = 0x62
+    0x7101, // 204: V1 += 1
+    0xF155, // 206: store V0, V1 at 20A (so that 20A becomes 62NN, with NN = V1)
+    0x7301, // 208: V3 += 1
+    0x6200, // 20A: V2 = NN (rewritten)
+    0x1204, // 20C: jump 204
+};
+
+struct benchmark
+{
+    const char* name;
+    const DoubleByte* rom;
+    int romLength;
+} benchmarks[] =
+{
+    { "alu",           aluROM,           sizeof(aluROM) / sizeof(DoubleByte) },
+    { "draw",          drawROM,          sizeof(drawROM) / sizeof(DoubleByte) },
+    { "call",          callROM,          sizeof(callROM) / sizeof(DoubleByte) },
+    { "selfmodifying", selfModifyingROM, sizeof(selfModifyingROM) / sizeof(DoubleByte) },
+};
+
+#define NUM_OF_BENCHMARKS (int)(sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+struct upscaleBenchmark
+{
+    const char* name;
+    chip8UpscaleFilter filter;
+    int width, height;
+} upscaleBenchmarks[] =
+{
+    { "upscale-nearest-720p",  UPSCALE_NEAREST, 1280, 720 },
+    { "upscale-nearest-1080p", UPSCALE_NEAREST, 1920, 1080 },
+    { "upscale-nearest-1440p", UPSCALE_NEAREST, 2560, 1440 },
+    { "upscale-nearest-4k",    UPSCALE_NEAREST, 3840, 2160 },
+    { "upscale-scale2x-720p",  UPSCALE_SCALE2X, 1280, 720 },
+    { "upscale-scale2x-1080p", UPSCALE_SCALE2X, 1920, 1080 },
+    { "upscale-scale2x-1440p", UPSCALE_SCALE2X, 2560, 1440 },
+    { "upscale-scale2x-4k",    UPSCALE_SCALE2X, 3840, 2160 },
+    { "upscale-hq2x-720p",     UPSCALE_HQ2X,    1280, 720 },
+    { "upscale-hq2x-1080p",    UPSCALE_HQ2X,    1920, 1080 },
+    { "upscale-hq2x-1440p",    UPSCALE_HQ2X,    2560, 1440 },
+    { "upscale-hq2x-4k",       UPSCALE_HQ2X,    3840, 2160 },
+};
+
+#define NUM_OF_UPSCALE_BENCHMARKS (int)(sizeof(upscaleBenchmarks) / sizeof(upscaleBenchmarks[0]))
+
+chip8FusedEngine fusedEngine;
+
+// where the reference loop leaves its result, so that it can't be optimized away
+volatile unsigned int referenceResult;
+
+/*
+    one run of the reference loop, in millions of iterations per second. it steps through a fixed, random program of
+    byte-sized operations dispatched through a switch, loading and storing into a small memory, so that whatever else is
+    running on the machine slows it down much as it does the interpreter (a chain of plain arithmetic hardly notices
+    another program thrashing the branch predictors and the caches)
+*/
+double runReference()
+{
+    Byte program[256];
+    Byte memory[256] = { 0 };
+    Byte registers[4] = { 1, 2, 3, 4 };
+
+    unsigned int seed = 12345;
+    for (int i = 0; i < 256; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        program[i] = seed >> 16;
+    }
+
+    unsigned long long iterations = 0;
+    double start = getTimeMilliseconds();
+    double elapsed = 0.0;
+
+    while (elapsed < BENCHMARK_MILLISECONDS)
+    {
+        for (int i = 0; i < REFERENCE_BATCH; i++)
+        {
+            Byte operation = program[i & 0xFF];
+            Byte* target = &registers[operation & 3];
+
+            switch (operation >> 5)
+            {
+                case 0: *target += operation; break;
+                case 1: *target ^= registers[(operation >> 2) & 3]; break;
+                case 2: memory[*target] = registers[0]; break;
+                case 3: registers[1] = memory[*target]; break;
+                case 4: *target = (Byte)(*target << 1) | (*target >> 7); break;
+                case 5: *target -= registers[3]; break;
+                case 6: if (*target & 1) registers[2]++; break;
+                default: *target = memory[operation]; break;
+            }
+        }
+
+        iterations += REFERENCE_BATCH;
+        elapsed = getTimeMilliseconds() - start;
+    }
+
+    referenceResult = registers[0] + registers[1] + registers[2] + registers[3];
+    return iterations / elapsed / 1000.0;
+}
+
+// one run of filling the buffer with memset, in fills per second
+double runFillReference(unsigned int* buffer, int size)
+{
+    unsigned long long fills = 0;
+    double start = getTimeMilliseconds();
+    double elapsed = 0.0;
+
+    while (elapsed < BENCHMARK_MILLISECONDS)
+    {
+        memset(buffer, (int)fills, size * sizeof(unsigned int));
+
+        fills++;
+        elapsed = getTimeMilliseconds() - start;
+    }
+
+    referenceResult = buffer[size - 1];
+    return fills / elapsed * 1000.0;
+}
+
+// one run of the ROM from the start, in millions of instructions per second
+double runROM(const struct benchmark* bench, bool fused)
+{
+    chip8 chip8Emulator;
+    initChip8(&chip8Emulator);
+
+    for (int i = 0; i < bench->romLength; i++)
+    {
+        chip8Emulator.memory[0x200 + i * 2]     = bench->rom[i] >> 8;
+        chip8Emulator.memory[0x200 + i * 2 + 1] = bench->rom[i] & 0xFF;
+    }
+
+    initChip8FusedEngine(&fusedEngine);
+
+    unsigned long long instructions = 0;
+    double start = getTimeMilliseconds();
+    double elapsed = 0.0;
+
+    while (elapsed < BENCHMARK_MILLISECONDS)
+    {
+        chip8Status status = fused ? runChip8Fused(&fusedEngine, &chip8Emulator, BENCHMARK_BATCH)
+                                   : runChip8Cycles(&chip8Emulator, BENCHMARK_BATCH);
+
+        if (status != CHIP8_OK)
+        {
+            printf("%s trapped: %s\n", bench->name, describeChip8Status(chip8Emulator.trap));
+            exit(1);
+        }
+
+        updateChip8Timers(&chip8Emulator);
+        instructions += BENCHMARK_BATCH;
+        elapsed = getTimeMilliseconds() - start;
+    }
+
+    return instructions / elapsed / 1000.0;
+}
+
+// the best throughput of the reference loop, the interpreter and (if asked for) the fused engine, taking turns
+struct measurement
+{
+    double reference;
+    double interpreter;
+    double fused;
+};
+
+struct measurement measure(const struct benchmark* bench, bool fused)
+{
+    struct measurement best = { 0.0, 0.0, 0.0 };
+
+    for (int runs = 0; runs < BENCHMARK_RUNS; runs++)
+    {
+        double reference   = runReference();
+        double interpreter = runROM(bench, false);
+        double fusedEngine = fused ? runROM(bench, true) : 0.0;
+
+        best.reference   = reference > best.reference ? reference : best.reference;
+        best.interpreter = interpreter > best.interpreter ? interpreter : best.interpreter;
+        best.fused       = fusedEngine > best.fused ? fusedEngine : best.fused;
+    }
+
+    return best;
+}
+
+/*
+    the best frames per second the upscaler draws at the benchmark's resolution with the kernel, and the best fills per
+    second of the same buffer, taking turns
+*/
+struct measurement measureUpscale(const struct upscaleBenchmark* bench, chip8UpscaleKernel kernel)
+{
+    chip8 chip8Emulator;
+    initChip8(&chip8Emulator);
+
+    // the same scene as the draw benchmark
+    for (int i = 0; i < (int)(sizeof(drawROM) / sizeof(DoubleByte)); i++)
+    {
+        chip8Emulator.memory[0x200 + i * 2]     = drawROM[i] >> 8;
+        chip8Emulator.memory[0x200 + i * 2 + 1] = drawROM[i] & 0xFF;
+    }
+
+    runChip8Cycles(&chip8Emulator, 2000);
+
+    /*
+        the buffer starts on a cache line, as a texture's pixels do. otherwise where malloc happens to put it (which
+        changes over the course of a run, as large blocks are freed) decides whether every row straddles cache lines,
+        and the frame rate at 4k can change by half
+    */
+    Byte* allocation = (Byte*)malloc((size_t)bench->width * bench->height * sizeof(unsigned int) + 64);
+    if (allocation == NULL)
+    {
+        printf("Failed to allocate a %dx%d buffer\n", bench->width, bench->height);
+        exit(1);
+    }
+
+    unsigned int* buffer = (unsigned int*)(allocation + (64 - (uintptr_t)allocation % 64) % 64);
+
+    const colourScheme* colours = findColourScheme("default");
+
+    chip8Upscaler upscaler;
+    initChip8Upscaler(&upscaler, bench->filter, colours->background, colours->pixel);
+    upscaler.kernel = kernel;
+    upscaler.phosphorDecay = DEFAULT_PHOSPHOR_DECAY;
+
+    // the frames per second go in the interpreter's place, and the fills per second in the reference loop's
+    struct measurement best = { 0.0, 0.0, 0.0 };
+
+    for (int runs = 0; runs < BENCHMARK_RUNS; runs++)
+    {
+        double reference = runFillReference(buffer, bench->width * bench->height);
+
+        unsigned long long frames = 0;
+        double start = getTimeMilliseconds();
+        double elapsed = 0.0;
+
+        while (elapsed < BENCHMARK_MILLISECONDS)
+        {
+            // every frame is a little different, as it is in a game
+            runChip8Cycles(&chip8Emulator, 8);
+            upscaleChip8Frame(&upscaler, chip8Emulator.pixels, buffer, bench->width, bench->height, bench->width);
+
+            frames++;
+            elapsed = getTimeMilliseconds() - start;
+        }
+
+        double framesPerSecond = frames / elapsed * 1000.0;
+
+        best.reference   = reference > best.reference ? reference : best.reference;
+        best.interpreter = framesPerSecond > best.interpreter ? framesPerSecond : best.interpreter;
+    }
+
+    free(allocation);
+    return best;
+}
+
+// looks up the baseline for the named ROM, returning 0 if there isn't one
+double readBaseline(const char* baselinesFile, const char* name)
+{
+    FILE* file = fopen(baselinesFile, "r");
+    if (file == NULL)
+        return 0.0;
+
+    char line[256], lineName[64];
+    double baseline = 0.0, value;
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        if (line[0] != '#' && sscanf(line, "%63s %lf", lineName, &value) == 2 && strcmp(lineName, name) == 0)
+            baseline = value;
+    }
+
+    fclose(file);
+    return baseline;
+}
+
+// the median of the values, which are sorted in place
+double median(double* values, int count)
+{
+    for (int i = 1; i < count; i++)
+        for (int j = i; j > 0 && values[j - 1] > values[j]; j--)
+        {
+            double value = values[j];
+            values[j] = values[j - 1];
+            values[j - 1] = value;
+        }
+
+    return count % 2 == 1 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2.0;
+}
+
+int record(const char* baselinesFile)
+{
+    // the ratios of each pass over the benchmarks. the passes are spread out over the whole recording, so that a busy
+    // spell only touches one of each benchmark's measurements
+    double ratios[NUM_OF_BENCHMARKS + NUM_OF_UPSCALE_BENCHMARKS][3][RECORD_MEASUREMENTS];
+
+    chip8UpscaleKernel kernel = detectChip8UpscaleKernel();
+
+    for (int m = 0; m < RECORD_MEASUREMENTS; m++)
+    {
+        for (int b = 0; b < NUM_OF_BENCHMARKS; b++)
+        {
+            struct measurement best = measure(&benchmarks[b], true);
+
+            printf("%s: %.1f MIPS, %.1f MIPS fused (%.2fx), reference loop %.1f M/s\n", benchmarks[b].name, best.interpreter,
+                   best.fused, best.fused / best.interpreter, best.reference);
+
+            ratios[b][0][m] = best.interpreter / best.reference;
+            ratios[b][1][m] = best.fused / best.reference;
+            ratios[b][2][m] = best.fused / best.interpreter;
+        }
+
+        for (int b = 0; b < NUM_OF_UPSCALE_BENCHMARKS; b++)
+        {
+            struct measurement best = measureUpscale(&upscaleBenchmarks[b], kernel);
+
+            printf("%s: %.1f fps with the %s kernel, %.1f fills/s\n", upscaleBenchmarks[b].name, best.interpreter,
+                   describeChip8UpscaleKernel(kernel), best.reference);
+
+            ratios[NUM_OF_BENCHMARKS + b][0][m] = best.interpreter / best.reference;
+        }
+    }
+
+    FILE* file = fopen(baselinesFile, "w");
+    if (file == NULL)
+    {
+        printf("Failed to open %s\n", baselinesFile);
+        return 1;
+    }
+
+    fprintf(file, "# the throughput of each benchmark relative to its reference measured in the same run: millions of emulated\n");
+    fprintf(file, "# instructions per million iterations of the reference loop or, for the upscale benchmarks, frames drawn per fill\n");
+    fprintf(file, "# of the same buffer with memset. the -speedup lines are the fused engine's throughput over the interpreter's\n");
+    fprintf(file, "# regenerate with: chip8-bench --record <this file> (on a release build)\n");
+
+    for (int b = 0; b < NUM_OF_BENCHMARKS; b++)
+    {
+        fprintf(file, "%s %.4f\n", benchmarks[b].name, median(ratios[b][0], RECORD_MEASUREMENTS));
+        fprintf(file, "%s-fused %.4f\n", benchmarks[b].name, median(ratios[b][1], RECORD_MEASUREMENTS));
+        fprintf(file, "%s-speedup %.4f\n", benchmarks[b].name, median(ratios[b][2], RECORD_MEASUREMENTS));
+    }
+
+    for (int b = 0; b < NUM_OF_UPSCALE_BENCHMARKS; b++)
+        fprintf(file, "%s %.4f\n", upscaleBenchmarks[b].name, median(ratios[NUM_OF_BENCHMARKS + b][0], RECORD_MEASUREMENTS));
+
+    fclose(file);
+    return 0;
+}
+
+// whether a ratio is within tolerance of its baseline, printing both
+bool checkRatio(const char* name, double ratio, double baseline, double tolerance)
+{
+    printf("%s: %.4f (baseline %.4f, minimum %.4f)\n", name, ratio, baseline, baseline * (1.0 - tolerance));
+    return ratio >= baseline * (1.0 - tolerance);
+}
+
+// measures the ROM and checks it against its baselines
+bool checkBenchmark(const struct benchmark* bench, bool fused, const char* baselinesFile, double tolerance)
+{
+    struct measurement best = measure(bench, fused);
+
+    if (!fused)
+    {
+        printf("%s: %.1f MIPS, reference loop %.1f M/s\n", bench->name, best.interpreter, best.reference);
+        return checkRatio(bench->name, best.interpreter / best.reference, readBaseline(baselinesFile, bench->name), tolerance);
+    }
+
+    printf("%s: %.1f MIPS fused, %.1f MIPS interpreted, reference loop %.1f M/s\n", bench->name, best.fused,
+           best.interpreter, best.reference);
+
+    char fusedName[64], speedupName[64];
+    snprintf(fusedName, sizeof(fusedName), "%s-fused", bench->name);
+    snprintf(speedupName, sizeof(speedupName), "%s-speedup", bench->name);
+
+    bool passed = checkRatio(fusedName, best.fused / best.reference, readBaseline(baselinesFile, fusedName), tolerance);
+    return checkRatio(speedupName, best.fused / best.interpreter, readBaseline(baselinesFile, speedupName), tolerance) && passed;
+}
+
+// measures the upscaler and checks it against its baseline
+bool checkUpscaleBenchmark(const struct upscaleBenchmark* bench, const char* baselinesFile, double tolerance)
+{
+    chip8UpscaleKernel kernel = detectChip8UpscaleKernel();
+    struct measurement best = measureUpscale(bench, kernel);
+
+    printf("%s: %.1f fps with the %s kernel, %.1f fills/s\n", bench->name, best.interpreter,
+           describeChip8UpscaleKernel(kernel), best.reference);
+
+    return checkRatio(bench->name, best.interpreter / best.reference, readBaseline(baselinesFile, bench->name), tolerance);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 3 && strcmp(argv[1], "--record") == 0)
+        return record(argv[2]);
+
+    bool fused = argc > 1 && strcmp(argv[1], "--fused") == 0;
+    if (fused)
+    {
+        argc--;
+        argv++;
+    }
+
+    if (argc != 4)
+    {
+        printf("Usage is: chip8-bench [--fused] <ROM name> <baselines file> <tolerance>\n");
+        printf("          chip8-bench --record <baselines file>\n");
+        return 1;
+    }
+
+    double tolerance = strtod(argv[3], NULL);
+
+    const struct benchmark* bench = NULL;
+    const struct upscaleBenchmark* upscaleBench = NULL;
+
+    for (int b = 0; b < NUM_OF_BENCHMARKS; b++)
+        if (strcmp(argv[1], benchmarks[b].name) == 0)
+            bench = &benchmarks[b];
+
+    for (int b = 0; !fused && b < NUM_OF_UPSCALE_BENCHMARKS; b++)
+        if (strcmp(argv[1], upscaleBenchmarks[b].name) == 0)
+            upscaleBench = &upscaleBenchmarks[b];
+
+    if (bench == NULL && upscaleBench == NULL)
+    {
+        printf("No benchmark named %s\n", argv[1]);
+        return 1;
+    }
+
+    for (int attempt = 1; attempt <= BENCHMARK_ATTEMPTS; attempt++)
+    {
+        bool passed = bench != NULL ? checkBenchmark(bench, fused, argv[2], tolerance)
+                                    : checkUpscaleBenchmark(upscaleBench, argv[2], tolerance);
+        if (passed)
+            return 0;
+
+        if (attempt < BENCHMARK_ATTEMPTS)
+            printf("below the baseline, measuring again (attempt %d of %d)\n", attempt + 1, BENCHMARK_ATTEMPTS);
+    }
+
+    return 1;
+}
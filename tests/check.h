@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdio.h>
+
+/*
+    the check every test is written with. a condition that doesn't hold is reported with where it is and counted in
+    failures, which each test's main turns into its exit code, and the test carries on with the rest of its checks
+*/
+
+static int failures = 0;
+
+#define CHECK(condition)                                                        \
+    do                                                                          \
+    {                                                                           \
+        if (!(condition))                                                       \
+        {                                                                       \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                         \
+        }                                                                       \
+    } while (0)
@@ -0,0 +1,187 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "check.h"
+#include "chip8.h"
+#include "debugger.h"
+
+/*
+    runs small programs under the debugger, checking where it stops on breakpoints, on read and write watchpoints
+    over each instruction that goes through the index register, on the return of a subroutine that calls others,
+    and on a trap
+*/
+
+chip8 chip8Emulator;
+chip8Debugger debugger;
+
+void loadProgram(const DoubleByte* program, int length)
+{
+    initChip8(&chip8Emulator);
+    initChip8Debugger(&debugger);
+
+    for (int i = 0; i < length; i++)
+    {
+        chip8Emulator.memory[0x200 + i * 2]     = program[i] >> 8;
+        chip8Emulator.memory[0x200 + i * 2 + 1] = program[i] & 0xFF;
+    }
+}
+
+#define LOAD(program) loadProgram(program, sizeof(program) / sizeof(DoubleByte))
+
+void testBreakpoints()
+{
+    const DoubleByte program[] =
+    {
+        0x6001, // 200: V0 = 1
+        0x7001, // 202: V0 += 1
+        0x1202, // 204: jump 202
+    };
+
+    LOAD(program);
+    setBreakpoint(&debugger, 0x202, true);
+
+    // stops before the instruction at the breakpoint runs
+    CHECK(runChip8Debugged(&debugger, &chip8Emulator, 100) == DEBUGGER_STOP_BREAKPOINT);
+    CHECK(chip8Emulator.programCounter == 0x202 && chip8Emulator.registers[0] == 1 && debugger.executedCycles == 1);
+
+    // and resumes through it, stopping there again on the next time round the loop
+    CHECK(runChip8Debugged(&debugger, &chip8Emulator, 100) == DEBUGGER_STOP_BREAKPOINT);
+    CHECK(chip8Emulator.programCounter == 0x202 && chip8Emulator.registers[0] == 2 && debugger.executedCycles == 2);
+
+    // setting it again changes nothing, and deleting it once removes it
+    setBreakpoint(&debugger, 0x202, true);
+    CHECK(debugger.numOfBreakpoints == 1 && debugger.breakpointsPerPage[0x2] == 1);
+
+    setBreakpoint(&debugger, 0x202, false);
+    CHECK(debugger.numOfBreakpoints == 0 && debugger.breakpointsPerPage[0x2] == 0 && !debugger.breakpoints[0x202]);
+
+    CHECK(runChip8Debugged(&debugger, &chip8Emulator, 10) == DEBUGGER_STOP_CYCLES);
+    CHECK(debugger.executedCycles == 10 && chip8Emulator.registers[0] == 7);
+}
+
+// I = 300; BCD of 123 at 300; store V0, V1 at 300; load V0, V1 from 300; draw 5 rows from 300
+const DoubleByte memoryProgram[] =
+{
+    0xA300, // 200: I = 300
+    0x607B, // 202: V0 = 123
+    0xF033, // 204: BCD of V0 at I (writes 300 to 302)
+    0x6105, // 206: V1 = 5
+    0xF155, // 208: store V0, V1 at I (writes 300 to 301)
+    0xF165, // 20A: load V0, V1 from I (reads 300 to 301)
+    0xD005, // 20C: draw 5 rows from I (reads 300 to 304)
+    0x120E, // 20E: jump to itself
+};
+
+// runs the program with one watchpoint, returning where it stopped (or 0 if it never did)
+DoubleByte stopsAt(DoubleByte address, Byte access)
+{
+    LOAD(memoryProgram);
+    setWatchpoint(&debugger, address, 1, access);
+
+    if (runChip8Debugged(&debugger, &chip8Emulator, 100) != DEBUGGER_STOP_WATCHPOINT)
+        return 0;
+
+    CHECK(debugger.watchAddress == address && (debugger.watchAccess & access) != 0);
+    return chip8Emulator.programCounter;
+}
+
+void testWatchpoints()
+{
+    // each instruction is stopped on before it touches the watched byte
+    CHECK(stopsAt(0x302, WATCH_WRITE) == 0x204);
+    CHECK(chip8Emulator.memory[0x302] == 0);
+
+    CHECK(stopsAt(0x300, WATCH_READ) == 0x20A);
+    CHECK(stopsAt(0x304, WATCH_READ) == 0x20C);
+
+    // a write watchpoint stops on every write in turn, and ignores the reads
+    CHECK(stopsAt(0x301, WATCH_WRITE) == 0x204 && debugger.watchAccess == WATCH_WRITE);
+    CHECK(runChip8Debugged(&debugger, &chip8Emulator, 100) == DEBUGGER_STOP_WATCHPOINT);
+    CHECK(chip8Emulator.programCounter == 0x208 && chip8Emulator.memory[0x301] == 2);
+    CHECK(runChip8Debugged(&debugger, &chip8Emulator, 100) == DEBUGGER_STOP_CYCLES);
+    CHECK(chip8Emulator.memory[0x301] == 5);
+
+    // one watching both stops on the reads too
+    CHECK(stopsAt(0x301, WATCH_READ | WATCH_WRITE) == 0x204);
+    CHECK(runChip8Debugged(&debugger, &chip8Emulator, 100) == DEBUGGER_STOP_WATCHPOINT && chip8Emulator.programCounter == 0x208);
+    CHECK(runChip8Debugged(&debugger, &chip8Emulator, 100) == DEBUGGER_STOP_WATCHPOINT && chip8Emulator.programCounter == 0x20A);
+    CHECK(debugger.watchAccess == WATCH_READ);
+    CHECK(runChip8Debugged(&debugger, &chip8Emulator, 100) == DEBUGGER_STOP_WATCHPOINT && chip8Emulator.programCounter == 0x20C);
+
+    // bytes just past what is touched, and watchpoints in other pages, never stop it
+    CHECK(stopsAt(0x305, WATCH_READ | WATCH_WRITE) == 0);
+    CHECK(stopsAt(0x2FF, WATCH_READ | WATCH_WRITE) == 0);
+    CHECK(stopsAt(0x500, WATCH_READ | WATCH_WRITE) == 0);
+
+    // removing the watchpoint removes its page's count
+    LOAD(memoryProgram);
+    setWatchpoint(&debugger, 0x300, 4, WATCH_WRITE);
+    setWatchpoint(&debugger, 0x300, 4, 0);
+    CHECK(debugger.numOfWatchpoints == 0 && debugger.watchpointsPerPage[0x3] == 0);
+    CHECK(runChip8Debugged(&debugger, &chip8Emulator, 100) == DEBUGGER_STOP_CYCLES);
+}
+
+void testRunToReturn()
+{
+    const DoubleByte program[] =
+    {
+        0x2206, // 200: call 206
+        0x6301, // 202: V3 = 1
+        0x1204, // 204: jump to itself
+        0x220C, // 206: call 20C
+        0x7001, // 208: V0 += 1
+        0x00EE, // 20A: return
+        0x2210, // 20C: call 210
+        0x00EE, // 20E: return
+        0x7201, // 210: V2 += 1
+        0x00EE, // 212: return
+    };
+
+    LOAD(program);
+
+    // nothing to return from yet
+    CHECK(!runToReturn(&debugger, &chip8Emulator));
+
+    setBreakpoint(&debugger, 0x206, true);
+    CHECK(runChip8Debugged(&debugger, &chip8Emulator, 100) == DEBUGGER_STOP_BREAKPOINT);
+    setBreakpoint(&debugger, 0x206, false);
+
+    // the calls it makes return without stopping, and it stops right after its own return
+    CHECK(runToReturn(&debugger, &chip8Emulator));
+    CHECK(runChip8Debugged(&debugger, &chip8Emulator, 100) == DEBUGGER_STOP_RETURN);
+    CHECK(chip8Emulator.programCounter == 0x202 && chip8Emulator.stackPointer == 0);
+    CHECK(chip8Emulator.registers[0] == 1 && chip8Emulator.registers[2] == 1 && chip8Emulator.registers[3] == 0);
+    CHECK(debugger.executedCycles == 7 && !debugger.runningToReturn);
+}
+
+void testTrap()
+{
+    const DoubleByte program[] =
+    {
+        0x6001, // 200: V0 = 1
+        0x00EE, // 202: return, with nothing to return to
+    };
+
+    // with nothing to stop on, and with a breakpoint that is never reached
+    for (int withBreakpoint = 0; withBreakpoint < 2; withBreakpoint++)
+    {
+        LOAD(program);
+        setBreakpoint(&debugger, 0x300, withBreakpoint);
+
+        CHECK(runChip8Debugged(&debugger, &chip8Emulator, 100) == DEBUGGER_STOP_TRAP);
+        CHECK(debugger.stopReason == DEBUGGER_STOP_TRAP && debugger.executedCycles == 1);
+        CHECK(chip8Emulator.trap == CHIP8_TRAP_STACK_UNDERFLOW && chip8Emulator.trapAddress == 0x202);
+    }
+}
+
+int main()
+{
+    testBreakpoints();
+    testWatchpoints();
+    testRunToReturn();
+    testTrap();
+
+    printf("debugger: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
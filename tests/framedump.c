@@ -0,0 +1,75 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "check.h"
+#include "chip8.h"
+#include "colours.h"
+#include "framedump.h"
+
+/*
+    checks the bytes written by the frame writer for a display with a single lit pixel, in each of the formats
+*/
+
+chip8 chip8Emulator;
+Byte output[64 * 32 * 4 + 256];
+
+// writes one frame of the display in the given format, returning the number of bytes written (read back into output)
+long writeFrame(frameFormat format, int bitsPerPixel, int scale, const char* scheme)
+{
+    FILE* file = tmpfile();
+    if (file == NULL)
+        return -1;
+
+    chip8FrameWriter writer;
+    long length = -1;
+
+    if (openChip8FrameWriter(&writer, fileno(file), format, bitsPerPixel, scale, findColourScheme(scheme)) &&
+        writeChip8Frame(&writer, &chip8Emulator))
+    {
+        rewind(file);
+        length = (long)fread(output, 1, sizeof(output), file);
+    }
+
+    closeChip8FrameWriter(&writer);
+    fclose(file);
+
+    return length;
+}
+
+int main()
+{
+    initChip8(&chip8Emulator);
+
+    // the pixel at (9, 1)
+    chip8Emulator.pixels[9 + 1 * 64] = true;
+
+    // 1 bit raw frames are packed 8 pixels to a byte, most significant bit first
+    CHECK(writeFrame(FRAME_FORMAT_RAW, 1, 1, "default") == 64 * 32 / 8);
+    CHECK(output[1 * 8 + 1] == 0x40);
+    CHECK(output[0] == 0 && output[1 * 8] == 0);
+
+    // scaling by 2 lights a 2x2 block at (18, 2)
+    CHECK(writeFrame(FRAME_FORMAT_RAW, 1, 2, "default") == 128 * 64 / 8);
+    CHECK(output[2 * 16 + 2] == 0x30 && output[3 * 16 + 2] == 0x30);
+    CHECK(output[4 * 16 + 2] == 0);
+
+    // 8 bit frames use the grey levels of the colour scheme (white on black by default)
+    CHECK(writeFrame(FRAME_FORMAT_RAW, 8, 1, "default") == 64 * 32);
+    CHECK(output[9 + 64] == 255 && output[8 + 64] == 0);
+
+    CHECK(writeFrame(FRAME_FORMAT_RAW, 8, 1, "pink") == 64 * 32);
+    CHECK(output[0] == 255 && output[9 + 64] == colourToGrey(findColourScheme("pink")->pixel));
+
+    // y4m streams start with a header, and each frame with its own
+    const char header[] = "YUV4MPEG2 W64 H32 F60:1 Ip A1:1 Cmono\nFRAME\n";
+    CHECK(writeFrame(FRAME_FORMAT_Y4M, 8, 1, "default") == (long)(sizeof(header) - 1 + 64 * 32));
+    CHECK(memcmp(output, header, sizeof(header) - 1) == 0);
+    CHECK(output[sizeof(header) - 1 + 9 + 64] == 255);
+
+    // y4m has no packed format
+    CHECK(writeFrame(FRAME_FORMAT_Y4M, 1, 1, "default") == -1);
+
+    printf("framedump: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
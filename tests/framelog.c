@@ -0,0 +1,116 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "framelog.h"
+
+/*
+    records a sequence of frames (mostly small changes, with some frames that change completely), then checks
+    that every frame reads back exactly, both playing forward and seeking around the log
+*/
+
+#define NUM_OF_FRAMES     1000
+#define KEYFRAME_INTERVAL 64
+#define LOG_FILE          "framelog-test.c8fl"
+
+Byte frames[NUM_OF_FRAMES][PACKED_FRAME_SIZE];
+
+// checks the frame the reader is on against the one that was recorded
+bool frameMatches(const chip8FrameLogReader* log, unsigned int frame)
+{
+    return memcmp(log->frame, frames[frame], PACKED_FRAME_SIZE) == 0;
+}
+
+int main()
+{
+    bool pixels[64 * 32] = { false };
+    unsigned int random = 12345;
+
+    chip8FrameLogWriter writer;
+    CHECK(openChip8FrameLogWriter(&writer, LOG_FILE, KEYFRAME_INTERVAL));
+
+    for (int frame = 0; frame < NUM_OF_FRAMES; frame++)
+    {
+        random = random * 1103515245 + 12345;
+
+        if (frame % 97 == 0)
+        {
+            // a frame that changes everything (e.g. the screen being cleared and redrawn)
+            for (int pixel = 0; pixel < 64 * 32; pixel++)
+                pixels[pixel] = ((pixel * 7 + frame) % 3) == 0;
+        }
+        else if (frame % 5 != 0)
+        {
+            // a sprite moving, which flips a handful of pixels (every fifth frame is left unchanged)
+            for (int flip = 0; flip < (int)(random >> 28); flip++)
+                pixels[(random >> 8) % (64 * 32 - flip * 13) + flip * 13] ^= true;
+        }
+
+        packChip8Frame(pixels, frames[frame]);
+        CHECK(appendChip8FrameLog(&writer, pixels));
+    }
+
+    CHECK(closeChip8FrameLogWriter(&writer));
+
+    // packing is lossless
+    bool unpacked[64 * 32];
+    unpackChip8Frame(frames[NUM_OF_FRAMES - 1], unpacked);
+    CHECK(memcmp(unpacked, pixels, sizeof(pixels)) == 0);
+
+    // and puts the first of each 8 pixels in the most significant bit
+    Byte packed[PACKED_FRAME_SIZE];
+    memset(unpacked, 0, sizeof(unpacked));
+    unpacked[0] = unpacked[9] = unpacked[64 * 32 - 1] = true;
+    packChip8Frame(unpacked, packed);
+    CHECK(packed[0] == 0x80 && packed[1] == 0x40 && packed[2] == 0 && packed[PACKED_FRAME_SIZE - 1] == 0x01);
+
+    chip8FrameLogReader reader;
+    CHECK(openChip8FrameLogReader(&reader, LOG_FILE));
+    CHECK(reader.numOfFrames == NUM_OF_FRAMES);
+    CHECK(reader.keyframeInterval == KEYFRAME_INTERVAL);
+
+    // playing forward
+    bool forward = true;
+    for (unsigned int frame = 0; frame < NUM_OF_FRAMES; frame++)
+        forward = forward && seekChip8FrameLog(&reader, frame) && frameMatches(&reader, frame);
+
+    CHECK(forward);
+
+    // seeking backwards and jumping around
+    bool seeking = true;
+    for (int seek = 0; seek < 200; seek++)
+    {
+        unsigned int frame = (seek * 389) % NUM_OF_FRAMES;
+        seeking = seeking && seekChip8FrameLog(&reader, frame) && frameMatches(&reader, frame);
+    }
+
+    CHECK(seeking);
+    CHECK(!seekChip8FrameLog(&reader, NUM_OF_FRAMES));
+
+    closeChip8FrameLogReader(&reader);
+
+    // the log is far smaller than the frames it holds
+    FILE* file = fopen(LOG_FILE, "rb");
+    CHECK(file != NULL);
+
+    if (file != NULL)
+    {
+        fseek(file, 0L, SEEK_END);
+        CHECK(ftell(file) < NUM_OF_FRAMES * PACKED_FRAME_SIZE / 4);
+        fclose(file);
+    }
+
+    // a log that was never closed has no index, and is refused
+    CHECK(openChip8FrameLogWriter(&writer, LOG_FILE, KEYFRAME_INTERVAL));
+    CHECK(appendChip8FrameLog(&writer, pixels));
+    fflush(writer.file);
+    CHECK(!openChip8FrameLogReader(&reader, LOG_FILE));
+    closeChip8FrameLogWriter(&writer);
+
+    remove(LOG_FILE);
+
+    printf("framelog: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,675 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "check.h"
+#include "chip8.h"
+#include "fused.h"
+
+/*
+    conformance tests for each of the opcodes handled by emulateChip8Cycle. every test loads a short program at
+    0x200, runs it and checks the resulting state. run with the name of a test to run only that test, and with
+    --fused to run the tests through the fused engine instead of the interpreter
+*/
+
+bool useFusedEngine = false;
+chip8FusedEngine fusedEngine;
+
+// initializes the instance and loads the given opcodes at 0x200
+void loadProgram(chip8* chip8ptr, const DoubleByte* opcodes, int numOfOpcodes)
+{
+    initChip8(chip8ptr);
+    chip8ptr->randomState = 1;
+
+    for (int i = 0; i < numOfOpcodes; i++)
+    {
+        chip8ptr->memory[0x200 + i * 2]     = opcodes[i] >> 8;
+        chip8ptr->memory[0x200 + i * 2 + 1] = opcodes[i] & 0xFF;
+    }
+
+    resetChip8FusedEngine(&fusedEngine);
+}
+
+// runs the given number of instructions, returning the status of the last one
+chip8Status run(chip8* chip8ptr, int cycles)
+{
+    if (useFusedEngine)
+        return runChip8Fused(&fusedEngine, chip8ptr, cycles);
+
+    return runChip8Cycles(chip8ptr, cycles);
+}
+
+#define LOAD(chip8ptr, ...)                                          \
+    do                                                               \
+    {                                                                \
+        const DoubleByte program[] = { __VA_ARGS__ };                \
+        loadProgram(chip8ptr, program, sizeof(program) / sizeof(program[0])); \
+    } while (0)
+
+void test0NNN(chip8* c)
+{
+    // machine code routines are not supported, so they trap with the faulting address and opcode
+    LOAD(c, 0x6001, 0x0123);
+    CHECK(run(c, 2) == CHIP8_TRAP_UNKNOWN_OPCODE);
+    CHECK(c->trapAddress == 0x202);
+    CHECK(c->trapOpcode == 0x0123);
+    CHECK(c->programCounter == 0x202);
+
+    // a trapped instance does not run any further
+    CHECK(run(c, 1) == CHIP8_TRAP_UNKNOWN_OPCODE);
+    CHECK(c->programCounter == 0x202);
+}
+
+void test00E0(chip8* c)
+{
+    LOAD(c, 0x00E0);
+    memset(c->pixels, 1, sizeof(c->pixels));
+
+    CHECK(run(c, 1) == CHIP8_OK);
+    CHECK(c->pixels[0] == 0 && c->pixels[64 * 32 - 1] == 0);
+    CHECK(c->drawFlag);
+    CHECK(c->programCounter == 0x202);
+}
+
+void test00EE(chip8* c)
+{
+    LOAD(c, 0x2206, 0x6107, 0x0000, 0x00EE);
+    CHECK(run(c, 2) == CHIP8_OK);
+    CHECK(c->programCounter == 0x202);
+    CHECK(c->stackPointer == 0);
+
+    // returning with nothing on the stack traps
+    LOAD(c, 0x00EE);
+    CHECK(run(c, 1) == CHIP8_TRAP_STACK_UNDERFLOW);
+    CHECK(c->trapAddress == 0x200);
+}
+
+void test1NNN(chip8* c)
+{
+    LOAD(c, 0x1ABC);
+    CHECK(run(c, 1) == CHIP8_OK);
+    CHECK(c->programCounter == 0xABC);
+}
+
+void test2NNN(chip8* c)
+{
+    LOAD(c, 0x2300);
+    CHECK(run(c, 1) == CHIP8_OK);
+    CHECK(c->programCounter == 0x300);
+    CHECK(c->stackPointer == 1);
+    CHECK(c->stack[0] == 0x200);
+
+    // the 17th nested call overflows the stack
+    LOAD(c, 0x2200);
+    CHECK(run(c, 16) == CHIP8_OK);
+    CHECK(run(c, 1) == CHIP8_TRAP_STACK_OVERFLOW);
+    CHECK(c->stackPointer == 16);
+}
+
+void test3XNN(chip8* c)
+{
+    LOAD(c, 0x6342, 0x3342);
+    run(c, 2);
+    CHECK(c->programCounter == 0x206);
+
+    LOAD(c, 0x6342, 0x3343);
+    run(c, 2);
+    CHECK(c->programCounter == 0x204);
+}
+
+void test4XNN(chip8* c)
+{
+    LOAD(c, 0x6342, 0x4343);
+    run(c, 2);
+    CHECK(c->programCounter == 0x206);
+
+    LOAD(c, 0x6342, 0x4342);
+    run(c, 2);
+    CHECK(c->programCounter == 0x204);
+}
+
+void test5XY0(chip8* c)
+{
+    LOAD(c, 0x6342, 0x6442, 0x5340);
+    run(c, 3);
+    CHECK(c->programCounter == 0x208);
+
+    LOAD(c, 0x6342, 0x6441, 0x5340);
+    run(c, 3);
+    CHECK(c->programCounter == 0x206);
+}
+
+void test6XNN(chip8* c)
+{
+    LOAD(c, 0x6EAB);
+    run(c, 1);
+    CHECK(c->registers[0xE] == 0xAB);
+}
+
+void test7XNN(chip8* c)
+{
+    // the addition wraps around without touching the carry register
+    LOAD(c, 0x63F0, 0x7320);
+    run(c, 2);
+    CHECK(c->registers[3] == 0x10);
+    CHECK(c->carryRegister == 0);
+}
+
+void test8XY0(chip8* c)
+{
+    LOAD(c, 0x6155, 0x8210);
+    run(c, 2);
+    CHECK(c->registers[2] == 0x55);
+}
+
+void test8XY1(chip8* c)
+{
+    LOAD(c, 0x61F0, 0x620F, 0x8121);
+    run(c, 3);
+    CHECK(c->registers[1] == 0xFF);
+}
+
+void test8XY2(chip8* c)
+{
+    LOAD(c, 0x61F3, 0x623F, 0x8122);
+    run(c, 3);
+    CHECK(c->registers[1] == 0x33);
+}
+
+void test8XY3(chip8* c)
+{
+    LOAD(c, 0x61F3, 0x623F, 0x8123);
+    run(c, 3);
+    CHECK(c->registers[1] == 0xCC);
+}
+
+void test8XY4(chip8* c)
+{
+    // no carry
+    LOAD(c, 0x6110, 0x6220, 0x8124);
+    run(c, 3);
+    CHECK(c->registers[1] == 0x30);
+    CHECK(c->carryRegister == 0);
+
+    // carry
+    LOAD(c, 0x61C8, 0x6264, 0x8124);
+    run(c, 3);
+    CHECK(c->registers[1] == 0x2C);
+    CHECK(c->carryRegister == 1);
+
+    // exactly 0xFF does not carry, 0x100 does
+    LOAD(c, 0x61FF, 0x6200, 0x8124);
+    run(c, 3);
+    CHECK(c->registers[1] == 0xFF);
+    CHECK(c->carryRegister == 0);
+
+    LOAD(c, 0x61FF, 0x6201, 0x8124);
+    run(c, 3);
+    CHECK(c->registers[1] == 0x00);
+    CHECK(c->carryRegister == 1);
+
+    // a register added to itself
+    LOAD(c, 0x6180, 0x8114);
+    run(c, 2);
+    CHECK(c->registers[1] == 0x00);
+    CHECK(c->carryRegister == 1);
+}
+
+void test8XY5(chip8* c)
+{
+    // no borrow sets the carry register
+    LOAD(c, 0x6130, 0x6210, 0x8125);
+    run(c, 3);
+    CHECK(c->registers[1] == 0x20);
+    CHECK(c->carryRegister == 1);
+
+    // equal values don't borrow
+    LOAD(c, 0x6130, 0x6230, 0x8125);
+    run(c, 3);
+    CHECK(c->registers[1] == 0x00);
+    CHECK(c->carryRegister == 1);
+
+    // a borrow clears it
+    LOAD(c, 0x6110, 0x6230, 0x8125);
+    run(c, 3);
+    CHECK(c->registers[1] == 0xE0);
+    CHECK(c->carryRegister == 0);
+}
+
+void test8XY6(chip8* c)
+{
+    LOAD(c, 0x6105, 0x8106);
+    run(c, 2);
+    CHECK(c->registers[1] == 0x02);
+    CHECK(c->carryRegister == 1);
+
+    LOAD(c, 0x6104, 0x8106);
+    run(c, 2);
+    CHECK(c->registers[1] == 0x02);
+    CHECK(c->carryRegister == 0);
+}
+
+void test8XY7(chip8* c)
+{
+    LOAD(c, 0x6110, 0x6230, 0x8127);
+    run(c, 3);
+    CHECK(c->registers[1] == 0x20);
+    CHECK(c->carryRegister == 1);
+
+    LOAD(c, 0x6130, 0x6230, 0x8127);
+    run(c, 3);
+    CHECK(c->registers[1] == 0x00);
+    CHECK(c->carryRegister == 1);
+
+    LOAD(c, 0x6130, 0x6210, 0x8127);
+    run(c, 3);
+    CHECK(c->registers[1] == 0xE0);
+    CHECK(c->carryRegister == 0);
+}
+
+void test8XYE(chip8* c)
+{
+    LOAD(c, 0x6181, 0x810E);
+    run(c, 2);
+    CHECK(c->registers[1] == 0x02);
+    CHECK(c->carryRegister == 1);
+
+    LOAD(c, 0x6141, 0x810E);
+    run(c, 2);
+    CHECK(c->registers[1] == 0x82);
+    CHECK(c->carryRegister == 0);
+}
+
+void test8XYUnknown(chip8* c)
+{
+    LOAD(c, 0x8128);
+    CHECK(run(c, 1) == CHIP8_TRAP_UNKNOWN_OPCODE);
+    CHECK(c->trapOpcode == 0x8128);
+}
+
+void test9XY0(chip8* c)
+{
+    LOAD(c, 0x6342, 0x6441, 0x9340);
+    run(c, 3);
+    CHECK(c->programCounter == 0x208);
+
+    LOAD(c, 0x6342, 0x6442, 0x9340);
+    run(c, 3);
+    CHECK(c->programCounter == 0x206);
+}
+
+void testANNN(chip8* c)
+{
+    LOAD(c, 0xA123);
+    run(c, 1);
+    CHECK(c->indexRegister == 0x123);
+}
+
+void testBNNN(chip8* c)
+{
+    LOAD(c, 0x6010, 0xB300);
+    run(c, 2);
+    CHECK(c->programCounter == 0x310);
+
+    // the target wraps around chip8's 4kb
+    LOAD(c, 0x60FF, 0xBFFF);
+    run(c, 2);
+    CHECK(c->programCounter == 0x0FE);
+}
+
+void testCXNN(chip8* c)
+{
+    // the result is masked by NN
+    LOAD(c, 0xC10F, 0xC200);
+    run(c, 2);
+    CHECK((c->registers[1] & 0xF0) == 0);
+    CHECK(c->registers[2] == 0);
+
+    // two instances with the same random state produce the same numbers
+    chip8 copy;
+    LOAD(c, 0xC1FF, 0xC2FF);
+    memcpy(&copy, c, sizeof(chip8));
+    run(c, 2);
+    run(&copy, 2);
+    CHECK(c->registers[1] == copy.registers[1] && c->registers[2] == copy.registers[2]);
+}
+
+void testDXYN(chip8* c)
+{
+    // draw the "0" glyph at (1, 2)
+    LOAD(c, 0x6001, 0x6102, 0xA000, 0xD015);
+    run(c, 4);
+    CHECK(c->pixels[1 + 2 * 64] && c->pixels[4 + 2 * 64] && !c->pixels[5 + 2 * 64]);
+    CHECK(c->pixels[1 + 3 * 64] && !c->pixels[2 + 3 * 64]);
+    CHECK(c->carryRegister == 0);
+    CHECK(c->drawFlag);
+
+    // drawing it again erases it and reports the collision
+    LOAD(c, 0x6001, 0x6102, 0xA000, 0xD015, 0xD015);
+    run(c, 5);
+    CHECK(!c->pixels[1 + 2 * 64]);
+    CHECK(c->carryRegister == 1);
+
+    // a sprite starting off the screen wraps around to the other side (70, 35) -> (6, 3)
+    LOAD(c, 0x6046, 0x6123, 0xA000, 0xD011);
+    run(c, 4);
+    CHECK(c->pixels[6 + 3 * 64] && c->pixels[9 + 3 * 64]);
+
+    // a sprite crossing the right edge is clipped rather than wrapped
+    LOAD(c, 0x603E, 0x6100, 0xA000, 0xD011);
+    run(c, 4);
+    CHECK(c->pixels[62] && c->pixels[63]);
+    CHECK(!c->pixels[64] && !c->pixels[0] && !c->pixels[1]);
+
+    // a sprite crossing the bottom edge is clipped, and never writes past the end of the display
+    LOAD(c, 0x6000, 0x611E, 0xA000, 0xD015);
+    run(c, 4);
+    CHECK(c->pixels[30 * 64] && c->pixels[31 * 64]);
+    CHECK(!c->pixels[0]);
+    CHECK(c->trap == CHIP8_OK);
+}
+
+void testEX9E(chip8* c)
+{
+    LOAD(c, 0x6105, 0xE19E);
+    c->keys[5] = true;
+    run(c, 2);
+    CHECK(c->programCounter == 0x206);
+
+    LOAD(c, 0x6105, 0xE19E);
+    run(c, 2);
+    CHECK(c->programCounter == 0x204);
+
+    // only the low nibble of the register selects the key
+    LOAD(c, 0x61F5, 0xE19E);
+    c->keys[5] = true;
+    run(c, 2);
+    CHECK(c->programCounter == 0x206);
+}
+
+void testEXA1(chip8* c)
+{
+    LOAD(c, 0x6105, 0xE1A1);
+    run(c, 2);
+    CHECK(c->programCounter == 0x206);
+
+    LOAD(c, 0x6105, 0xE1A1);
+    c->keys[5] = true;
+    run(c, 2);
+    CHECK(c->programCounter == 0x204);
+}
+
+void testEXUnknown(chip8* c)
+{
+    LOAD(c, 0xE100);
+    CHECK(run(c, 1) == CHIP8_TRAP_UNKNOWN_OPCODE);
+}
+
+void testFX07(chip8* c)
+{
+    LOAD(c, 0xF107);
+    c->delayTimer = 0x3C;
+    run(c, 1);
+    CHECK(c->registers[1] == 0x3C);
+}
+
+void testFX0A(chip8* c)
+{
+    // without a key pressed the instruction waits
+    LOAD(c, 0xF30A);
+    run(c, 3);
+    CHECK(c->programCounter == 0x200);
+
+    c->keys[0xB] = true;
+    run(c, 1);
+    CHECK(c->programCounter == 0x202);
+    CHECK(c->registers[3] == 0xB);
+
+    // several keys held at once still only advance by one instruction
+    LOAD(c, 0xF30A);
+    c->keys[2] = true;
+    c->keys[7] = true;
+    run(c, 1);
+    CHECK(c->programCounter == 0x202);
+    CHECK(c->registers[3] == 2);
+}
+
+void testFX15(chip8* c)
+{
+    LOAD(c, 0x6120, 0xF115);
+    run(c, 2);
+    CHECK(c->delayTimer == 0x20);
+
+    updateChip8Timers(c);
+    CHECK(c->delayTimer == 0x1F);
+}
+
+void testFX18(chip8* c)
+{
+    LOAD(c, 0x6102, 0xF118);
+    run(c, 2);
+    CHECK(c->soundTimer == 2);
+
+    updateChip8Timers(c);
+    CHECK(!c->soundFlag);
+    updateChip8Timers(c);
+    CHECK(c->soundFlag);
+    CHECK(c->soundTimer == 0);
+}
+
+void testFX1E(chip8* c)
+{
+    LOAD(c, 0xA100, 0x6120, 0xF11E);
+    run(c, 3);
+    CHECK(c->indexRegister == 0x120);
+}
+
+void testFX29(chip8* c)
+{
+    LOAD(c, 0x610A, 0xF129);
+    run(c, 2);
+    CHECK(c->indexRegister == 0x32);
+    CHECK(c->memory[c->indexRegister] == 0xF0);
+}
+
+void testFX33(chip8* c)
+{
+    LOAD(c, 0x61FE, 0xA300, 0xF133);
+    run(c, 3);
+    CHECK(c->memory[0x300] == 2 && c->memory[0x301] == 5 && c->memory[0x302] == 4);
+
+    // writes past the end of memory wrap around instead of corrupting the instance
+    LOAD(c, 0x6109, 0xAFFF, 0xF133);
+    run(c, 3);
+    CHECK(c->memory[0xFFF] == 0 && c->memory[0x000] == 0 && c->memory[0x001] == 9);
+}
+
+void testFX55(chip8* c)
+{
+    LOAD(c, 0x6011, 0x6122, 0x6233, 0xA300, 0xF155);
+    run(c, 5);
+    CHECK(c->memory[0x300] == 0x11 && c->memory[0x301] == 0x22);
+    CHECK(c->memory[0x302] == 0);
+    CHECK(c->indexRegister == 0x300);
+}
+
+void testFX65(chip8* c)
+{
+    LOAD(c, 0xA300, 0xF165);
+    c->memory[0x300] = 0x11;
+    c->memory[0x301] = 0x22;
+    c->memory[0x302] = 0x33;
+    run(c, 2);
+    CHECK(c->registers[0] == 0x11 && c->registers[1] == 0x22);
+    CHECK(c->registers[2] == 0);
+}
+
+void testFXUnknown(chip8* c)
+{
+    LOAD(c, 0xF1FF);
+    CHECK(run(c, 1) == CHIP8_TRAP_UNKNOWN_OPCODE);
+}
+
+void testQuirks(chip8* c)
+{
+    // 8XY6 and 8XYE shift VY into VX, with VF from VY
+    LOAD(c, 0x6180, 0x6203, 0x8126);
+    c->quirks = QUIRK_SHIFT_USES_VY;
+    run(c, 3);
+    CHECK(c->registers[1] == 0x01 && c->carryRegister == 1);
+
+    LOAD(c, 0x6101, 0x6281, 0x812E);
+    c->quirks = QUIRK_SHIFT_USES_VY;
+    run(c, 3);
+    CHECK(c->registers[1] == 0x02 && c->carryRegister == 1);
+
+    // FX55 and FX65 leave I past the last register, including when FX65 is fused with FX33
+    LOAD(c, 0xA300, 0xF155, 0xF265);
+    c->quirks = QUIRK_LOAD_STORE_ADVANCE_I;
+    run(c, 3);
+    CHECK(c->indexRegister == 0x305);
+
+    LOAD(c, 0x607B, 0xA300, 0xF033, 0xF265);
+    c->quirks = QUIRK_LOAD_STORE_ADVANCE_I;
+    run(c, 4);
+    CHECK(c->registers[0] == 1 && c->registers[1] == 2 && c->registers[2] == 3);
+    CHECK(c->indexRegister == 0x303);
+
+    // BNNN jumps to XNN plus VX
+    LOAD(c, 0x6010, 0x6320, 0xB300);
+    c->quirks = QUIRK_JUMP_USES_VX;
+    run(c, 3);
+    CHECK(c->programCounter == 0x320);
+
+    // sprites crossing the right and bottom edges wrap around, including when DXYN is fused with ANNN
+    LOAD(c, 0x603E, 0x611E, 0xA000, 0xD015);
+    c->quirks = QUIRK_SPRITES_WRAP;
+    run(c, 4);
+    CHECK(c->pixels[62 + 30 * 64] && c->pixels[63 + 30 * 64] && c->pixels[0 + 30 * 64] && c->pixels[1 + 30 * 64]);
+    CHECK(c->pixels[62 + 0 * 64] && c->pixels[1 + 2 * 64]);
+    CHECK(c->carryRegister == 0);
+
+    // 8XY1, 8XY2 and 8XY3 clear VF
+    LOAD(c, 0x6FF0, 0x610F, 0x8F11);
+    c->quirks = QUIRK_LOGIC_RESETS_VF;
+    run(c, 3);
+    CHECK(c->carryRegister == 0);
+
+    LOAD(c, 0x6F01, 0x61F0, 0x620F, 0x8122, 0x6F01, 0x8123);
+    c->quirks = QUIRK_LOGIC_RESETS_VF;
+    run(c, 4);
+    CHECK(c->registers[1] == 0 && c->carryRegister == 0);
+    run(c, 2);
+    CHECK(c->registers[1] == 0x0F && c->carryRegister == 0);
+}
+
+void testBudget(chip8* c)
+{
+    // an infinite loop is stopped by the instruction budget
+    LOAD(c, 0x1200);
+    c->instructionBudget = 100;
+    CHECK(run(c, 1000) == CHIP8_TRAP_BUDGET_EXCEEDED);
+    CHECK(c->instructionBudget == 0);
+
+    // and can be resumed once the budget is extended
+    c->instructionBudget = 10;
+    c->trap = CHIP8_OK;
+    CHECK(run(c, 10) == CHIP8_OK);
+}
+
+void testFusion(chip8* c)
+{
+    // the sequences the fused engine combines must behave like the instructions run one at a time
+    LOAD(c, 0x600A, 0x6114, 0xA000, 0xD015, 0xF21E, 0x7305);
+    CHECK(run(c, 6) == CHIP8_OK);
+    CHECK(c->registers[0] == 0x0A && c->registers[1] == 0x14 && c->registers[3] == 0x05);
+    CHECK(c->indexRegister == 0 && c->pixels[10 + 20 * 64]);
+    CHECK(c->programCounter == 0x20C);
+
+    // polling the delay timer loops until it reaches the value, then skips the jump
+    LOAD(c, 0xF007, 0x3000, 0x1200, 0x6101);
+    c->delayTimer = 2;
+    CHECK(run(c, 3) == CHIP8_OK);
+    CHECK(c->programCounter == 0x200 && c->registers[0] == 2);
+    c->delayTimer = 0;
+    CHECK(run(c, 3) == CHIP8_OK);
+    CHECK(c->programCounter == 0x208 && c->registers[1] == 1);
+
+    // a slice can end in the middle of a sequence, and a jump can land in the middle of one
+    LOAD(c, 0x6001, 0x6102, 0x1202);
+    CHECK(run(c, 1) == CHIP8_OK);
+    CHECK(c->programCounter == 0x202 && c->registers[1] == 0);
+    CHECK(run(c, 3) == CHIP8_OK);
+    CHECK(c->programCounter == 0x204 && c->registers[1] == 2);
+
+    // the budget also runs out in the middle of a sequence
+    LOAD(c, 0x6001, 0x6102);
+    c->instructionBudget = 1;
+    CHECK(run(c, 2) == CHIP8_TRAP_BUDGET_EXCEEDED);
+    CHECK(c->programCounter == 0x202 && c->registers[1] == 0);
+
+    // the digits written by FX33 replace the FY65 that follows it (F065 becomes 0565, which traps)
+    LOAD(c, 0x60FF, 0xA204, 0xF033, 0xF065);
+    CHECK(run(c, 4) == CHIP8_TRAP_UNKNOWN_OPCODE);
+    CHECK(c->trapAddress == 0x206 && c->trapOpcode == 0x0565);
+
+    // FX55 rewriting an instruction that has already been run (6305 becomes 7301)
+    LOAD(c, 0x6305, 0xA200, 0x6073, 0x6101, 0xF155, 0x1200);
+    CHECK(run(c, 7) == CHIP8_OK);
+    CHECK(c->registers[3] == 6);
+}
+
+struct test
+{
+    const char* name;
+    void (*function)(chip8* chip8ptr);
+} tests[] =
+{
+    { "0NNN", test0NNN }, { "00E0", test00E0 }, { "00EE", test00EE }, { "1NNN", test1NNN },
+    { "2NNN", test2NNN }, { "3XNN", test3XNN }, { "4XNN", test4XNN }, { "5XY0", test5XY0 },
+    { "6XNN", test6XNN }, { "7XNN", test7XNN }, { "8XY0", test8XY0 }, { "8XY1", test8XY1 },
+    { "8XY2", test8XY2 }, { "8XY3", test8XY3 }, { "8XY4", test8XY4 }, { "8XY5", test8XY5 },
+    { "8XY6", test8XY6 }, { "8XY7", test8XY7 }, { "8XYE", test8XYE }, { "8XY_", test8XYUnknown },
+    { "9XY0", test9XY0 }, { "ANNN", testANNN }, { "BNNN", testBNNN }, { "CXNN", testCXNN },
+    { "DXYN", testDXYN }, { "EX9E", testEX9E }, { "EXA1", testEXA1 }, { "EX__", testEXUnknown },
+    { "FX07", testFX07 }, { "FX0A", testFX0A }, { "FX15", testFX15 }, { "FX18", testFX18 },
+    { "FX1E", testFX1E }, { "FX29", testFX29 }, { "FX33", testFX33 }, { "FX55", testFX55 },
+    { "FX65", testFX65 }, { "FX__", testFXUnknown }, { "quirks", testQuirks }, { "budget", testBudget },
+    { "fusion", testFusion },
+};
+
+int main(int argc, char** argv)
+{
+    chip8 chip8Emulator;
+    int numOfTests = sizeof(tests) / sizeof(tests[0]);
+    int testsRun = 0;
+
+    initChip8FusedEngine(&fusedEngine);
+
+    if (argc > 1 && strcmp(argv[1], "--fused") == 0)
+    {
+        useFusedEngine = true;
+        argc--;
+        argv++;
+    }
+
+    for (int t = 0; t < numOfTests; t++)
+    {
+        if (argc > 1 && strcmp(argv[1], tests[t].name) != 0)
+            continue;
+
+        int failuresBefore = failures;
+        tests[t].function(&chip8Emulator);
+        testsRun++;
+
+        printf("%s: %s\n", tests[t].name, failures == failuresBefore ? "ok" : "FAILED");
+    }
+
+    if (testsRun == 0)
+    {
+        printf("No test named %s\n", argv[1]);
+        return 1;
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "chip8.h"
+#include "rompack.h"
+
+/*
+    builds a pack of many small ROMs, and checks that each can be found by name and by hash and loads intact.
+    also checks that loadChip8 refuses ROMs that don't fit, and that damaged packs are refused
+*/
+
+#define NUM_OF_ROMS 1000
+#define PACK_FILE   "rompack-test.c8pk"
+#define ROM_FILE    "rompack-test.ch8"
+
+Byte images[NUM_OF_ROMS][64];
+char names[NUM_OF_ROMS][32];
+chip8ROMPackInput roms[NUM_OF_ROMS];
+chip8 chip8Emulator;
+
+bool writeFile(const char* path, const Byte* data, size_t length)
+{
+    FILE* file = fopen(path, "wb");
+    if (file == NULL)
+        return false;
+
+    bool written = fwrite(data, 1, length, file) == length;
+    return fclose(file) == 0 && written;
+}
+
+int main()
+{
+    for (int rom = 0; rom < NUM_OF_ROMS; rom++)
+    {
+        for (int b = 0; b < 64; b++)
+            images[rom][b] = (Byte)(rom * 31 + b * 7 + (rom >> 8));
+
+        snprintf(names[rom], sizeof(names[rom]), "rom%d.ch8", rom);
+
+        roms[rom].name   = names[rom];
+        roms[rom].data   = images[rom];
+        roms[rom].length = 1 + rom % 64;
+        roms[rom].quirks = rom % 32;
+        roms[rom].instructionsPerSecond = 500 + rom;
+        memcpy(roms[rom].keyMap, DEFAULT_KEY_MAP, sizeof(roms[rom].keyMap));
+    }
+
+    CHECK(writeChip8ROMPack(PACK_FILE, roms, NUM_OF_ROMS));
+
+    chip8ROMPack pack;
+    CHECK(openChip8ROMPack(&pack, PACK_FILE));
+
+    if (failures > 0)
+    {
+        printf("rompack: FAILED\n");
+        return 1;
+    }
+
+    CHECK(pack.header->numOfROMs == NUM_OF_ROMS);
+
+    bool allFound = true;
+    for (int rom = 0; rom < NUM_OF_ROMS; rom++)
+    {
+        const chip8ROMEntry* byName = findChip8ROMByName(&pack, names[rom]);
+        const chip8ROMEntry* byHash = findChip8ROMByHash(&pack, hashChip8ROM(images[rom], roms[rom].length));
+
+        allFound = allFound && byName != NULL && byName == byHash && strcmp(getChip8ROMName(&pack, byName), names[rom]) == 0 &&
+                   byName->instructionsPerSecond == 500u + rom && byName->quirks == (uint32_t)(rom % 32);
+    }
+
+    CHECK(allFound);
+    CHECK(findChip8ROMByName(&pack, "missing.ch8") == NULL);
+    CHECK(findChip8ROMByHash(&pack, 0x123456789ULL) == NULL);
+
+    // the image lands at 0x200, nothing after it is touched, and the instance takes on the ROM's quirks
+    initChip8(&chip8Emulator);
+    const chip8ROMEntry* entry = findChip8ROMByName(&pack, "rom63.ch8");
+    loadChip8FromPack(&chip8Emulator, &pack, entry);
+    CHECK(memcmp(&chip8Emulator.memory[0x200], images[63], 64) == 0);
+    CHECK(chip8Emulator.memory[0x200 + 64] == 0);
+    CHECK(chip8Emulator.quirks == 63 % 32);
+
+    closeChip8ROMPack(&pack);
+
+    // a pack whose tables point past its end is refused
+    FILE* file = fopen(PACK_FILE, "r+b");
+    CHECK(file != NULL);
+
+    if (file != NULL)
+    {
+        Byte huge[4] = { 0xFF, 0xFF, 0xFF, 0x7F };
+        fseek(file, 8, SEEK_SET);
+        fwrite(huge, 1, sizeof(huge), file);
+        fclose(file);
+
+        CHECK(!openChip8ROMPack(&pack, PACK_FILE));
+    }
+
+    // names have to be unique
+    roms[1].name = roms[0].name;
+    CHECK(!writeChip8ROMPack(PACK_FILE, roms, 2));
+
+    remove(PACK_FILE);
+
+    // loadChip8 reads a ROM that exactly fills memory, and refuses one a byte longer
+    static Byte largest[4096 - 0x200 + 1];
+    memset(largest, 0xAB, sizeof(largest));
+
+    CHECK(writeFile(ROM_FILE, largest, sizeof(largest) - 1));
+    initChip8(&chip8Emulator);
+    CHECK(loadChip8(ROM_FILE, &chip8Emulator));
+    CHECK(chip8Emulator.memory[0x200] == 0xAB && chip8Emulator.memory[4095] == 0xAB);
+
+    CHECK(writeFile(ROM_FILE, largest, sizeof(largest)));
+    CHECK(!loadChip8(ROM_FILE, &chip8Emulator));
+
+    remove(ROM_FILE);
+    CHECK(!loadChip8(ROM_FILE, &chip8Emulator));
+
+    printf("rompack: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,220 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "check.h"
+#include "chip8.h"
+#include "platform.h"
+#include "scheduler.h"
+
+/*
+    runs instances on the scheduler at a high frame rate, and checks that they end up exactly where running them frame
+    by frame on their own would, that an instance waiting in FX0A is parked until a key is pressed, and that an instance
+    polling the delay timer sleeps through the wait without leaving it any later than it would have
+*/
+
+#define FRAMES_PER_SECOND 2000
+#define CYCLES_PER_FRAME  16
+#define CYCLES_PER_SLICE  5
+#define NUM_OF_INSTANCES  64
+#define NUM_OF_WORKERS    3
+
+chip8Scheduler scheduler;
+chip8ScheduledInstance copy;
+
+void loadProgram(chip8* chip8ptr, const Byte* program, size_t length)
+{
+    initChip8(chip8ptr);
+    memcpy(&chip8ptr->memory[0x200], program, length);
+}
+
+// waits (for up to a few seconds) until the instance has run the given number of frames
+bool waitForFrames(int instance, unsigned long long frames)
+{
+    for (int wait = 0; wait < 5000; wait++)
+    {
+        copyChip8Instance(&scheduler, instance, &copy);
+        if (copy.frames >= frames || copy.state != INSTANCE_RUNNABLE)
+            return copy.frames >= frames;
+
+        sleepMilliseconds(1);
+    }
+
+    return false;
+}
+
+bool sameState(const chip8* a, const chip8* b)
+{
+    return memcmp(a->registers, b->registers, sizeof(a->registers)) == 0 && a->indexRegister == b->indexRegister &&
+           a->programCounter == b->programCounter && a->delayTimer == b->delayTimer &&
+           memcmp(a->memory, b->memory, sizeof(a->memory)) == 0 && memcmp(a->pixels, b->pixels, sizeof(a->pixels)) == 0;
+}
+
+void testMatchesSequential()
+{
+    // counts, draws and stores with random numbers, from a different seed in each instance
+    const Byte program[] =
+    {
+        0xC0, 0x3F, // 200: V0 = random & 3F
+        0xC1, 0x1F, // 202: V1 = random & 1F
+        0xA2, 0x14, // 204: I = 214
+        0xD0, 0x13, // 206: draw
+        0x72, 0x01, // 208: V2 += 1
+        0xA3, 0x00, // 20A: I = 300
+        0xF2, 0x33, // 20C: BCD of V2
+        0xF3, 0x15, // 20E: delay timer = V3
+        0x12, 0x00, // 210: jump to 200
+        0x00, 0x00,
+        0xE0, 0xA0, 0xE0, // 214: sprite
+    };
+
+    static chip8 initial[NUM_OF_INSTANCES];
+
+    CHECK(createChip8Scheduler(&scheduler, NUM_OF_INSTANCES, NUM_OF_WORKERS, CYCLES_PER_FRAME, CYCLES_PER_SLICE, FRAMES_PER_SECOND));
+
+    for (int instance = 0; instance < NUM_OF_INSTANCES; instance++)
+    {
+        loadProgram(&initial[instance], program, sizeof(program));
+        initial[instance].randomState = 0x9E3779B9u * (instance + 1) | 1;
+        initial[instance].registers[3] = (Byte)instance;
+
+        CHECK(addChip8Instance(&scheduler, &initial[instance]) == instance);
+    }
+
+    CHECK(startChip8Scheduler(&scheduler));
+
+    for (int instance = 0; instance < NUM_OF_INSTANCES; instance++)
+    {
+        CHECK(waitForFrames(instance, 50));
+
+        // the copy can be taken between two slices of a frame
+        chip8 expected = initial[instance];
+        for (unsigned long long frame = 0; frame < copy.frames; frame++)
+        {
+            runChip8Cycles(&expected, CYCLES_PER_FRAME);
+            updateChip8Timers(&expected);
+        }
+
+        runChip8Cycles(&expected, CYCLES_PER_FRAME - copy.cyclesLeft);
+        CHECK(sameState(&copy.machine, &expected));
+    }
+
+    stopChip8Scheduler(&scheduler);
+
+    chip8SchedulerStats stats;
+    getChip8SchedulerStats(&scheduler, &stats);
+    CHECK(stats.frames >= 50 * NUM_OF_INSTANCES);
+    CHECK(stats.slices >= stats.frames * ((CYCLES_PER_FRAME + CYCLES_PER_SLICE - 1) / CYCLES_PER_SLICE));
+    CHECK(stats.parks == 0 && stats.trapped == 0);
+
+    destroyChip8Scheduler(&scheduler);
+}
+
+void testParkedOnKey()
+{
+    const Byte program[] =
+    {
+        0xF0, 0x0A, // 200: V0 = the next key pressed
+        0x61, 0x01, // 202: V1 = 1
+        0x12, 0x04, // 204: jump to itself
+    };
+
+    chip8 initial;
+    loadProgram(&initial, program, sizeof(program));
+    initial.delayTimer = 100;
+
+    CHECK(createChip8Scheduler(&scheduler, 1, 1, CYCLES_PER_FRAME, CYCLES_PER_SLICE, FRAMES_PER_SECOND));
+    addChip8Instance(&scheduler, &initial);
+    CHECK(startChip8Scheduler(&scheduler));
+
+    // it parks straight away, and runs nothing until a key is pressed
+    sleepMilliseconds(20);
+
+    chip8SchedulerStats stats;
+    getChip8SchedulerStats(&scheduler, &stats);
+    CHECK(stats.parkedOnKey == 1 && stats.slices == 1);
+
+    copyChip8Instance(&scheduler, 0, &copy);
+    CHECK(copy.state == INSTANCE_PARKED_ON_KEY && copy.machine.registers[1] == 0);
+
+    // the frames that went by while it waited are skipped as it wakes, so wait for it to get past FX0A instead
+    setChip8InstanceKey(&scheduler, 0, 0x7, true);
+    for (int wait = 0; wait < 5000 && copy.machine.registers[1] == 0; wait++)
+    {
+        sleepMilliseconds(1);
+        copyChip8Instance(&scheduler, 0, &copy);
+    }
+
+    CHECK(copy.machine.registers[0] == 0x7 && copy.machine.registers[1] == 1);
+
+    // the timers kept counting while it waited
+    CHECK(copy.machine.delayTimer < 100 - 20 * FRAMES_PER_SECOND / 1000 / 2);
+
+    stopChip8Scheduler(&scheduler);
+    destroyChip8Scheduler(&scheduler);
+}
+
+// the frame the last instance finished V2 was first seen set in, from the frame callback
+unsigned long long firstFrameSet = 0;
+
+void recordFirstFrameSet(chip8Scheduler* schedulerptr, int instance, void* userData)
+{
+    (void)userData;
+
+    const chip8ScheduledInstance* scheduled = &schedulerptr->instances[instance];
+    if (firstFrameSet == 0 && scheduled->machine.registers[2] == 1)
+        firstFrameSet = scheduled->frames;
+}
+
+void testSleepsOnDelayTimer()
+{
+    const Byte program[] =
+    {
+        0x60, 0x28, // 200: V0 = 40
+        0xF0, 0x15, // 202: delay timer = V0
+        0xF1, 0x07, // 204: V1 = delay timer
+        0x31, 0x03, // 206: skip if V1 == 3
+        0x12, 0x04, // 208: jump to 204
+        0x62, 0x01, // 20A: V2 = 1
+        0x12, 0x0C, // 20C: jump to itself
+    };
+
+    chip8 initial;
+    loadProgram(&initial, program, sizeof(program));
+
+    // the frame V2 is set in when the instance runs every frame
+    chip8 expected = initial;
+    unsigned long long expectedFrame = 0;
+    while (expected.registers[2] != 1)
+    {
+        runChip8Cycles(&expected, CYCLES_PER_FRAME);
+        updateChip8Timers(&expected);
+        expectedFrame++;
+    }
+
+    CHECK(createChip8Scheduler(&scheduler, 1, 1, CYCLES_PER_FRAME, CYCLES_PER_SLICE, FRAMES_PER_SECOND));
+    scheduler.onFrame = recordFirstFrameSet;
+    addChip8Instance(&scheduler, &initial);
+    CHECK(startChip8Scheduler(&scheduler));
+
+    CHECK(waitForFrames(0, expectedFrame + 5));
+    stopChip8Scheduler(&scheduler);
+
+    CHECK(firstFrameSet == expectedFrame);
+
+    chip8SchedulerStats stats;
+    getChip8SchedulerStats(&scheduler, &stats);
+    CHECK(stats.sleptFrames > 30 && stats.parks == 1);
+
+    destroyChip8Scheduler(&scheduler);
+}
+
+int main()
+{
+    testMatchesSequential();
+    testParkedOnKey();
+    testSleepsOnDelayTimer();
+
+    printf("scheduler: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
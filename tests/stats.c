@@ -0,0 +1,86 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "check.h"
+#include "stats.h"
+
+/*
+    checks the metrics written in prometheus' text format: every sample carries the instance label, the counters'
+    values, and that instance names with backslashes, quotes and line feeds are escaped into valid label values
+*/
+
+chip8Stats stats;
+
+// the size of the metrics server's buffer
+char buffer[4096];
+
+// whether every line is a comment or a sample with a properly quoted label value
+bool validExposition(const char* text)
+{
+    const char* line = text;
+
+    while (*line != '\0')
+    {
+        const char* end = strchr(line, '\n');
+        if (end == NULL)
+            return false;
+
+        if (line[0] != '#')
+        {
+            const char* label = strstr(line, "{instance=\"");
+            if (label == NULL || label > end)
+                return false;
+
+            // skip to the closing quote, stepping over escapes
+            const char* value = label + strlen("{instance=\"");
+            while (value < end && *value != '"')
+                value += *value == '\\' ? 2 : 1;
+
+            if (value >= end || value[1] != '}' || value[2] != ' ')
+                return false;
+        }
+
+        line = end + 1;
+    }
+
+    return true;
+}
+
+int main()
+{
+    initChip8Stats(&stats, 500.0);
+    stats.instructions  = 12345;
+    stats.presents      = 678;
+    stats.skippedFrames = 9;
+
+    int length = formatChip8Metrics(&stats, "pong.ch8", buffer, sizeof(buffer));
+    CHECK(length > 0 && length < (int)sizeof(buffer));
+    CHECK(strstr(buffer, "chip8_instructions_total{instance=\"pong.ch8\"} 12345\n") != NULL);
+    CHECK(strstr(buffer, "chip8_presents_total{instance=\"pong.ch8\"} 678\n") != NULL);
+    CHECK(strstr(buffer, "chip8_skipped_frames_total{instance=\"pong.ch8\"} 9\n") != NULL);
+    CHECK(strstr(buffer, "chip8_target_instructions_per_second{instance=\"pong.ch8\"} 500.0\n") != NULL);
+    CHECK(strstr(buffer, "# TYPE chip8_instructions_total counter\n") != NULL);
+    CHECK(validExposition(buffer));
+
+    // a windows path, and a name with a quote and a line feed in it
+    formatChip8Metrics(&stats, "C:\\roms\\pong.ch8", buffer, sizeof(buffer));
+    CHECK(strstr(buffer, "chip8_presents_total{instance=\"C:\\\\roms\\\\pong.ch8\"} 678\n") != NULL);
+    CHECK(validExposition(buffer));
+
+    formatChip8Metrics(&stats, "a \"b\"\nc", buffer, sizeof(buffer));
+    CHECK(strstr(buffer, "chip8_presents_total{instance=\"a \\\"b\\\"\\nc\"} 678\n") != NULL);
+    CHECK(validExposition(buffer));
+
+    // a very long name is cut short rather than overflowing, and never in the middle of an escape
+    char longName[2000];
+    memset(longName, '\\', sizeof(longName) - 1);
+    longName[sizeof(longName) - 1] = '\0';
+
+    length = formatChip8Metrics(&stats, longName, buffer, sizeof(buffer));
+    CHECK(length > 0 && length < (int)sizeof(buffer));
+    CHECK(validExposition(buffer));
+
+    printf("stats: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "chip8.h"
+#include "fused.h"
+#include "rompack.h"
+
+/*
+    runs a self modifying ROM on the fused engine, saves what it decoded to a translation cache and checks that an
+    engine warmed from the cache behaves exactly like the interpreter. also checks that caches for other images,
+    other engine versions and damaged caches are ignored
+*/
+
+#define CACHE_DIRECTORY "."
+
+// overwrites the 7005 at 0x20C with 7101 before running it, then spins
+const Byte program[] =
+{
+    0xA2, 0x0C, // 200: I = 0x20C
+    0x60, 0x71, // 202: V0 = 0x71
+    0x61, 0x01, // 204: V1 = 0x01
+    0xF1, 0x55, // 206: store V0..V1 at I
+    0x62, 0x00, // 208: V2 = 0
+    0x63, 0x00, // 20A: V3 = 0
+    0x70, 0x05, // 20C: V0 += 5 (rewritten to V1 += 1)
+    0x12, 0x0E, // 20E: jump to itself
+};
+
+chip8 pristine, interpreted, cold, warm;
+chip8FusedEngine engine;
+chip8TranslationCache cache, loaded;
+
+void cachePath(char* path, size_t size, const chip8* image)
+{
+    snprintf(path, size, "%s/%016llx-%u.c8tc", CACHE_DIRECTORY,
+        (unsigned long long)hashChip8ROM(image->memory, sizeof(image->memory)), CHIP8_FUSED_ENGINE_VERSION);
+}
+
+bool sameState(const chip8* a, const chip8* b)
+{
+    return memcmp(a->registers, b->registers, sizeof(a->registers)) == 0 && a->indexRegister == b->indexRegister &&
+           a->programCounter == b->programCounter && memcmp(a->memory, b->memory, sizeof(a->memory)) == 0;
+}
+
+bool decoded(const chip8TranslationCache* translationCache, int address)
+{
+    return translationCache->entries[address].generation != 0;
+}
+
+int main()
+{
+    initChip8(&pristine);
+    memcpy(&pristine.memory[0x200], program, sizeof(program));
+
+    interpreted = pristine;
+    CHECK(runChip8Cycles(&interpreted, 100) == CHIP8_OK);
+    CHECK(interpreted.registers[1] == 0x02);
+
+    // a cold run, whose decodes are captured and saved
+    cold = pristine;
+    initChip8FusedEngine(&engine);
+    CHECK(runChip8Fused(&engine, &cold, 100) == CHIP8_OK);
+    CHECK(sameState(&cold, &interpreted));
+
+    char path[1024];
+    cachePath(path, sizeof(path), &pristine);
+    remove(path);
+
+    CHECK(!loadChip8TranslationCache(&loaded, &pristine, CACHE_DIRECTORY));
+
+    initChip8TranslationCache(&cache);
+    CHECK(captureChip8TranslationCache(&cache, &engine, &pristine) > 0);
+    CHECK(decoded(&cache, 0x200) && decoded(&cache, 0x20C) && decoded(&cache, 0x20E));
+    CHECK(!decoded(&cache, 0x210));
+
+    CHECK(saveChip8TranslationCache(&cache, &pristine, CACHE_DIRECTORY));
+    CHECK(loadChip8TranslationCache(&loaded, &pristine, CACHE_DIRECTORY));
+    CHECK(memcmp(&loaded, &cache, sizeof(cache)) == 0);
+
+    // a warm run must still pick up the rewritten instruction, since the cache holds what was decoded before the write
+    warm = pristine;
+    initChip8FusedEngine(&engine);
+    warmChip8FusedEngine(&engine, &loaded);
+    CHECK(runChip8Fused(&engine, &warm, 100) == CHIP8_OK);
+    CHECK(sameState(&warm, &interpreted));
+
+    // and, having reached no code the cache didn't have, adds nothing to it (so there is nothing to save)
+    CHECK(captureChip8TranslationCache(&loaded, &engine, &pristine) == 0);
+
+    // a cache is never used for another image
+    chip8 other = pristine;
+    other.memory[0x300] = 1;
+    CHECK(!loadChip8TranslationCache(&loaded, &other, CACHE_DIRECTORY));
+
+    FILE* file = fopen(path, "r+b");
+    CHECK(file != NULL);
+
+    if (file != NULL)
+    {
+        // or written by another version of the engine
+        unsigned int version = CHIP8_FUSED_ENGINE_VERSION + 1;
+        fseek(file, 4, SEEK_SET);
+        fwrite(&version, sizeof(version), 1, file);
+        fclose(file);
+
+        CHECK(!loadChip8TranslationCache(&loaded, &pristine, CACHE_DIRECTORY));
+    }
+
+    // or cut short
+    CHECK(saveChip8TranslationCache(&cache, &pristine, CACHE_DIRECTORY));
+    file = fopen(path, "r+b");
+    CHECK(file != NULL);
+
+    if (file != NULL)
+    {
+        static Byte contents[sizeof(chip8TranslationCache)];
+        size_t length = fread(contents, 1, sizeof(contents), file);
+        fclose(file);
+
+        file = fopen(path, "wb");
+        fwrite(contents, 1, length, file);
+        fclose(file);
+
+        CHECK(!loadChip8TranslationCache(&loaded, &pristine, CACHE_DIRECTORY));
+    }
+
+    remove(path);
+
+    printf("transcache: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
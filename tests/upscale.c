@@ -0,0 +1,217 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "chip8.h"
+#include "upscale.h"
+
+/*
+    checks where the upscaler puts the display in buffers of different sizes, what each filter and the phosphor blend
+    do to a few pixels, and that every kernel the processor supports draws exactly what the scalar one does
+*/
+
+#define BACKGROUND 0xFF000000u
+#define LIT        0xFFFFFFFFu
+
+const Byte black[3] = { 0, 0, 0 };
+const Byte white[3] = { 255, 255, 255 };
+
+bool pixels[64 * 32];
+chip8Upscaler upscaler;
+
+// large enough for a buffer that is copied with streaming stores (see STREAMING_THRESHOLD in upscale.c)
+#define MAX_BUFFER_SIZE (2051 * 2048)
+unsigned int buffer[MAX_BUFFER_SIZE];
+unsigned int expected[MAX_BUFFER_SIZE];
+
+unsigned int randomState = 12345;
+
+// a frame of random pixels (with about a third of them lit)
+void randomFrame()
+{
+    for (int i = 0; i < 64 * 32; i++)
+    {
+        randomState = randomState * 1103515245 + 12345;
+        pixels[i] = (randomState >> 16) % 3 == 0;
+    }
+}
+
+void testPlacement()
+{
+    memset(pixels, 0, sizeof(pixels));
+    pixels[3 + 2 * 64] = true;
+
+    initChip8Upscaler(&upscaler, UPSCALE_NEAREST, black, white);
+
+    // fills the buffer exactly, 10 times larger
+    upscaleChip8Frame(&upscaler, pixels, buffer, 640, 320, 640);
+    CHECK(buffer[25 * 640 + 35] == LIT && buffer[29 * 640 + 39] == LIT);
+    CHECK(buffer[25 * 640 + 40] == BACKGROUND && buffer[19 * 640 + 35] == BACKGROUND);
+
+    // centred, with the factor limited by the width, and rows further apart than the width
+    upscaleChip8Frame(&upscaler, pixels, buffer, 700, 400, 720);
+    CHECK(buffer[(40 + 25) * 720 + 30 + 35] == LIT);
+    CHECK(buffer[(40 + 19) * 720 + 30 + 35] == BACKGROUND);
+    CHECK(buffer[39 * 720 + 300] == BACKGROUND && buffer[360 * 720 + 300] == BACKGROUND);
+
+    // too small for the display at all
+    for (int i = 0; i < 50 * 20; i++)
+        buffer[i] = 0x12345678;
+
+    upscaleChip8Frame(&upscaler, pixels, buffer, 50, 20, 50);
+
+    bool allBackground = true;
+    for (int i = 0; i < 50 * 20; i++)
+        allBackground = allBackground && buffer[i] == BACKGROUND;
+
+    CHECK(allBackground);
+}
+
+void testPalette()
+{
+    const Byte background[3] = { 10, 20, 30 };
+    const Byte pixel[3] = { 210, 120, 30 };
+
+    initChip8Upscaler(&upscaler, UPSCALE_NEAREST, background, pixel);
+    CHECK(upscaler.palette[0] == 0xFF0A141E);
+    CHECK(upscaler.palette[255] == 0xFFD2781E);
+    CHECK(upscaler.palette[51] == 0xFF32281E);
+}
+
+void testFilters()
+{
+    // a diagonal line of two pixels
+    memset(pixels, 0, sizeof(pixels));
+    pixels[10 + 10 * 64] = true;
+    pixels[11 + 11 * 64] = true;
+
+    initChip8Upscaler(&upscaler, UPSCALE_SCALE2X, black, white);
+    upscaleChip8Frame(&upscaler, pixels, buffer, 128, 64, 128);
+    CHECK(upscaler.filteredWidth == 128 && upscaler.filteredHeight == 64);
+
+    // Scale2x fills in the corners between the two
+    CHECK(upscaler.filtered[21 * 128 + 22] == 255 && upscaler.filtered[22 * 128 + 21] == 255);
+    CHECK(upscaler.filtered[20 * 128 + 23] == 0 && upscaler.filtered[23 * 128 + 20] == 0);
+    CHECK(upscaler.filtered[20 * 128 + 20] == 255 && upscaler.filtered[23 * 128 + 23] == 255);
+
+    // hq2x blends a lone pixel's quarters with the unlit pixels around it
+    memset(pixels, 0, sizeof(pixels));
+    pixels[30 + 20 * 64] = true;
+
+    initChip8Upscaler(&upscaler, UPSCALE_HQ2X, black, white);
+    upscaleChip8Frame(&upscaler, pixels, buffer, 128, 64, 128);
+    CHECK(upscaler.filtered[40 * 128 + 60] == 127 && upscaler.filtered[41 * 128 + 61] == 127);
+    CHECK(upscaler.filtered[40 * 128 + 59] == 0);
+
+    // and leaves the inside of a block alone
+    for (int y = 4; y < 8; y++)
+        for (int x = 4; x < 8; x++)
+            pixels[x + y * 64] = true;
+
+    upscaleChip8Frame(&upscaler, pixels, buffer, 128, 64, 128);
+    CHECK(upscaler.filtered[11 * 128 + 11] == 255 && upscaler.filtered[12 * 128 + 12] == 255);
+    CHECK(upscaler.filtered[8 * 128 + 8] < 255);
+}
+
+void testPhosphor()
+{
+    memset(pixels, 0, sizeof(pixels));
+    pixels[0] = true;
+
+    initChip8Upscaler(&upscaler, UPSCALE_NEAREST, black, white);
+    upscaleChip8Frame(&upscaler, pixels, buffer, 64, 32, 64);
+
+    // without the blend a pixel goes straight out
+    pixels[0] = false;
+    upscaleChip8Frame(&upscaler, pixels, buffer, 64, 32, 64);
+    CHECK(upscaler.intensities[0] == 0);
+
+    pixels[0] = true;
+    upscaler.phosphorDecay = 128;
+    upscaleChip8Frame(&upscaler, pixels, buffer, 64, 32, 64);
+
+    // with it, it fades
+    pixels[0] = false;
+    upscaleChip8Frame(&upscaler, pixels, buffer, 64, 32, 64);
+    CHECK(upscaler.intensities[0] == 127 && buffer[0] == upscaler.palette[127]);
+
+    upscaleChip8Frame(&upscaler, pixels, buffer, 64, 32, 64);
+    CHECK(upscaler.intensities[0] == 63);
+
+    // and lights up fully again straight away
+    pixels[0] = true;
+    upscaleChip8Frame(&upscaler, pixels, buffer, 64, 32, 64);
+    CHECK(upscaler.intensities[0] == 255);
+}
+
+void testKernelsAgree()
+{
+    const int sizes[][3] =
+    {
+        { 64, 32, 64 },
+        { 333, 177, 340 },
+        { 800, 600, 800 },
+        { 131, 67, 131 },
+        { 2049, 2048, 2051 },
+    };
+
+    for (int filter = UPSCALE_NEAREST; filter <= UPSCALE_HQ2X; filter++)
+    {
+        for (int kernel = UPSCALE_KERNEL_SSE2; kernel <= UPSCALE_KERNEL_AVX2; kernel++)
+        {
+            if (!chip8UpscaleKernelSupported((chip8UpscaleKernel)kernel))
+            {
+                printf("skipping the %s kernel, which this processor doesn't support\n", describeChip8UpscaleKernel((chip8UpscaleKernel)kernel));
+                continue;
+            }
+
+            for (int size = 0; size < (int)(sizeof(sizes) / sizeof(sizes[0])); size++)
+            {
+                int width = sizes[size][0], height = sizes[size][1], pitch = sizes[size][2];
+
+                chip8Upscaler scalar;
+                initChip8Upscaler(&scalar, (chip8UpscaleFilter)filter, black, white);
+                scalar.kernel = UPSCALE_KERNEL_SCALAR;
+                scalar.phosphorDecay = DEFAULT_PHOSPHOR_DECAY;
+
+                initChip8Upscaler(&upscaler, (chip8UpscaleFilter)filter, black, white);
+                upscaler.kernel = (chip8UpscaleKernel)kernel;
+                upscaler.phosphorDecay = DEFAULT_PHOSPHOR_DECAY;
+
+                // a few frames in a row, so that the phosphor's fades come into it
+                for (int frame = 0; frame < 4; frame++)
+                {
+                    randomFrame();
+
+                    memset(expected, 0, pitch * height * sizeof(unsigned int));
+                    memset(buffer, 0, pitch * height * sizeof(unsigned int));
+
+                    upscaleChip8Frame(&scalar, pixels, expected, width, height, pitch);
+                    upscaleChip8Frame(&upscaler, pixels, buffer, width, height, pitch);
+
+                    CHECK(memcmp(upscaler.intensities, scalar.intensities, sizeof(scalar.intensities)) == 0);
+                    CHECK(memcmp(upscaler.filtered, scalar.filtered, sizeof(scalar.filtered)) == 0);
+                    CHECK(memcmp(buffer, expected, pitch * height * sizeof(unsigned int)) == 0);
+                }
+            }
+        }
+    }
+}
+
+int main()
+{
+    chip8UpscaleFilter filter;
+    CHECK(findChip8UpscaleFilter("scale2x", &filter) && filter == UPSCALE_SCALE2X);
+    CHECK(!findChip8UpscaleFilter("bilinear", &filter));
+
+    testPlacement();
+    testPalette();
+    testFilters();
+    testPhosphor();
+    testKernelsAgree();
+
+    printf("upscale: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "check.h"
+#include "chip8.h"
+#include "vecenv.h"
+
+/*
+    drives a vectorized environment from both sides in one process: the learner queues commands through its
+    own mapping of the shared memory, and the server is polled to execute them
+*/
+
+#define TEST_NAME "chip8-vecenv-test"
+#define NUM_OF_ENVS 4
+
+// waits for a key, then draws its glyph at (5, 5) and loops forever
+const DoubleByte program[] = { 0xF00A, 0xF029, 0x6105, 0xD115, 0x1208 };
+
+chip8VecEnvServer server;
+chip8VecEnvClient client;
+
+bool frameIsBlank(const chip8Observation* observation)
+{
+    for (int b = 0; b < (int)sizeof(observation->frame); b++)
+    {
+        if (observation->frame[b] != 0)
+            return false;
+    }
+
+    return true;
+}
+
+// queues a command and has the server execute it, returning whether the learner saw it complete
+bool run(chip8VecEnvCommand command)
+{
+    unsigned long long ticket;
+    if (!submitChip8VecEnv(&client, command, &ticket))
+        return false;
+
+    serveChip8VecEnvCommands(&server);
+    return waitForChip8VecEnv(&client, ticket);
+}
+
+int main()
+{
+    chip8 snapshot;
+    initChip8(&snapshot);
+
+    for (int i = 0; i < (int)(sizeof(program) / sizeof(program[0])); i++)
+    {
+        snapshot.memory[0x200 + i * 2]     = program[i] >> 8;
+        snapshot.memory[0x200 + i * 2 + 1] = program[i] & 0xFF;
+    }
+
+    CHECK(createChip8VecEnv(&server, TEST_NAME, &snapshot, NUM_OF_ENVS, 3, 8, true));
+    CHECK(connectChip8VecEnv(&client, TEST_NAME));
+
+    if (failures > 0)
+    {
+        printf("vecenv: FAILED (is shared memory available?)\n");
+        return 1;
+    }
+
+    CHECK(client.header->numOfEnvs == NUM_OF_ENVS);
+    CHECK(client.observations[0].programCounter == 0x200 && frameIsBlank(&client.observations[0]));
+
+    // with no keys held, every instance keeps waiting
+    memset(client.actions, 0, NUM_OF_ENVS * sizeof(uint16_t));
+    chip8VecEnvCommand step = { CHIP8_VECENV_STEP, 0, NUM_OF_ENVS, 0 };
+    CHECK(run(step));
+    CHECK(client.observations[0].programCounter == 0x200 && client.observations[0].frames == 3);
+
+    // holding key 3 on the second instance only makes it draw the 3 (its top row is 4 lit pixels from (5, 5))
+    client.actions[1] = 1 << 3;
+    CHECK(run(step));
+    CHECK(client.observations[1].registers[0] == 3);
+    CHECK(client.observations[1].frame[(5 * 64 + 5) / 8] == 0x07 && client.observations[1].frame[(5 * 64 + 5) / 8 + 1] == 0x80);
+    CHECK(frameIsBlank(&client.observations[0]) && frameIsBlank(&client.observations[2]));
+    CHECK(client.observations[1].frames == 6);
+
+    // a batch can cover just part of the instances
+    chip8VecEnvCommand stepLast = { CHIP8_VECENV_STEP, 3, 1, 0 };
+    CHECK(run(stepLast));
+    CHECK(client.observations[3].frames == 9 && client.observations[2].frames == 6);
+
+    // several commands can be queued before waiting on the last one
+    unsigned long long ticket = 0;
+    for (int i = 0; i < 10; i++)
+        CHECK(submitChip8VecEnv(&client, step, &ticket));
+
+    serveChip8VecEnvCommands(&server);
+    CHECK(waitForChip8VecEnv(&client, ticket));
+    CHECK(client.observations[0].frames == 36);
+
+    // resetting restores the snapshot
+    chip8VecEnvCommand reset = { CHIP8_VECENV_RESET, 1, 1, 0 };
+    CHECK(run(reset));
+    CHECK(client.observations[1].frames == 0 && client.observations[1].programCounter == 0x200);
+    CHECK(frameIsBlank(&client.observations[1]));
+
+    chip8VecEnvCommand shutdown = { CHIP8_VECENV_SHUTDOWN, 0, 0, 0 };
+    CHECK(run(shutdown));
+    CHECK(!atomic_load(&client.header->serverRunning));
+
+    // with the server gone, a learner that fills the ring fails rather than waiting for a free slot forever
+    bool submitted = true;
+    for (int i = 0; i <= CHIP8_VECENV_RING_SIZE && submitted; i++)
+        submitted = submitChip8VecEnv(&client, step, &ticket);
+
+    CHECK(!submitted);
+    CHECK(!stepChip8VecEnv(&client, 0, NUM_OF_ENVS) && !resetChip8VecEnv(&client, 0, NUM_OF_ENVS, 0));
+
+    disconnectChip8VecEnv(&client);
+    destroyChip8VecEnv(&server);
+
+    // the name is gone with the server
+    CHECK(!connectChip8VecEnv(&client, TEST_NAME));
+
+    printf("vecenv: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
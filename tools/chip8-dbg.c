@@ -0,0 +1,391 @@
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "analysis.h"
+#include "chip8.h"
+#include "debugger.h"
+#include "platform.h"
+
+/*
+    a headless command line debugger for chip8 ROMs. commands are read from the console, or from a single
+    client connected to a loopback port when started with --port=<port> (e.g. with "nc 127.0.0.1 <port>")
+*/
+
+// how many instructions are executed between updates of the 60Hz timers (500Hz / 60Hz, rounded)
+#define CYCLES_PER_TIMER_UPDATE 8
+
+// how many instructions are executed between checks for input that interrupts a run
+#define CYCLES_PER_INPUT_POLL 4096
+
+// the connection commands are read from, or INVALID_PLATFORM_SOCKET for the console
+PlatformSocket connection = INVALID_PLATFORM_SOCKET;
+
+// the number of cycles executed since the timers were last updated
+int cyclesSinceTimerUpdate = 0;
+
+// whether the last run was stopped by input from the user rather than by the debugger
+bool interrupted = false;
+
+// the static analysis of the ROM as it was loaded, which tells the listing which bytes are code
+chip8Analysis analysis;
+
+// prints to the console or the connected client
+void sessionPrintf(const char* format, ...)
+{
+    char buffer[4096];
+
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    if (length >= (int)sizeof(buffer))
+        length = sizeof(buffer) - 1;
+
+    if (connection == INVALID_PLATFORM_SOCKET)
+    {
+        fputs(buffer, stdout);
+        fflush(stdout);
+    }
+    else
+    {
+        sendToConnection(connection, buffer, length);
+    }
+}
+
+// reads a line from the console or the connected client, returning false once input has ended
+bool sessionReadLine(char* line, int lineSize)
+{
+    if (connection == INVALID_PLATFORM_SOCKET)
+        return fgets(line, lineSize, stdin) != NULL;
+
+    int length = 0;
+    while (length < lineSize - 1)
+    {
+        if (receiveFromConnection(connection, &line[length], 1) <= 0)
+            return false;
+
+        if (line[length++] == '\n')
+            break;
+    }
+
+    line[length] = '\0';
+    return true;
+}
+
+// whether the user has sent anything since the run started, which is read and thrown away
+bool sessionInterrupted()
+{
+    bool waiting = connection == INVALID_PLATFORM_SOCKET ? consoleInputWaiting() : waitForConnectionData(connection, 0);
+    if (!waiting)
+        return false;
+
+    // a client that has gone also counts, and is noticed again when the next command is read
+    char line[256];
+    sessionReadLine(line, sizeof(line));
+    return true;
+}
+
+/*
+    runs up to maxCycles instructions (keeping the timers ticking along), stopping early if the debugger stops. every
+    CYCLES_PER_INPUT_POLL instructions it checks for input, so that a run that would never stop on its own (a ROM
+    looping with no breakpoint in the way, or a subroutine that never returns) can be broken into
+*/
+debuggerStopReason runCycles(chip8Debugger* debugger, chip8* chip8ptr, unsigned long long maxCycles)
+{
+    unsigned long long cyclesSincePoll = 0;
+    interrupted = false;
+
+    while (maxCycles > 0)
+    {
+        // run until the next timer update at most
+        unsigned long long cycles = CYCLES_PER_TIMER_UPDATE - cyclesSinceTimerUpdate;
+        if (cycles > maxCycles)
+            cycles = maxCycles;
+
+        debuggerStopReason reason = runChip8Debugged(debugger, chip8ptr, cycles);
+
+        maxCycles -= debugger->executedCycles;
+        cyclesSinceTimerUpdate += (int)debugger->executedCycles;
+
+        if (cyclesSinceTimerUpdate >= CYCLES_PER_TIMER_UPDATE)
+        {
+            updateChip8Timers(chip8ptr);
+            cyclesSinceTimerUpdate = 0;
+        }
+
+        if (reason != DEBUGGER_STOP_CYCLES)
+            return reason;
+
+        cyclesSincePoll += debugger->executedCycles;
+        if (cyclesSincePoll >= CYCLES_PER_INPUT_POLL)
+        {
+            cyclesSincePoll = 0;
+
+            if (sessionInterrupted())
+            {
+                interrupted = true;
+                break;
+            }
+        }
+    }
+
+    return DEBUGGER_STOP_CYCLES;
+}
+
+void reportStop(const chip8Debugger* debugger, const chip8* chip8ptr)
+{
+    DoubleByte pc = chip8ptr->programCounter & 0xFFF;
+    DoubleByte opcode = (chip8ptr->memory[pc] << 8) | chip8ptr->memory[(pc + 1) & 0xFFF];
+
+    switch (debugger->stopReason)
+    {
+        case DEBUGGER_STOP_BREAKPOINT:
+            sessionPrintf("breakpoint at %.3X\n", pc);
+            break;
+
+        case DEBUGGER_STOP_WATCHPOINT:
+            sessionPrintf("watchpoint: %s of %.3X\n", debugger->watchAccess == WATCH_WRITE ? "write" : "read", debugger->watchAddress);
+            break;
+
+        case DEBUGGER_STOP_RETURN:
+            sessionPrintf("returned\n");
+            break;
+
+        case DEBUGGER_STOP_TRAP:
+            sessionPrintf("trapped: %s\n", describeChip8Status(chip8ptr->trap));
+            break;
+
+        case DEBUGGER_STOP_CYCLES:
+            if (interrupted)
+                sessionPrintf("interrupted\n");
+            break;
+    }
+
+    char instruction[32];
+    formatChip8Instruction(opcode, instruction, sizeof(instruction));
+    sessionPrintf("%.3X: %.4X  %s\n", pc, opcode, instruction);
+}
+
+// lists the instructions from address on, as they are in memory now (data the analysis didn't reach is marked)
+void listInstructions(const chip8* chip8ptr, DoubleByte address, unsigned int count)
+{
+    for (unsigned int instruction = 0; instruction < count; instruction++)
+    {
+        address &= 0xFFF;
+        DoubleByte opcode = (chip8ptr->memory[address] << 8) | chip8ptr->memory[(address + 1) & 0xFFF];
+
+        char text[32];
+        formatChip8Instruction(opcode, text, sizeof(text));
+
+        bool code = (analysis.flags[address] & ANALYSIS_INSTRUCTION) != 0;
+        sessionPrintf("%c%.3X: %.4X  %s%s\n", address == (chip8ptr->programCounter & 0xFFF) ? '>' : ' ',
+            address, opcode, text, code ? "" : "  ; not reached by the analysis");
+
+        address += 2;
+    }
+}
+
+void printHelp()
+{
+    sessionPrintf(
+        "b <addr>              set a breakpoint\n"
+        "d <addr>              delete a breakpoint\n"
+        "w <addr> [len] [rw]   watch memory for reads (r), writes (w) or both (default)\n"
+        "u <addr> [len]        stop watching memory\n"
+        "s [n]                 single step (n instructions)\n"
+        "c [n]                 continue (for at most n instructions)\n"
+        "f                     run until the current subroutine returns\n"
+        "                      (while running, enter any line to break in)\n"
+        "r                     show the registers and stack\n"
+        "m <addr> [len]        show memory\n"
+        "l [addr] [n]          list instructions (from the program counter by default)\n"
+        "q                     quit\n");
+}
+
+int main(int argc, char** argv)
+{
+    const char* romFile = NULL;
+    int port = 0;
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if (strncmp(argv[arg], "--port=", 7) == 0)
+            port = atoi(argv[arg] + 7);
+        else
+            romFile = argv[arg];
+    }
+
+    if (romFile == NULL)
+    {
+        printf("Usage is: chip8-dbg <ROM file> [--port=<port>]\n");
+        return 1;
+    }
+
+    chip8 chip8Emulator;
+    initChip8(&chip8Emulator);
+
+    if (!loadChip8(romFile, &chip8Emulator))
+        return 1;
+
+    if (port > 0 && port < 65536)
+    {
+        PlatformSocket listener = openLoopbackListener((unsigned short)port, true);
+        if (listener == INVALID_PLATFORM_SOCKET)
+        {
+            printf("Failed to listen on 127.0.0.1:%d\n", port);
+            return 1;
+        }
+
+        printf("Waiting for a debugger connection on 127.0.0.1:%d...\n", port);
+        connection = acceptConnection(listener);
+        closeConnection(listener);
+
+        if (connection == INVALID_PLATFORM_SOCKET)
+            return 1;
+    }
+
+    analyseChip8(&analysis, chip8Emulator.memory, 0x200);
+
+    chip8Debugger debugger;
+    initChip8Debugger(&debugger);
+
+    printHelp();
+    reportStop(&debugger, &chip8Emulator);
+
+    char line[256];
+    while (sessionPrintf("(chip8) "), sessionReadLine(line, sizeof(line)))
+    {
+        char command = '\0';
+        char accessText[4] = "rw";
+        unsigned int address = 0, length = 0;
+        unsigned long long count = 0;
+
+        if (sscanf(line, " %c", &command) != 1)
+            continue;
+
+        switch (command)
+        {
+            case 'b':
+            case 'd':
+            {
+                if (sscanf(line, " %*c %x", &address) != 1)
+                {
+                    sessionPrintf("expected an address\n");
+                    break;
+                }
+
+                setBreakpoint(&debugger, (DoubleByte)address, command == 'b');
+                break;
+            }
+
+            case 'w':
+            case 'u':
+            {
+                int fields = sscanf(line, " %*c %x %x %3s", &address, &length, accessText);
+                if (fields < 1)
+                {
+                    sessionPrintf("expected an address\n");
+                    break;
+                }
+
+                if (fields < 2 || length == 0)
+                    length = 1;
+
+                Byte access = 0;
+                if (command == 'w')
+                {
+                    if (strchr(accessText, 'r'))
+                        access |= WATCH_READ;
+                    if (strchr(accessText, 'w'))
+                        access |= WATCH_WRITE;
+                }
+
+                setWatchpoint(&debugger, (DoubleByte)address, (DoubleByte)length, access);
+                break;
+            }
+
+            case 's':
+            case 'c':
+            {
+                if (sscanf(line, " %*c %llu", &count) != 1 || count == 0)
+                    count = command == 's' ? 1 : ~0ULL;
+
+                runCycles(&debugger, &chip8Emulator, count);
+                reportStop(&debugger, &chip8Emulator);
+                break;
+            }
+
+            case 'f':
+            {
+                if (!runToReturn(&debugger, &chip8Emulator))
+                {
+                    sessionPrintf("not inside a subroutine\n");
+                    break;
+                }
+
+                runCycles(&debugger, &chip8Emulator, ~0ULL);
+
+                // breaking in gives up on the return, so that it doesn't stop a later continue
+                if (interrupted)
+                    debugger.runningToReturn = false;
+
+                reportStop(&debugger, &chip8Emulator);
+                break;
+            }
+
+            case 'r':
+            {
+                char buffer[512];
+                formatChip8Registers(&chip8Emulator, buffer, sizeof(buffer));
+                sessionPrintf("%s", buffer);
+                break;
+            }
+
+            case 'm':
+            {
+                if (sscanf(line, " %*c %x %x", &address, &length) < 1)
+                    address = chip8Emulator.indexRegister;
+
+                if (length == 0 || length > 256)
+                    length = 64;
+
+                char buffer[2048];
+                formatChip8Memory(&chip8Emulator, (DoubleByte)address, (DoubleByte)length, buffer, sizeof(buffer));
+                sessionPrintf("%s", buffer);
+                break;
+            }
+
+            case 'l':
+            {
+                int fields = sscanf(line, " %*c %x %x", &address, &length);
+                if (fields < 1)
+                    address = chip8Emulator.programCounter;
+
+                if (fields < 2 || length == 0 || length > 256)
+                    length = 16;
+
+                listInstructions(&chip8Emulator, (DoubleByte)address, length);
+                break;
+            }
+
+            case 'q':
+            {
+                closeConnection(connection);
+                return 0;
+            }
+
+            default:
+            {
+                printHelp();
+                break;
+            }
+        }
+    }
+
+    closeConnection(connection);
+    return 0;
+}
@@ -0,0 +1,245 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "analysis.h"
+#include "chip8.h"
+#include "rompack.h"
+
+/*
+    disassembles the code reachable from 0x200 in a ROM (see analysis.h), e.g.
+
+        chip8-dis game.ch8                 an annotated listing
+        chip8-dis game.ch8 --format=json   the code/data maps, basic blocks and findings, for other tools
+
+    exits with 2 when the ROM contains unknown opcodes or modifies its own code, so that such ROMs can be flagged
+    before they are run
+*/
+
+chip8 chip8Emulator;
+chip8Analysis analysis;
+
+// the number of plain data bytes listed on a line
+#define DATA_BYTES_PER_LINE 8
+
+void printUsage()
+{
+    printf("Usage is: chip8-dis <ROM file> [--format=listing|json]\n");
+}
+
+// reads the ROM into the instance's memory, returning its length (or -1 if it can't be read or doesn't fit)
+long readROM(const char* romFile)
+{
+    FILE* file = fopen(romFile, "rb");
+    if (file == NULL)
+    {
+        printf("Failed to open %s\n", romFile);
+        return -1;
+    }
+
+    long romSize = (long)fread(&chip8Emulator.memory[0x200], 1, MAX_ROM_SIZE, file);
+    bool tooBig  = fgetc(file) != EOF;
+    fclose(file);
+
+    if (tooBig)
+    {
+        printf("%s is too big to fit into chip8's memory\n", romFile);
+        return -1;
+    }
+
+    return romSize;
+}
+
+int countFindings(chip8FindingKind kind)
+{
+    int count = 0;
+    for (int finding = 0; finding < analysis.numOfFindings; finding++)
+        count += analysis.findings[finding].kind == kind;
+
+    return count;
+}
+
+// prints the findings for the instruction at address after it, lined up past the longest instruction
+void printAnnotations(DoubleByte address, int instructionLength)
+{
+    for (int index = 0; index < analysis.numOfFindings; index++)
+    {
+        const chip8Finding* finding = &analysis.findings[index];
+        if (finding->address != address)
+            continue;
+
+        printf("%*s", instructionLength < 16 ? 16 - instructionLength : 0, "");
+        instructionLength = 16;
+
+        if (finding->kind == FINDING_SELF_MODIFYING)
+            printf("  ; writes code at %.3X", finding->target);
+        else
+            printf("  ; %s", describeChip8Finding(finding->kind));
+    }
+}
+
+void printListing(const char* romFile, long romSize)
+{
+    printf("; %s: %ld bytes, %d instructions in %d basic blocks\n", romFile, romSize, analysis.numOfInstructions, analysis.numOfBlocks);
+    printf("; %d unresolved jumps, %d unknown opcodes, %d self modifying instructions%s\n",
+        countFindings(FINDING_UNRESOLVED_JUMP), countFindings(FINDING_UNKNOWN_OPCODE), countFindings(FINDING_SELF_MODIFYING),
+        analysis.findingsTruncated ? " (and more that weren't recorded)" : "");
+
+    // the ROM is listed, along with any code reached outside of it
+    int address = 0;
+    while (address < 4096)
+    {
+        Byte flags = analysis.flags[address];
+        bool inROM = address >= 0x200 && address < 0x200 + romSize;
+
+        if ((flags & ANALYSIS_INSTRUCTION) != 0)
+        {
+            char instruction[32];
+            DoubleByte opcode = (chip8Emulator.memory[address] << 8) | chip8Emulator.memory[(address + 1) & 0xFFF];
+            int instructionLength = formatChip8Instruction(opcode, instruction, sizeof(instruction));
+
+            if ((flags & ANALYSIS_BLOCK_START) != 0)
+                printf("\n; block %.3X-%.3X\n", address, findChip8BlockEnd(&analysis, chip8Emulator.memory, (DoubleByte)address));
+
+            printf("%.3X  %.4X  %s", address, opcode, instruction);
+            printAnnotations((DoubleByte)address, instructionLength);
+            printf("\n");
+
+            // an instruction that starts in the middle of this one (jumped to at an odd address) is listed too
+            address += (analysis.flags[(address + 1) & 0xFFF] & ANALYSIS_INSTRUCTION) != 0 ? 1 : 2;
+        }
+        else if (inROM && (flags & ANALYSIS_SPRITE) != 0)
+        {
+            // sprites are drawn as they appear on screen
+            char picture[9];
+            for (int bit = 0; bit < 8; bit++)
+                picture[bit] = (chip8Emulator.memory[address] & (0x80 >> bit)) != 0 ? '#' : '.';
+            picture[8] = '\0';
+
+            char data[32];
+            snprintf(data, sizeof(data), "DB   %.2X", chip8Emulator.memory[address]);
+
+            printf("%.3X  %.2X    %-16s  ; sprite %s\n", address, chip8Emulator.memory[address], data, picture);
+            address++;
+        }
+        else if (inROM)
+        {
+            printf("%.3X        DB  ", address);
+
+            int length = 0;
+            while (length < DATA_BYTES_PER_LINE && address + length < 0x200 + romSize &&
+                   (analysis.flags[address + length] & (ANALYSIS_INSTRUCTION | ANALYSIS_SPRITE)) == 0)
+            {
+                printf(" %.2X", chip8Emulator.memory[address + length]);
+                length++;
+            }
+
+            printf("\n");
+            address += length;
+        }
+        else
+        {
+            address++;
+        }
+    }
+}
+
+// prints the addresses with the given flag as a bitmap of 512 bytes in hex (address 0 in the most significant bit)
+void printBitmap(const char* name, Byte flag)
+{
+    printf("  \"%s\": \"", name);
+
+    for (int address = 0; address < 4096; address += 8)
+    {
+        Byte bits = 0;
+        for (int bit = 0; bit < 8; bit++)
+            bits |= (analysis.flags[address + bit] & flag) != 0 ? 0x80 >> bit : 0;
+
+        printf("%.2x", bits);
+    }
+
+    printf("\",\n");
+}
+
+void printJSON(long romSize)
+{
+    printf("{\n");
+    printf("  \"size\": %ld,\n", romSize);
+    printf("  \"entry\": %d,\n", 0x200);
+    printf("  \"instructions\": %d,\n", analysis.numOfInstructions);
+
+    printBitmap("code", ANALYSIS_CODE);
+    printBitmap("instructionStarts", ANALYSIS_INSTRUCTION);
+    printBitmap("sprites", ANALYSIS_SPRITE);
+    printBitmap("written", ANALYSIS_WRITTEN);
+
+    // each block is its first address and the address just past it
+    printf("  \"blocks\": [");
+
+    int numOfPrinted = 0;
+    for (int address = 0; address < 4096; address++)
+    {
+        if ((analysis.flags[address] & (ANALYSIS_INSTRUCTION | ANALYSIS_BLOCK_START)) != (ANALYSIS_INSTRUCTION | ANALYSIS_BLOCK_START))
+            continue;
+
+        printf("%s[%d, %d]", numOfPrinted++ == 0 ? "" : ", ", address, findChip8BlockEnd(&analysis, chip8Emulator.memory, (DoubleByte)address));
+    }
+
+    printf("],\n");
+    printf("  \"findings\": [");
+
+    for (int index = 0; index < analysis.numOfFindings; index++)
+    {
+        const chip8Finding* finding = &analysis.findings[index];
+        printf("%s\n    {\"kind\": \"%s\", \"address\": %d, \"opcode\": %d, \"target\": %d}", index == 0 ? "" : ",",
+            describeChip8Finding(finding->kind), finding->address, finding->opcode, finding->target);
+    }
+
+    printf("%s],\n", analysis.numOfFindings == 0 ? "" : "\n  ");
+    printf("  \"findingsTruncated\": %s\n", analysis.findingsTruncated ? "true" : "false");
+    printf("}\n");
+}
+
+int main(int argc, char** argv)
+{
+    const char* romFile = NULL;
+    bool json = false;
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if (strcmp(argv[arg], "--format=listing") == 0)
+            json = false;
+        else if (strcmp(argv[arg], "--format=json") == 0)
+            json = true;
+        else if (strncmp(argv[arg], "--", 2) == 0 || romFile != NULL)
+        {
+            printUsage();
+            return 1;
+        }
+        else
+            romFile = argv[arg];
+    }
+
+    if (romFile == NULL)
+    {
+        printUsage();
+        return 1;
+    }
+
+    initChip8(&chip8Emulator);
+
+    long romSize = readROM(romFile);
+    if (romSize < 0)
+        return 1;
+
+    analyseChip8(&analysis, chip8Emulator.memory, 0x200);
+
+    if (json)
+        printJSON(romSize);
+    else
+        printListing(romFile, romSize);
+
+    bool flagged = countFindings(FINDING_UNKNOWN_OPCODE) > 0 || countFindings(FINDING_SELF_MODIFYING) > 0;
+    return flagged ? 2 : 0;
+}
@@ -0,0 +1,209 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <fcntl.h>
+    #include <io.h>
+    #define dup  _dup
+    #define dup2 _dup2
+#else
+    #include <unistd.h>
+#endif
+
+#include "chip8.h"
+#include "colours.h"
+#include "framedump.h"
+#include "framelog.h"
+#include "fused.h"
+
+/*
+    runs a ROM without a window and writes every 60Hz frame of its display to a file or pipe, e.g.
+
+        chip8-dump game.ch8 - --frames=3600 --scale=8 | ffmpeg -i - gameplay.mp4
+        chip8-dump game.ch8 golden.raw --format=raw --bits=1 --frames=120
+
+    with --log the frames are also recorded to a frame log (see framelog.h), in which case the output file is optional.
+    with --cache-dir, what the engine decodes is kept in a translation cache (see fused.h) for the next run of the ROM
+*/
+
+// the number of instructions emulated per 60Hz frame (500Hz / 60Hz, rounded)
+#define DEFAULT_CYCLES_PER_FRAME 8
+#define DEFAULT_FRAMES           600
+
+chip8 chip8Emulator;
+chip8 pristine;
+chip8FusedEngine fusedEngine;
+chip8TranslationCache translationCache;
+bool cacheLoaded = false;
+chip8FrameLogWriter frameLog;
+
+void printUsage()
+{
+    printf("Usage is: chip8-dump <ROM file> <output file, or - for stdout> [--format=y4m|raw] [--bits=8|1] [--scale=<n>]\n");
+    printf("                     [--scheme=<colour scheme>] [--frames=<n>] [--cycles-per-frame=<n>]\n");
+    printf("                     [--log=<frame log> [--keyframe-interval=<n>]] [--cache-dir=<directory>]\n");
+}
+
+int main(int argc, char** argv)
+{
+    const char* romFile    = NULL;
+    const char* outputFile = NULL;
+    frameFormat format     = FRAME_FORMAT_Y4M;
+    const char* scheme     = "default";
+    int bitsPerPixel       = 8;
+    int scale              = 1;
+    long frames            = DEFAULT_FRAMES;
+    long cyclesPerFrame    = DEFAULT_CYCLES_PER_FRAME;
+    const char* logFile    = NULL;
+    long keyframeInterval  = DEFAULT_KEYFRAME_INTERVAL;
+    const char* cacheDir   = NULL;
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if (strcmp(argv[arg], "--format=y4m") == 0)
+            format = FRAME_FORMAT_Y4M;
+        else if (strcmp(argv[arg], "--format=raw") == 0)
+            format = FRAME_FORMAT_RAW;
+        else if (strncmp(argv[arg], "--bits=", 7) == 0)
+            bitsPerPixel = atoi(argv[arg] + 7);
+        else if (strncmp(argv[arg], "--scale=", 8) == 0)
+            scale = atoi(argv[arg] + 8);
+        else if (strncmp(argv[arg], "--scheme=", 9) == 0)
+            scheme = argv[arg] + 9;
+        else if (strncmp(argv[arg], "--frames=", 9) == 0)
+            frames = atol(argv[arg] + 9);
+        else if (strncmp(argv[arg], "--cycles-per-frame=", 19) == 0)
+            cyclesPerFrame = atol(argv[arg] + 19);
+        else if (strncmp(argv[arg], "--log=", 6) == 0)
+            logFile = argv[arg] + 6;
+        else if (strncmp(argv[arg], "--keyframe-interval=", 20) == 0)
+            keyframeInterval = atol(argv[arg] + 20);
+        else if (strncmp(argv[arg], "--cache-dir=", 12) == 0)
+            cacheDir = argv[arg] + 12;
+        else if (strncmp(argv[arg], "--", 2) == 0 && argv[arg][2] != '\0')
+        {
+            printf("Unknown option %s\n", argv[arg]);
+            printUsage();
+            return 1;
+        }
+        else if (romFile == NULL)
+            romFile = argv[arg];
+        else
+            outputFile = argv[arg];
+    }
+
+    if (romFile == NULL || (outputFile == NULL && logFile == NULL) || frames < 0 || cyclesPerFrame < 1 || keyframeInterval < 1)
+    {
+        printUsage();
+        return 1;
+    }
+
+    int outputDescriptor = -1;
+    FILE* output = NULL;
+
+    if (outputFile == NULL)
+    {
+        // only the frame log is being written
+    }
+    else if (strcmp(outputFile, "-") == 0)
+    {
+        // the frames get stdout to themselves, and everything that would have been printed goes to stderr instead
+        fflush(stdout);
+        outputDescriptor = dup(1);
+        dup2(2, 1);
+
+#ifdef _WIN32
+        _setmode(outputDescriptor, _O_BINARY);
+#endif
+    }
+    else
+    {
+        output = fopen(outputFile, "wb");
+        if (output == NULL)
+        {
+            printf("Failed to open %s\n", outputFile);
+            return 1;
+        }
+
+        outputDescriptor = fileno(output);
+    }
+
+    initChip8(&chip8Emulator);
+    if (!loadChip8(romFile, &chip8Emulator))
+        return 1;
+
+    initChip8FusedEngine(&fusedEngine);
+
+    if (cacheDir != NULL)
+    {
+        pristine = chip8Emulator;
+
+        cacheLoaded = loadChip8TranslationCache(&translationCache, &pristine, cacheDir);
+
+        if (cacheLoaded)
+            warmChip8FusedEngine(&fusedEngine, &translationCache);
+        else
+            initChip8TranslationCache(&translationCache);
+    }
+
+    chip8FrameWriter writer;
+    if (outputDescriptor >= 0 && !openChip8FrameWriter(&writer, outputDescriptor, format, bitsPerPixel, scale, findColourScheme(scheme)))
+        return 1;
+
+    if (logFile != NULL && !openChip8FrameLogWriter(&frameLog, logFile, (unsigned int)keyframeInterval))
+        return 1;
+
+    int exitCode = 0;
+
+    for (long frame = 0; frame < frames; frame++)
+    {
+        if (runChip8Fused(&fusedEngine, &chip8Emulator, cyclesPerFrame) != CHIP8_OK)
+        {
+            printf("ROM trapped (%s) at %.3X: opcode %.4X after %ld frames\n",
+                describeChip8Status(chip8Emulator.trap), chip8Emulator.trapAddress, chip8Emulator.trapOpcode, frame);
+            exitCode = 1;
+            break;
+        }
+
+        updateChip8Timers(&chip8Emulator);
+
+        if (outputDescriptor >= 0 && !writeChip8Frame(&writer, &chip8Emulator))
+        {
+            printf("Failed to write frame %ld\n", frame);
+            exitCode = 1;
+            break;
+        }
+
+        if (logFile != NULL && !appendChip8FrameLog(&frameLog, chip8Emulator.pixels))
+        {
+            printf("Failed to log frame %ld\n", frame);
+            exitCode = 1;
+            break;
+        }
+    }
+
+    if (outputDescriptor >= 0)
+        closeChip8FrameWriter(&writer);
+
+    if (logFile != NULL && !closeChip8FrameLogWriter(&frameLog))
+    {
+        printf("Failed to finish writing %s\n", logFile);
+        exitCode = 1;
+    }
+
+    if (output != NULL)
+        fclose(output);
+
+    if (cacheDir != NULL)
+    {
+        // a warm run that reached no new code leaves the cache as it is
+        int added = captureChip8TranslationCache(&translationCache, &fusedEngine, &pristine);
+
+        if ((added > 0 || !cacheLoaded) && !saveChip8TranslationCache(&translationCache, &pristine, cacheDir))
+            printf("Failed to save the translation cache in %s\n", cacheDir);
+    }
+
+    return exitCode;
+}
@@ -0,0 +1,110 @@
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chip8.h"
+#include "fused.h"
+#include "vecenv.h"
+
+/*
+    hosts a vectorized environment (see vecenv.h) for a ROM until a learner sends it a shutdown command or the
+    process is interrupted. every instance starts from the state right after the ROM was loaded. with --cache-dir,
+    what the instances decode is kept in a translation cache (see fused.h) for the next time the ROM is served
+*/
+
+#define DEFAULT_ENVS             16
+#define DEFAULT_CYCLES_PER_FRAME 8
+
+chip8VecEnvServer server;
+chip8TranslationCache translationCache;
+bool cacheLoaded = false;
+
+// stops the server loop, which then removes the shared memory on its way out
+void stopServer(int signalNumber)
+{
+    (void)signalNumber;
+
+    if (server.header != NULL)
+        atomic_store(&server.header->serverRunning, 0);
+}
+
+int main(int argc, char** argv)
+{
+    const char* romFile    = NULL;
+    const char* name       = "chip8-env";
+    long envs              = DEFAULT_ENVS;
+    long frameSkip         = 1;
+    long cyclesPerFrame    = DEFAULT_CYCLES_PER_FRAME;
+    bool observeRegisters  = false;
+    const char* cacheDir   = NULL;
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if (strncmp(argv[arg], "--name=", 7) == 0)
+            name = argv[arg] + 7;
+        else if (strncmp(argv[arg], "--envs=", 7) == 0)
+            envs = atol(argv[arg] + 7);
+        else if (strncmp(argv[arg], "--frame-skip=", 13) == 0)
+            frameSkip = atol(argv[arg] + 13);
+        else if (strncmp(argv[arg], "--cycles-per-frame=", 19) == 0)
+            cyclesPerFrame = atol(argv[arg] + 19);
+        else if (strcmp(argv[arg], "--registers") == 0)
+            observeRegisters = true;
+        else if (strncmp(argv[arg], "--cache-dir=", 12) == 0)
+            cacheDir = argv[arg] + 12;
+        else
+            romFile = argv[arg];
+    }
+
+    if (romFile == NULL || envs < 1 || frameSkip < 1 || cyclesPerFrame < 1)
+    {
+        printf("Usage is: chip8-envd <ROM file> [--name=<shared memory name>] [--envs=<n>] [--frame-skip=<k>]\n");
+        printf("                     [--cycles-per-frame=<n>] [--registers] [--cache-dir=<directory>]\n");
+        return 1;
+    }
+
+    chip8 snapshot;
+    initChip8(&snapshot);
+
+    if (!loadChip8(romFile, &snapshot))
+        return 1;
+
+    if (!createChip8VecEnv(&server, name, &snapshot, (unsigned int)envs, (unsigned int)frameSkip, (unsigned int)cyclesPerFrame, observeRegisters))
+        return 1;
+
+    if (cacheDir != NULL)
+    {
+        cacheLoaded = loadChip8TranslationCache(&translationCache, &snapshot, cacheDir);
+
+        if (!cacheLoaded)
+            initChip8TranslationCache(&translationCache);
+
+        useChip8VecEnvTranslationCache(&server, &translationCache);
+    }
+
+    signal(SIGINT, stopServer);
+    signal(SIGTERM, stopServer);
+
+    printf("Serving %ld instances of %s as %s\n", envs, romFile, name);
+    fflush(stdout);
+
+    runChip8VecEnvServer(&server);
+
+    if (cacheDir != NULL)
+    {
+        // a warm run that reached no new code leaves the cache as it is
+        int added = 0;
+        for (long env = 0; env < envs; env++)
+            added += captureChip8TranslationCache(&translationCache, &server.engines[env], &snapshot);
+
+        if ((added > 0 || !cacheLoaded) && !saveChip8TranslationCache(&translationCache, &snapshot, cacheDir))
+            printf("Failed to save the translation cache in %s\n", cacheDir);
+    }
+
+    destroyChip8VecEnv(&server);
+
+    printf("Stopped\n");
+    return 0;
+}
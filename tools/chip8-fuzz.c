@@ -0,0 +1,187 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chip8.h"
+#include "fused.h"
+
+/*
+    an in-process fuzzing harness. each input is loaded as a ROM and run through every execution engine for a
+    fixed number of cycles, starting from the same pre-initialized snapshot, and the resulting states must match.
+    every input is run twice, following none of the quirks and then all of them
+
+    built with -DCHIP8_LIBFUZZER this provides LLVMFuzzerTestOneInput for libFuzzer. built with afl-clang-fast it
+    runs in AFL's persistent mode. otherwise it is a standalone driver that replays the files given on the command line
+*/
+
+// the number of 60Hz frames each input is run for, and the cycles per frame (500Hz / 60Hz, rounded)
+#ifndef FUZZ_FRAMES
+    #define FUZZ_FRAMES 64
+#endif
+#define FUZZ_CYCLES_PER_FRAME 8
+
+#define PROGRAM_START    0x200
+#define MAX_PROGRAM_SIZE (4096 - PROGRAM_START)
+
+typedef chip8Status (*chip8Engine)(chip8* chip8ptr, unsigned long long cycles);
+
+chip8FusedEngine fusedEngine;
+
+chip8Status runFused(chip8* chip8ptr, unsigned long long cycles)
+{
+    return runChip8Fused(&fusedEngine, chip8ptr, cycles);
+}
+
+// forgets everything the fused engine decoded from the previous input
+void resetFused()
+{
+    resetChip8FusedEngine(&fusedEngine);
+}
+
+// the switch interpreter is the reference that every other engine is checked against
+struct engine
+{
+    const char* name;
+    chip8Engine run;
+    void (*reset)(); // called before each input, if the engine keeps any state of its own
+} engines[] =
+{
+    { "interpreter", runChip8Cycles, NULL },
+    { "fused",       runFused,       resetFused },
+};
+
+#define NUM_OF_ENGINES (sizeof(engines) / sizeof(engines[0]))
+
+// the state every input starts from, set up once so that each input is reset with a memcpy
+chip8 snapshot;
+bool snapshotReady = false;
+
+chip8 instances[NUM_OF_ENGINES];
+
+const unsigned int quirkProfiles[] =
+{
+    0,
+    QUIRK_SHIFT_USES_VY | QUIRK_LOAD_STORE_ADVANCE_I | QUIRK_JUMP_USES_VX | QUIRK_SPRITES_WRAP | QUIRK_LOGIC_RESETS_VF,
+};
+
+#define NUM_OF_QUIRK_PROFILES (sizeof(quirkProfiles) / sizeof(quirkProfiles[0]))
+
+// returns the name of the first part of the state that differs between a and b, or NULL if they match
+const char* compareChip8State(const chip8* a, const chip8* b)
+{
+    if (a->programCounter != b->programCounter) return "programCounter";
+    if (a->indexRegister != b->indexRegister)   return "indexRegister";
+    if (a->stackPointer != b->stackPointer)     return "stackPointer";
+    if (a->carryRegister != b->carryRegister)   return "carryRegister";
+    if (a->delayTimer != b->delayTimer)         return "delayTimer";
+    if (a->soundTimer != b->soundTimer)         return "soundTimer";
+    if (a->randomState != b->randomState)       return "randomState";
+    if (a->trap != b->trap)                     return "trap";
+    if (a->trapAddress != b->trapAddress)       return "trapAddress";
+    if (a->trapOpcode != b->trapOpcode)         return "trapOpcode";
+    if (a->drawFlag != b->drawFlag)             return "drawFlag";
+    if (a->soundFlag != b->soundFlag)           return "soundFlag";
+
+    if (memcmp(a->registers, b->registers, sizeof(a->registers)) != 0) return "registers";
+    if (memcmp(a->stack, b->stack, sizeof(a->stack)) != 0)             return "stack";
+    if (memcmp(a->memory, b->memory, sizeof(a->memory)) != 0)          return "memory";
+    if (memcmp(a->pixels, b->pixels, sizeof(a->pixels)) != 0)          return "pixels";
+
+    return NULL;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    if (!snapshotReady)
+    {
+        initChip8(&snapshot);
+        initChip8FusedEngine(&fusedEngine);
+
+        // a fixed seed keeps every run of an input reproducible
+        snapshot.randomState = 0x2545F491;
+        snapshotReady = true;
+    }
+
+    if (size > MAX_PROGRAM_SIZE)
+        size = MAX_PROGRAM_SIZE;
+
+    for (size_t profile = 0; profile < NUM_OF_QUIRK_PROFILES; profile++)
+    {
+        for (size_t e = 0; e < NUM_OF_ENGINES; e++)
+        {
+            chip8* instance = &instances[e];
+
+            memcpy(instance, &snapshot, sizeof(chip8));
+            memcpy(&instance->memory[PROGRAM_START], data, size);
+            instance->quirks = quirkProfiles[profile];
+
+            if (engines[e].reset != NULL)
+                engines[e].reset();
+
+            for (int frame = 0; frame < FUZZ_FRAMES && instance->trap == CHIP8_OK; frame++)
+            {
+                engines[e].run(instance, FUZZ_CYCLES_PER_FRAME);
+                updateChip8Timers(instance);
+            }
+
+            const char* difference = e > 0 ? compareChip8State(&instances[0], instance) : NULL;
+            if (difference != NULL)
+            {
+                printf("Engine \"%s\" disagrees with \"%s\" about %s (quirks %X)\n", engines[e].name, engines[0].name,
+                       difference, quirkProfiles[profile]);
+                fflush(stdout);
+                abort();
+            }
+        }
+    }
+
+    return 0;
+}
+
+#ifndef CHIP8_LIBFUZZER
+
+static uint8_t input[MAX_PROGRAM_SIZE];
+
+#ifdef __AFL_HAVE_MANUAL_CONTROL
+
+// AFL's persistent mode: many inputs are read from stdin by the same process
+int main()
+{
+    while (__AFL_LOOP(100000))
+    {
+        size_t size = fread(input, 1, sizeof(input), stdin);
+        LLVMFuzzerTestOneInput(input, size);
+    }
+
+    return 0;
+}
+
+#else
+
+// replays each of the files given on the command line
+int main(int argc, char** argv)
+{
+    for (int arg = 1; arg < argc; arg++)
+    {
+        FILE* inputFile = fopen(argv[arg], "rb");
+        if (inputFile == NULL)
+        {
+            printf("Failed to open %s\n", argv[arg]);
+            return 1;
+        }
+
+        size_t size = fread(input, 1, sizeof(input), inputFile);
+        fclose(inputFile);
+
+        LLVMFuzzerTestOneInput(input, size);
+        printf("%s: ok\n", argv[arg]);
+    }
+
+    return 0;
+}
+
+#endif
+
+#endif
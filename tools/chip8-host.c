@@ -0,0 +1,131 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chip8.h"
+#include "platform.h"
+#include "scheduler.h"
+
+/*
+    runs many instances of a ROM on the scheduler (see scheduler.h) for a while, and reports whether they kept up with
+    their frame rate. every instance starts from the state right after the ROM was loaded, with its own random seed.
+    with --press-every, each instance has a key pressed and released on that interval, so ROMs waiting on FX0A move on
+*/
+
+#define DEFAULT_INSTANCES        256
+#define DEFAULT_CYCLES_PER_FRAME 8
+#define DEFAULT_CYCLES_PER_SLICE 4
+#define DEFAULT_SECONDS          5
+
+chip8Scheduler scheduler;
+
+int main(int argc, char** argv)
+{
+    const char* romFile   = NULL;
+    long instances        = DEFAULT_INSTANCES;
+    long workers          = 0;
+    long cyclesPerFrame   = DEFAULT_CYCLES_PER_FRAME;
+    long cyclesPerSlice   = DEFAULT_CYCLES_PER_SLICE;
+    long framesPerSecond  = DEFAULT_SCHEDULER_FRAMES_PER_SECOND;
+    long seconds          = DEFAULT_SECONDS;
+    long pressEvery       = 0;
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if (strncmp(argv[arg], "--instances=", 12) == 0)
+            instances = atol(argv[arg] + 12);
+        else if (strncmp(argv[arg], "--workers=", 10) == 0)
+            workers = atol(argv[arg] + 10);
+        else if (strncmp(argv[arg], "--cycles-per-frame=", 19) == 0)
+            cyclesPerFrame = atol(argv[arg] + 19);
+        else if (strncmp(argv[arg], "--slice=", 8) == 0)
+            cyclesPerSlice = atol(argv[arg] + 8);
+        else if (strncmp(argv[arg], "--fps=", 6) == 0)
+            framesPerSecond = atol(argv[arg] + 6);
+        else if (strncmp(argv[arg], "--seconds=", 10) == 0)
+            seconds = atol(argv[arg] + 10);
+        else if (strncmp(argv[arg], "--press-every=", 14) == 0)
+            pressEvery = atol(argv[arg] + 14);
+        else
+            romFile = argv[arg];
+    }
+
+    // one worker per processor by default
+    if (workers == 0)
+        workers = getProcessorCount();
+
+    if (romFile == NULL || instances < 1 || workers < 1 || cyclesPerFrame < 1 || cyclesPerSlice < 1 || framesPerSecond < 1 ||
+        seconds < 1 || pressEvery < 0)
+    {
+        printf("Usage is: chip8-host <ROM file> [--instances=<n>] [--workers=<n>] [--cycles-per-frame=<n>] [--slice=<n>]\n");
+        printf("                     [--fps=<n>] [--seconds=<n>] [--press-every=<milliseconds>]\n");
+        return 1;
+    }
+
+    chip8 snapshot;
+    initChip8(&snapshot);
+
+    if (!loadChip8(romFile, &snapshot))
+        return 1;
+
+    if (!createChip8Scheduler(&scheduler, (int)instances, (int)workers, (unsigned int)cyclesPerFrame, (unsigned int)cyclesPerSlice,
+                              (unsigned int)framesPerSecond))
+        return 1;
+
+    for (long instance = 0; instance < instances; instance++)
+    {
+        chip8 initial = snapshot;
+        initial.randomState = 0x9E3779B9u * (unsigned int)(instance + 1) | 1;
+        addChip8Instance(&scheduler, &initial);
+    }
+
+    printf("Running %ld instances of %s on %ld workers for %ld seconds\n", instances, romFile, workers, seconds);
+    fflush(stdout);
+
+    double start = getTimeMilliseconds();
+
+    if (!startChip8Scheduler(&scheduler))
+    {
+        destroyChip8Scheduler(&scheduler);
+        return 1;
+    }
+
+    bool pressed = false;
+    while (getTimeMilliseconds() - start < seconds * 1000.0)
+    {
+        if (pressEvery == 0)
+        {
+            sleepMilliseconds(100);
+            continue;
+        }
+
+        sleepMilliseconds((int)pressEvery);
+
+        pressed = !pressed;
+        for (long instance = 0; instance < instances; instance++)
+            setChip8InstanceKey(&scheduler, (int)instance, 0x5, pressed);
+    }
+
+    stopChip8Scheduler(&scheduler);
+    double elapsed = (getTimeMilliseconds() - start) / 1000.0;
+
+    chip8SchedulerStats stats;
+    getChip8SchedulerStats(&scheduler, &stats);
+
+    unsigned long long expectedFrames = (unsigned long long)(elapsed * framesPerSecond) * instances;
+    unsigned long long frames = stats.frames + stats.sleptFrames;
+
+    printf("Frames:           %llu of %llu expected (%.1f%%)\n", frames, expectedFrames,
+           expectedFrames > 0 ? 100.0 * frames / expectedFrames : 0.0);
+    printf("Frames run:       %llu (%.0f per second)\n", stats.frames, stats.frames / elapsed);
+    printf("Frames slept:     %llu\n", stats.sleptFrames);
+    printf("Missed deadlines: %llu (%.2f%% of the frames run)\n", stats.missedDeadlines,
+           stats.frames > 0 ? 100.0 * stats.missedDeadlines / stats.frames : 0.0);
+    printf("Slices:           %llu\n", stats.slices);
+    printf("Parks:            %llu (%d parked on a key at the end)\n", stats.parks, stats.parkedOnKey);
+    printf("Trapped:          %d\n", stats.trapped);
+
+    destroyChip8Scheduler(&scheduler);
+    return 0;
+}
@@ -0,0 +1,229 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rompack.h"
+
+/*
+    builds and inspects ROM packs (see rompack.h)
+
+    usage: chip8-pack create <pack> <manifest>
+        the manifest lists one ROM per line, with optional settings after it:
+            <ROM file> [name=<name>] [speed=<instructions per second>] [quirks=<quirk>,...] [keys=<16 keys>]
+        the name defaults to the file's name, and lines starting with # are ignored
+    usage: chip8-pack list <pack>
+    usage: chip8-pack find <pack> <name, or hash in hex>
+*/
+
+#define DEFAULT_INSTRUCTIONS_PER_SECOND 500
+#define MAX_PACK_ROMS 65536
+
+struct quirkName
+{
+    const char* name;
+    uint32_t quirk;
+} quirkNames[] =
+{
+    { "shift",     QUIRK_SHIFT_USES_VY },
+    { "loadstore", QUIRK_LOAD_STORE_ADVANCE_I },
+    { "jump",      QUIRK_JUMP_USES_VX },
+    { "wrap",      QUIRK_SPRITES_WRAP },
+    { "vfreset",   QUIRK_LOGIC_RESETS_VF },
+};
+
+#define NUM_OF_QUIRK_NAMES (int)(sizeof(quirkNames) / sizeof(quirkNames[0]))
+
+bool parseQuirks(char* list, uint32_t* quirks)
+{
+    for (char* quirk = strtok(list, ","); quirk != NULL; quirk = strtok(NULL, ","))
+    {
+        int q = 0;
+        while (q < NUM_OF_QUIRK_NAMES && strcmp(quirk, quirkNames[q].name) != 0)
+            q++;
+
+        if (q == NUM_OF_QUIRK_NAMES)
+        {
+            printf("Unknown quirk %s\n", quirk);
+            return false;
+        }
+
+        *quirks |= quirkNames[q].quirk;
+    }
+
+    return true;
+}
+
+// reads a whole ROM file into a new buffer, returning NULL if it can't be read or doesn't fit in memory
+Byte* readROMFile(const char* path, size_t* length)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        printf("Failed to open %s\n", path);
+        return NULL;
+    }
+
+    Byte* data = (Byte*)malloc(MAX_ROM_SIZE + 1);
+    *length = data != NULL ? fread(data, 1, MAX_ROM_SIZE + 1, file) : 0;
+
+    bool failed = ferror(file) != 0;
+    fclose(file);
+
+    if (data == NULL || failed || *length == 0 || *length > MAX_ROM_SIZE)
+    {
+        printf("%s is empty, unreadable or too big to load into chip8's 4k memory\n", path);
+        free(data);
+        return NULL;
+    }
+
+    return data;
+}
+
+int createPack(const char* packFile, const char* manifestFile)
+{
+    FILE* manifest = fopen(manifestFile, "r");
+    if (manifest == NULL)
+    {
+        printf("Failed to open %s\n", manifestFile);
+        return 1;
+    }
+
+    chip8ROMPackInput* roms = (chip8ROMPackInput*)calloc(MAX_PACK_ROMS, sizeof(chip8ROMPackInput));
+    char (*names)[256] = (char(*)[256])calloc(MAX_PACK_ROMS, 256);
+    unsigned int numOfROMs = 0;
+    bool failed = roms == NULL || names == NULL;
+
+    char line[1024];
+    while (!failed && fgets(line, sizeof(line), manifest) != NULL)
+    {
+        char* word = strtok(line, " \t\r\n");
+        if (word == NULL || word[0] == '#')
+            continue;
+
+        if (numOfROMs == MAX_PACK_ROMS)
+        {
+            printf("A pack can hold at most %d ROMs\n", MAX_PACK_ROMS);
+            failed = true;
+            break;
+        }
+
+        chip8ROMPackInput* rom = &roms[numOfROMs];
+
+        // the name defaults to the file name without its directory
+        const char* baseName = word;
+        for (const char* c = word; *c != '\0'; c++)
+        {
+            if (*c == '/' || *c == '\\')
+                baseName = c + 1;
+        }
+
+        snprintf(names[numOfROMs], sizeof(names[numOfROMs]), "%s", baseName);
+        rom->name = names[numOfROMs];
+        rom->instructionsPerSecond = DEFAULT_INSTRUCTIONS_PER_SECOND;
+        memcpy(rom->keyMap, DEFAULT_KEY_MAP, sizeof(rom->keyMap));
+
+        rom->data = readROMFile(word, &rom->length);
+        failed = rom->data == NULL;
+        numOfROMs++;
+
+        while (!failed && (word = strtok(NULL, " \t\r\n")) != NULL)
+        {
+            if (strncmp(word, "name=", 5) == 0)
+                snprintf(names[numOfROMs - 1], sizeof(names[numOfROMs - 1]), "%s", word + 5);
+            else if (strncmp(word, "speed=", 6) == 0)
+                rom->instructionsPerSecond = (uint32_t)strtoul(word + 6, NULL, 10);
+            else if (strncmp(word, "quirks=", 7) == 0)
+                failed = !parseQuirks(word + 7, &rom->quirks);
+            else if (strncmp(word, "keys=", 5) == 0 && strlen(word + 5) == 16)
+                memcpy(rom->keyMap, word + 5, sizeof(rom->keyMap));
+            else
+            {
+                printf("Unknown setting %s for %s\n", word, rom->name);
+                failed = true;
+            }
+        }
+    }
+
+    fclose(manifest);
+
+    if (!failed)
+        failed = !writeChip8ROMPack(packFile, roms, numOfROMs);
+
+    if (!failed)
+        printf("Packed %u ROMs into %s\n", numOfROMs, packFile);
+
+    for (unsigned int rom = 0; roms != NULL && rom < numOfROMs; rom++)
+        free((void*)roms[rom].data);
+
+    free(roms);
+    free(names);
+
+    return failed ? 1 : 0;
+}
+
+void printEntry(const chip8ROMPack* pack, const chip8ROMEntry* entry)
+{
+    printf("%016" PRIx64 " %5u bytes %5u Hz keys=%.16s quirks=", entry->hash, entry->dataLength, entry->instructionsPerSecond, entry->keyMap);
+
+    const char* separator = "";
+    for (int q = 0; q < NUM_OF_QUIRK_NAMES; q++)
+    {
+        if (entry->quirks & quirkNames[q].quirk)
+        {
+            printf("%s%s", separator, quirkNames[q].name);
+            separator = ",";
+        }
+    }
+
+    printf(" %s\n", getChip8ROMName(pack, entry));
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 4 && strcmp(argv[1], "create") == 0)
+        return createPack(argv[2], argv[3]);
+
+    bool list = argc == 3 && strcmp(argv[1], "list") == 0;
+    bool find = argc == 4 && strcmp(argv[1], "find") == 0;
+
+    if (!list && !find)
+    {
+        printf("Usage is: chip8-pack create <pack> <manifest>\n");
+        printf("          chip8-pack list <pack>\n");
+        printf("          chip8-pack find <pack> <name, or hash in hex>\n");
+        return 1;
+    }
+
+    chip8ROMPack pack;
+    if (!openChip8ROMPack(&pack, argv[2]))
+        return 1;
+
+    int exitCode = 0;
+
+    if (list)
+    {
+        for (uint32_t rom = 0; rom < pack.header->numOfROMs; rom++)
+            printEntry(&pack, &pack.entries[rom]);
+    }
+    else
+    {
+        const chip8ROMEntry* entry = findChip8ROMByName(&pack, argv[3]);
+
+        char* end;
+        uint64_t hash = strtoull(argv[3], &end, 16);
+        if (entry == NULL && *end == '\0')
+            entry = findChip8ROMByHash(&pack, hash);
+
+        if (entry != NULL)
+            printEntry(&pack, entry);
+        else
+        {
+            printf("No ROM named or hashed %s\n", argv[3]);
+            exitCode = 1;
+        }
+    }
+
+    closeChip8ROMPack(&pack);
+    return exitCode;
+}
@@ -0,0 +1,206 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <fcntl.h>
+    #include <io.h>
+    #define dup  _dup
+    #define dup2 _dup2
+#else
+    #include <unistd.h>
+#endif
+
+#include "chip8.h"
+#include "colours.h"
+#include "framedump.h"
+#include "framelog.h"
+
+/*
+    plays back a frame log recorded by the frontend (--record) or chip8-dump (--log). with no options it
+    describes the log, --show prints a single frame as text, and --export writes a range of frames through the
+    frame writer (so the same formats and options as chip8-dump apply), e.g.
+
+        chip8-play session.c8fl --export=- --from=36000 --scale=8 | ffplay -
+*/
+
+chip8FrameLogReader frameLog;
+
+// the frame writer draws from an instance's pixels, so exported frames are unpacked into one
+chip8 display;
+
+void printUsage()
+{
+    printf("Usage is: chip8-play <frame log> [--show=<frame>]\n");
+    printf("          chip8-play <frame log> --export=<output file, or - for stdout> [--from=<frame>] [--frames=<n>]\n");
+    printf("                     [--format=y4m|raw] [--bits=8|1] [--scale=<n>] [--scheme=<colour scheme>]\n");
+}
+
+void describeFrameLog(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    long size = 0;
+
+    if (file != NULL)
+    {
+        fseek(file, 0L, SEEK_END);
+        size = ftell(file);
+        fclose(file);
+    }
+
+    // the size of the same frames stored as snapshots of pixels[]
+    double rawSize = (double)frameLog.numOfFrames * sizeof(display.pixels);
+
+    printf("%u frames (%.1f seconds at 60Hz), a keyframe every %u frames\n",
+        frameLog.numOfFrames, frameLog.numOfFrames / 60.0, frameLog.keyframeInterval);
+    printf("%ld bytes (%.0fx smaller than raw pixel snapshots)\n", size, size > 0 ? rawSize / size : 0.0);
+}
+
+void showFrame(unsigned int frame)
+{
+    unpackChip8Frame(frameLog.frame, display.pixels);
+    printf("frame %u:\n", frame);
+
+    for (int y = 0; y < 32; y++)
+    {
+        char row[64 + 1];
+
+        for (int x = 0; x < 64; x++)
+            row[x] = display.pixels[x + y * 64] ? '#' : '.';
+
+        row[64] = '\0';
+        printf("%s\n", row);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* logFile    = NULL;
+    const char* exportFile = NULL;
+    long show              = -1;
+    long from              = 0;
+    long frames            = -1;
+    frameFormat format     = FRAME_FORMAT_Y4M;
+    const char* scheme     = "default";
+    int bitsPerPixel       = 8;
+    int scale              = 1;
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if (strncmp(argv[arg], "--show=", 7) == 0)
+            show = atol(argv[arg] + 7);
+        else if (strncmp(argv[arg], "--export=", 9) == 0)
+            exportFile = argv[arg] + 9;
+        else if (strncmp(argv[arg], "--from=", 7) == 0)
+            from = atol(argv[arg] + 7);
+        else if (strncmp(argv[arg], "--frames=", 9) == 0)
+            frames = atol(argv[arg] + 9);
+        else if (strcmp(argv[arg], "--format=y4m") == 0)
+            format = FRAME_FORMAT_Y4M;
+        else if (strcmp(argv[arg], "--format=raw") == 0)
+            format = FRAME_FORMAT_RAW;
+        else if (strncmp(argv[arg], "--bits=", 7) == 0)
+            bitsPerPixel = atoi(argv[arg] + 7);
+        else if (strncmp(argv[arg], "--scale=", 8) == 0)
+            scale = atoi(argv[arg] + 8);
+        else if (strncmp(argv[arg], "--scheme=", 9) == 0)
+            scheme = argv[arg] + 9;
+        else if (strncmp(argv[arg], "--", 2) == 0)
+        {
+            printf("Unknown option %s\n", argv[arg]);
+            printUsage();
+            return 1;
+        }
+        else
+            logFile = argv[arg];
+    }
+
+    if (logFile == NULL || from < 0)
+    {
+        printUsage();
+        return 1;
+    }
+
+    int outputDescriptor = -1;
+    FILE* output = NULL;
+
+    if (exportFile != NULL && strcmp(exportFile, "-") == 0)
+    {
+        // the frames get stdout to themselves, and everything that would have been printed goes to stderr instead
+        fflush(stdout);
+        outputDescriptor = dup(1);
+        dup2(2, 1);
+
+#ifdef _WIN32
+        _setmode(outputDescriptor, _O_BINARY);
+#endif
+    }
+    else if (exportFile != NULL)
+    {
+        output = fopen(exportFile, "wb");
+        if (output == NULL)
+        {
+            printf("Failed to open %s\n", exportFile);
+            return 1;
+        }
+
+        outputDescriptor = fileno(output);
+    }
+
+    if (!openChip8FrameLogReader(&frameLog, logFile))
+        return 1;
+
+    int exitCode = 0;
+
+    if (show >= 0)
+    {
+        if (seekChip8FrameLog(&frameLog, (unsigned int)show))
+            showFrame((unsigned int)show);
+        else
+        {
+            printf("Failed to read frame %ld of %u\n", show, frameLog.numOfFrames);
+            exitCode = 1;
+        }
+    }
+    else if (outputDescriptor >= 0)
+    {
+        chip8FrameWriter writer;
+        if (!openChip8FrameWriter(&writer, outputDescriptor, format, bitsPerPixel, scale, findColourScheme(scheme)))
+            return 1;
+
+        unsigned long long last = frames < 0 ? frameLog.numOfFrames : (unsigned long long)from + frames;
+        if (last > frameLog.numOfFrames)
+            last = frameLog.numOfFrames;
+
+        for (unsigned long long frame = from; frame < last; frame++)
+        {
+            if (!seekChip8FrameLog(&frameLog, (unsigned int)frame))
+            {
+                printf("Failed to read frame %llu\n", frame);
+                exitCode = 1;
+                break;
+            }
+
+            unpackChip8Frame(frameLog.frame, display.pixels);
+
+            if (!writeChip8Frame(&writer, &display))
+            {
+                printf("Failed to write frame %llu\n", frame);
+                exitCode = 1;
+                break;
+            }
+        }
+
+        closeChip8FrameWriter(&writer);
+    }
+    else
+        describeFrameLog(logFile);
+
+    closeChip8FrameLogReader(&frameLog);
+
+    if (output != NULL)
+        fclose(output);
+
+    return exitCode;
+}